@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/WeatherBot.dir/src/main.cpp.o"
+  "CMakeFiles/WeatherBot.dir/src/main.cpp.o.d"
+  "WeatherBot"
+  "WeatherBot.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/WeatherBot.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,45 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/AlertDispatcher.cpp" "CMakeFiles/weatherbot_core.dir/src/AlertDispatcher.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/AlertDispatcher.cpp.o.d"
+  "/root/repo/src/AlertEngine.cpp" "CMakeFiles/weatherbot_core.dir/src/AlertEngine.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/AlertEngine.cpp.o.d"
+  "/root/repo/src/BatchRunner.cpp" "CMakeFiles/weatherbot_core.dir/src/BatchRunner.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/BatchRunner.cpp.o.d"
+  "/root/repo/src/CircuitBreaker.cpp" "CMakeFiles/weatherbot_core.dir/src/CircuitBreaker.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/CircuitBreaker.cpp.o.d"
+  "/root/repo/src/CommandParser.cpp" "CMakeFiles/weatherbot_core.dir/src/CommandParser.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/CommandParser.cpp.o.d"
+  "/root/repo/src/ConfigStore.cpp" "CMakeFiles/weatherbot_core.dir/src/ConfigStore.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/ConfigStore.cpp.o.d"
+  "/root/repo/src/ConnectionManager.cpp" "CMakeFiles/weatherbot_core.dir/src/ConnectionManager.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/ConnectionManager.cpp.o.d"
+  "/root/repo/src/EventLoop.cpp" "CMakeFiles/weatherbot_core.dir/src/EventLoop.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/EventLoop.cpp.o.d"
+  "/root/repo/src/ForecastStore.cpp" "CMakeFiles/weatherbot_core.dir/src/ForecastStore.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/ForecastStore.cpp.o.d"
+  "/root/repo/src/Gazetteer.cpp" "CMakeFiles/weatherbot_core.dir/src/Gazetteer.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/Gazetteer.cpp.o.d"
+  "/root/repo/src/HistoryStore.cpp" "CMakeFiles/weatherbot_core.dir/src/HistoryStore.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/HistoryStore.cpp.o.d"
+  "/root/repo/src/MappedFile.cpp" "CMakeFiles/weatherbot_core.dir/src/MappedFile.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/MappedFile.cpp.o.d"
+  "/root/repo/src/Metrics.cpp" "CMakeFiles/weatherbot_core.dir/src/Metrics.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/Metrics.cpp.o.d"
+  "/root/repo/src/NotificationManager.cpp" "CMakeFiles/weatherbot_core.dir/src/NotificationManager.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/NotificationManager.cpp.o.d"
+  "/root/repo/src/PrefetchScheduler.cpp" "CMakeFiles/weatherbot_core.dir/src/PrefetchScheduler.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/PrefetchScheduler.cpp.o.d"
+  "/root/repo/src/ProviderRouter.cpp" "CMakeFiles/weatherbot_core.dir/src/ProviderRouter.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/ProviderRouter.cpp.o.d"
+  "/root/repo/src/RateLimiter.cpp" "CMakeFiles/weatherbot_core.dir/src/RateLimiter.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/RateLimiter.cpp.o.d"
+  "/root/repo/src/ReportRenderer.cpp" "CMakeFiles/weatherbot_core.dir/src/ReportRenderer.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/ReportRenderer.cpp.o.d"
+  "/root/repo/src/RequestCoalescer.cpp" "CMakeFiles/weatherbot_core.dir/src/RequestCoalescer.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/RequestCoalescer.cpp.o.d"
+  "/root/repo/src/SnapshotStore.cpp" "CMakeFiles/weatherbot_core.dir/src/SnapshotStore.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/SnapshotStore.cpp.o.d"
+  "/root/repo/src/SymbolTable.cpp" "CMakeFiles/weatherbot_core.dir/src/SymbolTable.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/SymbolTable.cpp.o.d"
+  "/root/repo/src/WeatherBot.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherBot.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherBot.cpp.o.d"
+  "/root/repo/src/WeatherCache.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherCache.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherCache.cpp.o.d"
+  "/root/repo/src/WeatherJsonParser.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherJsonParser.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherJsonParser.cpp.o.d"
+  "/root/repo/src/WeatherProvider.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherProvider.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherProvider.cpp.o.d"
+  "/root/repo/src/WeatherServer.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherServer.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherServer.cpp.o.d"
+  "/root/repo/src/WeatherService.cpp" "CMakeFiles/weatherbot_core.dir/src/WeatherService.cpp.o" "gcc" "CMakeFiles/weatherbot_core.dir/src/WeatherService.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,63 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_core.dir/src/AlertDispatcher.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/AlertDispatcher.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/AlertEngine.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/AlertEngine.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/BatchRunner.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/BatchRunner.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/CircuitBreaker.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/CircuitBreaker.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/CommandParser.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/CommandParser.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/ConfigStore.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/ConfigStore.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/ConnectionManager.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/ConnectionManager.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/EventLoop.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/EventLoop.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/ForecastStore.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/ForecastStore.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/Gazetteer.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/Gazetteer.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/HistoryStore.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/HistoryStore.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/MappedFile.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/MappedFile.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/Metrics.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/Metrics.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/NotificationManager.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/NotificationManager.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/PrefetchScheduler.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/PrefetchScheduler.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/ProviderRouter.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/ProviderRouter.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/RateLimiter.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/RateLimiter.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/ReportRenderer.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/ReportRenderer.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/RequestCoalescer.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/RequestCoalescer.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/SnapshotStore.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/SnapshotStore.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/SymbolTable.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/SymbolTable.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherBot.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherBot.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherCache.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherCache.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherJsonParser.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherJsonParser.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherProvider.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherProvider.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherServer.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherServer.cpp.o.d"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherService.cpp.o"
+  "CMakeFiles/weatherbot_core.dir/src/WeatherService.cpp.o.d"
+  "libweatherbot_core.a"
+  "libweatherbot_core.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_core.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
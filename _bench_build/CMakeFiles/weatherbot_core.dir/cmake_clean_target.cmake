@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libweatherbot_core.a"
+)
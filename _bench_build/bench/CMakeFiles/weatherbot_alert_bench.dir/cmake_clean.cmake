@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_alert_bench.dir/AlertBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_alert_bench.dir/AlertBenchmark.cpp.o.d"
+  "weatherbot_alert_bench"
+  "weatherbot_alert_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_alert_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
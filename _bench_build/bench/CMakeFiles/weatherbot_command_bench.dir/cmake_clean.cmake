@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_command_bench.dir/CommandBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_command_bench.dir/CommandBenchmark.cpp.o.d"
+  "weatherbot_command_bench"
+  "weatherbot_command_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_command_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
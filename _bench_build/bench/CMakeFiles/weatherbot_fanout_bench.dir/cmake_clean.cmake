@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_fanout_bench.dir/FanoutBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_fanout_bench.dir/FanoutBenchmark.cpp.o.d"
+  "weatherbot_fanout_bench"
+  "weatherbot_fanout_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_fanout_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
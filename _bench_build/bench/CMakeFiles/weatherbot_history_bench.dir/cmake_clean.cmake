@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_history_bench.dir/HistoryBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_history_bench.dir/HistoryBenchmark.cpp.o.d"
+  "weatherbot_history_bench"
+  "weatherbot_history_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_history_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
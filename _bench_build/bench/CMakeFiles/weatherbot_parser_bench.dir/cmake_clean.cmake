@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_parser_bench.dir/ParserBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_parser_bench.dir/ParserBenchmark.cpp.o.d"
+  "weatherbot_parser_bench"
+  "weatherbot_parser_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_parser_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_replay_bench.dir/ReplayBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_replay_bench.dir/ReplayBenchmark.cpp.o.d"
+  "weatherbot_replay_bench"
+  "weatherbot_replay_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_replay_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
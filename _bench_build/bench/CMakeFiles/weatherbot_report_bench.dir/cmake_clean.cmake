@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/weatherbot_report_bench.dir/ReportBenchmark.cpp.o"
+  "CMakeFiles/weatherbot_report_bench.dir/ReportBenchmark.cpp.o.d"
+  "weatherbot_report_bench"
+  "weatherbot_report_bench.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/weatherbot_report_bench.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
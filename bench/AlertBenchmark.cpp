@@ -0,0 +1,111 @@
+// Compares the scalar and AVX2 alert rule kernels on the same observations.
+//
+// Usage: weatherbot_alert_bench [locations] [rounds]
+
+#include "AlertEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t RULES_PER_METRIC = 8;
+
+void addRules(AlertEngine& engine) {
+    engine.addDefaultRules();
+    // A spread of thresholds so that each round raises and clears a mix of instances
+    for (size_t i = 0; i < RULES_PER_METRIC; ++i) {
+        float step = static_cast<float>(i);
+        engine.addRule(AlertRule{"", "", AlertMetric::TEMPERATURE, AlertComparison::ABOVE, AlertRuleKind::THRESHOLD,
+                                 5.0f + 3.0f * step, 1.0f, "warm"});
+        engine.addRule(AlertRule{"", "", AlertMetric::WIND_SPEED, AlertComparison::ABOVE, AlertRuleKind::THRESHOLD,
+                                 2.0f + 2.0f * step, 2.0f, "windy"});
+        engine.addRule(AlertRule{"", "", AlertMetric::HUMIDITY, AlertComparison::BELOW, AlertRuleKind::THRESHOLD,
+                                 20.0f + 10.0f * step, 5.0f, "dry"});
+    }
+}
+
+struct Timing {
+    double nanoseconds = 0.0;
+    std::vector<uint64_t> raised;  // Rule id and city index per raised event, in order
+};
+
+Timing run(AlertEngine& engine, const std::vector<std::string>& cities, size_t rounds, uint32_t seed) {
+    // Observations drift slowly as real ones do, so only a few instances change state per round
+    std::mt19937 random(seed);
+    std::normal_distribution<double> drift(0.0, 0.5);
+    std::vector<WeatherData> observations(cities.size());
+    for (size_t i = 0; i < cities.size(); ++i) {
+        observations[i].setCity(cities[i]);
+        observations[i].temperature = std::uniform_real_distribution<float>(-10.0f, 40.0f)(random);
+        observations[i].windSpeed = std::uniform_real_distribution<float>(0.0f, 20.0f)(random);
+        observations[i].humidity = std::uniform_real_distribution<float>(0.0f, 100.0f)(random);
+        observations[i].isValid = true;
+    }
+
+    Timing timing;
+    std::vector<AlertEvent> events;
+    for (size_t round = 0; round < rounds; ++round) {
+        for (auto& data : observations) {
+            data.temperature += drift(random);
+            data.windSpeed = std::max(0.0, data.windSpeed + drift(random));
+            data.humidity = std::min(100.0, std::max(0.0, data.humidity + 2.0 * drift(random)));
+            engine.update(data);
+        }
+
+        events.clear();
+        auto start = std::chrono::steady_clock::now();
+        engine.evaluate(events);
+        timing.nanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        for (const auto& event : events) {
+            uint64_t city = std::stoull(event.city.substr(5));
+            timing.raised.push_back((static_cast<uint64_t>(event.ruleId) << 32) | city);
+        }
+    }
+    return timing;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t locationCount = argc > 1 ? std::stoul(argv[1]) : 2000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    std::vector<std::string> cities;
+    for (size_t i = 0; i < locationCount; ++i) {
+        cities.push_back("City " + std::to_string(i));
+    }
+
+    AlertEngine scalar;
+    AlertEngine vectorized;
+    scalar.setForceScalar(true);
+    addRules(scalar);
+    addRules(vectorized);
+
+    // The first round builds the instance arrays; keep it out of the timings
+    run(scalar, cities, 1, 1);
+    run(vectorized, cities, 1, 1);
+
+    Timing scalarTiming = run(scalar, cities, rounds, 42);
+    Timing vectorTiming = run(vectorized, cities, rounds, 42);
+    bool identical = scalarTiming.raised == vectorTiming.raised;
+
+    size_t instances = scalar.getInstanceCount();
+    double scalarNs = scalarTiming.nanoseconds / static_cast<double>(rounds * instances);
+    double vectorNs = vectorTiming.nanoseconds / static_cast<double>(rounds * instances);
+
+    std::cout << "{\"benchmark\":\"alerts\",\"instances\":" << instances
+              << ",\"rounds\":" << rounds
+              << ",\"avx2\":" << (AlertEngine::hasAvx2() ? "true" : "false")
+              << ",\"scalar_ns_per_instance\":" << scalarNs
+              << ",\"dispatched_ns_per_instance\":" << vectorNs
+              << ",\"speedup\":" << scalarNs / vectorNs
+              << ",\"raised_events\":" << scalarTiming.raised.size()
+              << ",\"identical\":" << (identical ? "true" : "false") << "}" << std::endl;
+
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+// Compares the previous istringstream-based command parsing against
+// CommandParser on a mix of REPL commands, in commands per second and heap
+// allocations per command. Only parsing and verb dispatch are measured; the
+// handlers themselves are not run.
+//
+// Usage: weatherbot_command_bench [iterations]
+
+#include "CommandParser.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+volatile uint64_t sink = 0;
+
+const std::vector<std::string> COMMANDS = {
+    "weather London",
+    "w New   York",
+    "weather London; Paris; Tokyo",
+    "forecast Paris 48",
+    "location 51.5074 -0.1278",
+    "loc 40.7 -74.0",
+    "  STATS  ",
+    "stats prometheus",
+    "cache",
+    "alert add temp above 30 Rio de Janeiro",
+    "watch San Francisco",
+    "notif",
+    "help",
+    "frobnicate now",
+    "q",
+};
+
+// The parsing processCommand did before CommandParser: trim, split into
+// strings, lowercase the verb, rejoin the arguments and compare in turn
+std::string legacyTrim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos) return "";
+    size_t last = str.find_last_not_of(" \t\n\r");
+    return str.substr(first, (last - first + 1));
+}
+
+Command legacyParse(const std::string& line, std::string& args) {
+    std::string trimmed = legacyTrim(line);
+    if (trimmed.empty()) {
+        return Command::NONE;
+    }
+    std::vector<std::string> tokens;
+    std::istringstream iss(trimmed);
+    std::string token;
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+    std::string cmd = tokens.empty() ? "" : tokens[0];
+    std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+
+    args.clear();
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        if (i > 1) args += " ";
+        args += tokens[i];
+    }
+
+    if (cmd == "weather" || cmd == "w") return Command::WEATHER;
+    if (cmd == "forecast" || cmd == "fc") return Command::FORECAST;
+    if (cmd == "location" || cmd == "loc") return Command::LOCATION;
+    if (cmd == "help" || cmd == "h") return Command::HELP;
+    if (cmd == "notifications" || cmd == "notif") return Command::NOTIFICATIONS;
+    if (cmd == "watch") return Command::WATCH;
+    if (cmd == "unwatch") return Command::UNWATCH;
+    if (cmd == "find") return Command::FIND;
+    if (cmd == "alert" || cmd == "alerts") return Command::ALERT;
+    if (cmd == "cache") return Command::CACHE;
+    if (cmd == "stats") return Command::STATS;
+    if (cmd == "clear") return Command::CLEAR;
+    if (cmd == "exit" || cmd == "quit" || cmd == "q") return Command::EXIT;
+    return Command::UNKNOWN;
+}
+
+struct Result {
+    double commandsPerSecond = 0.0;
+    double allocationsPerCommand = 0.0;
+};
+
+template <typename Parse>
+Result measure(size_t iterations, Parse parse) {
+    Result result;
+    uint64_t checksum = 0;
+    uint64_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (const auto& command : COMMANDS) {
+            checksum += parse(command);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Keeps the parsing from being optimized away
+    sink = checksum;
+    double commands = static_cast<double>(iterations * COMMANDS.size());
+    result.commandsPerSecond = commands / seconds;
+    result.allocationsPerCommand = static_cast<double>(allocationCount.load() - allocationsBefore) / commands;
+    return result;
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    // Both parsers must agree on the verb and, up to whitespace, the arguments
+    bool identical = true;
+    for (const auto& command : COMMANDS) {
+        std::string legacyArgs;
+        Command legacy = legacyParse(command, legacyArgs);
+        CommandLine line = CommandParser::parse(command);
+        if (legacy != line.command || legacyArgs != CommandParser::joinWords(line.args)) {
+            std::cerr << "Mismatch for '" << command << "'" << std::endl;
+            identical = false;
+        }
+    }
+
+    std::string args;
+    Result before = measure(iterations, [&args](const std::string& command) {
+        return static_cast<uint64_t>(legacyParse(command, args)) + args.size();
+    });
+    Result after = measure(iterations, [](const std::string& command) {
+        CommandLine line = CommandParser::parse(command);
+        return static_cast<uint64_t>(line.command) + line.args.size();
+    });
+
+    std::cout << "{\"benchmark\":\"commands\",\"commands\":" << iterations * COMMANDS.size()
+              << ",\"before_commands_per_sec\":" << before.commandsPerSecond
+              << ",\"after_commands_per_sec\":" << after.commandsPerSecond
+              << ",\"speedup\":" << after.commandsPerSecond / before.commandsPerSecond
+              << ",\"before_allocs_per_command\":" << before.allocationsPerCommand
+              << ",\"after_allocs_per_command\":" << after.allocationsPerCommand
+              << ",\"identical\":" << (identical ? "true" : "false") << "}" << std::endl;
+
+    return identical ? 0 : 1;
+}
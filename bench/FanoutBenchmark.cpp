@@ -0,0 +1,110 @@
+// Times alert fan-out from publish() to the last sink call: one storm event
+// every subscriber watches, then one event for every location at once.
+//
+// Usage: weatherbot_fanout_bench [subscribers] [locations] [rounds]
+
+#include "AlertDispatcher.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counts what it is handed, as a socket or queue sink would take it
+class CountingSink : public AlertSink {
+public:
+    void deliver(const std::vector<AlertMessage>& messages) override {
+        messages_.fetch_add(messages.size(), std::memory_order_relaxed);
+        calls_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t messages() const { return messages_.load(); }
+    uint64_t calls() const { return calls_.load(); }
+
+private:
+    std::atomic<uint64_t> messages_{0};
+    std::atomic<uint64_t> calls_{0};
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Publishes events and waits for their delivery; returns the milliseconds taken
+double deliver(AlertDispatcher& dispatcher, std::vector<AlertEvent> events) {
+    auto start = std::chrono::steady_clock::now();
+    dispatcher.publish(std::move(events));
+    dispatcher.flush();
+    return elapsedMs(start);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t subscriberCount = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t locationCount = argc > 2 ? std::stoul(argv[2]) : 1000;
+    size_t rounds = argc > 3 ? std::stoul(argv[3]) : 5;
+
+    // Every round is a new condition and no subscriber runs out of rate
+    AlertDispatchConfig config;
+    config.alertsPerMinute = 1e9;
+    config.burst = 1e9;
+    AlertDispatcher dispatcher(config);
+    auto sink = std::make_shared<CountingSink>();
+
+    std::vector<std::string> cities;
+    for (size_t i = 0; i < locationCount; ++i) {
+        cities.push_back("City " + std::to_string(i));
+    }
+
+    // Everyone watches the storm's path plus one other location
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pick(0, locationCount - 1);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < subscriberCount; ++i) {
+        std::string name = "session-" + std::to_string(i);
+        dispatcher.addSubscriber(name, sink);
+        dispatcher.subscribe(name, "Storm City");
+        dispatcher.subscribe(name, cities[pick(random)]);
+    }
+    double registerMs = elapsedMs(start);
+
+    std::vector<double> storm;
+    std::vector<double> scattered;
+    for (size_t round = 0; round < rounds; ++round) {
+        std::string condition = "Storm warning " + std::to_string(round);
+        storm.push_back(deliver(dispatcher, {AlertEvent{1, "", "Storm City", condition}}));
+
+        std::vector<AlertEvent> events;
+        for (const std::string& city : cities) {
+            events.push_back(AlertEvent{2, "", city, condition});
+        }
+        scattered.push_back(deliver(dispatcher, std::move(events)));
+    }
+    std::sort(storm.begin(), storm.end());
+    std::sort(scattered.begin(), scattered.end());
+    double stormMs = storm[storm.size() / 2];
+    double scatteredMs = scattered[scattered.size() / 2];
+
+    // Each round sends one storm alert and one location alert per subscriber
+    uint64_t expected = 2 * subscriberCount * rounds;
+    AlertDispatchStats stats = dispatcher.getStats();
+
+    std::cout << "{\"benchmark\":\"fanout\",\"subscribers\":" << subscriberCount
+              << ",\"locations\":" << locationCount
+              << ",\"rounds\":" << rounds
+              << ",\"register_ms\":" << registerMs
+              << ",\"storm_ms\":" << stormMs
+              << ",\"scattered_ms\":" << scatteredMs
+              << ",\"storm_ns_per_subscriber\":" << 1e6 * stormMs / static_cast<double>(subscriberCount)
+              << ",\"delivered\":" << sink->messages()
+              << ",\"sink_calls\":" << sink->calls()
+              << ",\"batches\":" << stats.batches
+              << ",\"complete\":" << (sink->messages() == expected ? "true" : "false") << "}" << std::endl;
+
+    return sink->messages() == expected ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+// Measures the observation log: how small Gorilla-compressed blocks are next to
+// a raw 20-byte record (timestamp plus three floats), how fast samples are
+// appended, and how fast a range summary streams a location's file. Samples
+// are synthetic but shaped like polled OpenWeatherMap data: one every ten
+// minutes with scheduler jitter, values rounded as the API reports them, and
+// a share of polls that return the previous observation unchanged.
+//
+// Usage: weatherbot_history_bench [--locations N] [--days N] [--jitter-s S]
+//                                 [--repeat P] [--seed N]
+
+#include "HistoryStore.h"
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const int64_t INTERVAL_SECONDS = 600;
+const double RAW_BYTES_PER_SAMPLE = 20.0;
+
+struct HistoryConfig {
+    size_t locations = 200;
+    size_t days = 30;
+    int64_t jitterSeconds = 5;
+    double repeatRate = 0.3;  // Polls that see the same observation as the last one
+    unsigned seed = 42;
+};
+
+bool parseArguments(int argc, char* argv[], HistoryConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--locations") {
+            config.locations = std::stoul(value);
+        } else if (arg == "--days") {
+            config.days = std::stoul(value);
+        } else if (arg == "--jitter-s") {
+            config.jitterSeconds = std::stol(value);
+        } else if (arg == "--repeat") {
+            config.repeatRate = std::stod(value);
+        } else if (arg == "--seed") {
+            config.seed = static_cast<unsigned>(std::stoul(value));
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+float roundTo(double value, double step) {
+    return static_cast<float>(std::round(value / step) * step);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    HistoryConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        return 2;
+    }
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() /
+                                      ("weatherbot_history_bench_" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+
+    std::mt19937 random(config.seed);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int64_t> jitter(-config.jitterSeconds, config.jitterSeconds);
+
+    size_t steps = config.days * 86400 / INTERVAL_SECONDS;
+    int64_t start = 1729209600;  // 2024-10-18 00:00 UTC
+    std::vector<WeatherData> current(config.locations);
+    std::vector<double> drift(config.locations, 0.0);
+    std::vector<double> baseline(config.locations);
+    for (size_t i = 0; i < config.locations; ++i) {
+        current[i].setCity("City " + std::to_string(i));
+        current[i].setCountry("XX");
+        current[i].isValid = true;
+        baseline[i] = 5.0 + 20.0 * chance(random);
+    }
+
+    // Every sample is kept to check that decoding returns exactly what went in
+    std::vector<std::vector<HistorySample>> expected(config.locations);
+    uint64_t samples = 0;
+    std::chrono::steady_clock::duration appendTime{0};
+    {
+        HistoryStore store(directory.string());
+        if (!store.open()) {
+            return 1;
+        }
+        for (size_t step = 0; step < steps; ++step) {
+            int64_t slot = start + static_cast<int64_t>(step) * INTERVAL_SECONDS;
+            double hourOfDay = static_cast<double>((slot % 86400) / 3600);
+            for (size_t i = 0; i < config.locations; ++i) {
+                WeatherData& data = current[i];
+                if (step == 0 || chance(random) >= config.repeatRate) {
+                    drift[i] = 0.98 * drift[i] + 0.3 * noise(random);
+                    double temperature = baseline[i] + 4.0 * std::sin((hourOfDay - 9.0) * M_PI / 12.0) + drift[i];
+                    data.temperature = roundTo(temperature, 0.01);
+                    data.humidity = roundTo(std::clamp(70.0 - 2.0 * (temperature - baseline[i]) + 3.0 * noise(random), 5.0, 100.0), 1.0);
+                    data.windSpeed = roundTo(std::max(0.0, 4.0 + 1.5 * drift[i] + noise(random)), 0.01);
+                }
+                int64_t time = slot + jitter(random);
+                expected[i].push_back(HistorySample{time, data.temperature, data.humidity, data.windSpeed});
+
+                auto before = std::chrono::steady_clock::now();
+                store.append(data, time);
+                appendTime += std::chrono::steady_clock::now() - before;
+                ++samples;
+            }
+        }
+        store.flush();
+    }
+
+    uint64_t diskBytes = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        diskBytes += entry.file_size();
+    }
+
+    // Full scans check every sample; week summaries show what a typical query costs
+    HistoryStore store(directory.string());
+    bool lossless = true;
+    uint64_t scanned = 0;
+    auto scanStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < config.locations; ++i) {
+        size_t index = 0;
+        const std::vector<HistorySample>& want = expected[i];
+        store.scan(HistoryStore::locationKey(current[i].city(), current[i].country()), INT64_MIN, INT64_MAX,
+                   [&](const HistorySample& sample) {
+            const HistorySample* match = index < want.size() ? &want[index] : nullptr;
+            lossless = lossless && match && match->time == sample.time && match->temperature == sample.temperature &&
+                       match->humidity == sample.humidity && match->windSpeed == sample.windSpeed;
+            ++index;
+        });
+        lossless = lossless && index == want.size();
+        scanned += index;
+    }
+    double scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
+
+    int64_t end = start + static_cast<int64_t>(steps) * INTERVAL_SECONDS;
+    auto queryStart = std::chrono::steady_clock::now();
+    uint64_t skipped = 0;
+    for (size_t i = 0; i < config.locations; ++i) {
+        HistorySummary summary;
+        store.summarize(HistoryStore::locationKey(current[i].city(), current[i].country()), end - 7 * 86400, end, summary);
+        skipped += summary.blocksSkipped;
+    }
+    double querySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - queryStart).count();
+
+    std::filesystem::remove_all(directory);
+
+    double bytesPerSample = samples > 0 ? static_cast<double>(diskBytes) / static_cast<double>(samples) : 0.0;
+    std::cout << "{\"benchmark\":\"history\",\"locations\":" << config.locations
+              << ",\"days\":" << config.days
+              << ",\"samples\":" << samples
+              << ",\"lossless\":" << (lossless ? "true" : "false")
+              << ",\"raw_bytes\":" << static_cast<uint64_t>(RAW_BYTES_PER_SAMPLE * static_cast<double>(samples))
+              << ",\"disk_bytes\":" << diskBytes
+              << ",\"bits_per_sample\":" << 8.0 * bytesPerSample
+              << ",\"compression_ratio\":" << (bytesPerSample > 0 ? RAW_BYTES_PER_SAMPLE / bytesPerSample : 0.0)
+              << ",\"append_ns_per_sample\":" << std::chrono::duration<double, std::nano>(appendTime).count() / static_cast<double>(samples)
+              << ",\"scan_samples_per_sec\":" << (scanSeconds > 0 ? static_cast<double>(scanned) / scanSeconds : 0.0)
+              << ",\"week_summary_us\":" << querySeconds * 1e6 / static_cast<double>(config.locations)
+              << ",\"blocks_skipped_per_summary\":" << static_cast<double>(skipped) / static_cast<double>(config.locations)
+              << "}" << std::endl;
+
+    return lossless ? 0 : 1;
+}
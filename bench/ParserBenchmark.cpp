@@ -0,0 +1,99 @@
+// Compares the streaming WeatherJsonParser against the nlohmann::json DOM path.
+//
+// Usage: weatherbot_parser_bench [iterations]
+
+#include "WeatherJsonParser.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+
+namespace {
+
+const char* SAMPLE_RESPONSE = R"({"coord":{"lon":-0.1257,"lat":51.5085},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"base":"stations","main":{"temp":12.47,"feels_like":11.96,"temp_min":11.2,"temp_max":13.61,"pressure":1012,"humidity":84,"sea_level":1012,"grnd_level":1008},"visibility":10000,"wind":{"speed":5.14,"deg":230,"gust":9.26},"rain":{"1h":0.31},"clouds":{"all":75},"dt":1729245600,"sys":{"type":2,"id":2075535,"country":"GB","sunrise":1729233131,"sunset":1729270834},"timezone":3600,"id":2643743,"name":"London","cod":200})";
+
+// Documents where both parsers must agree on validity and extracted fields
+const std::vector<std::string> EQUIVALENCE_CASES = {
+    SAMPLE_RESPONSE,
+    R"({"cod":"404","message":"city not found"})",
+    R"({"cod":200.0,"name":"Zürich","sys":{"country":"CH"},"weather":[{"description":"clear sky"}]})",
+    R"({"name":"A","name":"B","main":{"temp":true,"humidity":50}})",
+    R"({"name":5})",
+    R"({"weather":[]})",
+    R"({"weather":[1]})",
+    R"({"weather":[{"icon":"01d"}]})",
+    R"({"main":{"temp":"hot"}})",
+    R"({"main":null,"wind":[1,2]})",
+    R"([1,2,3])",
+    R"({"name":"x",})",
+    R"({"name":"x"} trailing)",
+    R"({"name":"😀"})",
+    R"({"name":"\udc00"})",
+    R"({"main":{"temp":1e-400,"humidity":1e400}})",
+    "{\"name\":\"caf\xc3\xa9\"}",
+    "{\"name\":\"bad\xff\"}",
+};
+
+bool sameResult(const WeatherData& a, const WeatherData& b) {
+    if (a.isValid != b.isValid) {
+        return false;
+    }
+    if (!a.isValid) {
+        return true;
+    }
+    return a.cityId == b.cityId && a.city() == b.city() && a.country() == b.country() && a.description() == b.description() && a.icon() == b.icon() &&
+           a.temperature == b.temperature && a.feelsLike == b.feelsLike && a.humidity == b.humidity &&
+           a.windSpeed == b.windSpeed;
+}
+
+template <typename Parse>
+double measure(const std::string& payload, size_t iterations, Parse parse) {
+    double checksum = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        WeatherData data = parse(payload);
+        checksum += data.temperature;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    if (std::isnan(checksum)) {
+        std::cout << "";
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+    std::string payload = SAMPLE_RESPONSE;
+
+    // Silence the parsers' error logging while checking the edge cases
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+    size_t mismatches = 0;
+    for (const auto& document : EQUIVALENCE_CASES) {
+        if (!sameResult(WeatherJsonParser::parse(document), WeatherJsonParser::parseDom(document))) {
+            std::cout << "MISMATCH: " << document << std::endl;
+            ++mismatches;
+        }
+    }
+    std::cerr.rdbuf(previous);
+
+    double streamingNs = measure(payload, iterations, [](const std::string& body) {
+        return WeatherJsonParser::parse(body);
+    });
+    double domNs = measure(payload, iterations, [](const std::string& body) {
+        return WeatherJsonParser::parseDom(body);
+    });
+
+    std::cout << "{\"benchmark\":\"parser\",\"iterations\":" << iterations
+              << ",\"payload_bytes\":" << payload.size()
+              << ",\"streaming_ns_per_op\":" << streamingNs
+              << ",\"dom_ns_per_op\":" << domNs
+              << ",\"speedup\":" << domNs / streamingNs
+              << ",\"equivalence_mismatches\":" << mismatches << "}" << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,805 @@
+// Replays command traces through WeatherBot::processCommand against a loopback
+// mock of the OpenWeatherMap API, so changes can be measured without network
+// access or an API key. The "concurrent" scenario instead awaits every lookup
+// at once through the coroutine API from a single thread. The "quota"
+// scenarios do the same against a mock that answers 429 once a per-second
+// quota is used up, with and without the rate limiter pacing requests. The
+// "providers" scenarios make sequential coordinate lookups routed across
+// OpenWeatherMap and Open-Meteo mocks, where a share of responses is held back
+// by a tail delay, with one provider per lookup and with the two raced.
+//
+// Usage: weatherbot_replay_bench [--requests N] [--latency-ms MS] [--jitter-ms MS]
+//                                [--error-rate P] [--trace FILE] [--seed N]
+//                                [--quota PER_SECOND] [--tail-rate P] [--tail-ms MS]
+
+#include "WeatherBot.h"
+#include "WeatherService.h"
+#include "WeatherCache.h"
+#include "NotificationManager.h"
+#include "Task.h"
+#include <curl/curl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Allocation accounting. Both C++ heap allocations and libcurl's allocations
+// (via curl_global_init_mem) are counted; the mock server's threads opt out.
+
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocationBytes{0};
+thread_local bool excludeAllocations = false;
+
+void countAllocation(size_t size) {
+    if (!excludeAllocations) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+void* curlMalloc(size_t size) {
+    countAllocation(size);
+    return std::malloc(size);
+}
+
+void curlFree(void* ptr) {
+    std::free(ptr);
+}
+
+void* curlRealloc(void* ptr, size_t size) {
+    countAllocation(size);
+    return std::realloc(ptr, size);
+}
+
+char* curlStrdup(const char* str) {
+    size_t size = std::strlen(str) + 1;
+    countAllocation(size);
+    char* copy = static_cast<char*>(std::malloc(size));
+    if (copy) {
+        std::memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+void* curlCalloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return std::calloc(count, size);
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    countAllocation(size);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    countAllocation(size);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+// GCC pairs these with the allocations in coroutine frames after inlining and
+// misreads the malloc-backed operator new above as a mismatch
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Recorded /data/2.5/weather responses, keyed by lowercase city name
+
+const std::unordered_map<std::string, std::string> RECORDED_PAYLOADS = {
+    {"london", R"({"coord":{"lon":-0.1257,"lat":51.5085},"weather":[{"id":500,"main":"Rain","description":"light rain","icon":"10d"}],"base":"stations","main":{"temp":12.47,"feels_like":11.96,"temp_min":11.2,"temp_max":13.61,"pressure":1012,"humidity":84,"sea_level":1012,"grnd_level":1008},"visibility":10000,"wind":{"speed":5.14,"deg":230,"gust":9.26},"rain":{"1h":0.31},"clouds":{"all":75},"dt":1729245600,"sys":{"type":2,"id":2075535,"country":"GB","sunrise":1729233131,"sunset":1729270834},"timezone":3600,"id":2643743,"name":"London","cod":200})"},
+    {"paris", R"({"coord":{"lon":2.3488,"lat":48.8534},"weather":[{"id":803,"main":"Clouds","description":"broken clouds","icon":"04d"}],"base":"stations","main":{"temp":14.02,"feels_like":13.41,"temp_min":12.99,"temp_max":15.03,"pressure":1015,"humidity":76,"sea_level":1015,"grnd_level":1005},"visibility":10000,"wind":{"speed":4.12,"deg":200},"clouds":{"all":75},"dt":1729245600,"sys":{"type":2,"id":2041230,"country":"FR","sunrise":1729232213,"sunset":1729270533},"timezone":7200,"id":2988507,"name":"Paris","cod":200})"},
+    {"tokyo", R"({"coord":{"lon":139.6917,"lat":35.6895},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01n"}],"base":"stations","main":{"temp":19.84,"feels_like":19.63,"temp_min":18.2,"temp_max":21.01,"pressure":1019,"humidity":70,"sea_level":1019,"grnd_level":1017},"visibility":10000,"wind":{"speed":3.6,"deg":350},"clouds":{"all":0},"dt":1729245600,"sys":{"type":2,"id":268395,"country":"JP","sunrise":1729197812,"sunset":1729238290},"timezone":32400,"id":1850144,"name":"Tokyo","cod":200})"},
+    {"new york", R"({"coord":{"lon":-74.006,"lat":40.7143},"weather":[{"id":801,"main":"Clouds","description":"few clouds","icon":"02d"}],"base":"stations","main":{"temp":9.35,"feels_like":7.11,"temp_min":7.8,"temp_max":10.6,"pressure":1023,"humidity":52,"sea_level":1023,"grnd_level":1022},"visibility":10000,"wind":{"speed":4.63,"deg":320},"clouds":{"all":20},"dt":1729245600,"sys":{"type":2,"id":2008101,"country":"US","sunrise":1729249771,"sunset":1729289377},"timezone":-14400,"id":5128581,"name":"New York","cod":200})"},
+    {"reykjavik", R"({"coord":{"lon":-21.8954,"lat":64.1355},"weather":[{"id":600,"main":"Snow","description":"light snow","icon":"13d"}],"base":"stations","main":{"temp":-3.4,"feels_like":-10.2,"temp_min":-4.1,"temp_max":-2.8,"pressure":998,"humidity":86,"sea_level":998,"grnd_level":992},"visibility":6000,"wind":{"speed":17.5,"deg":60,"gust":24.2},"snow":{"1h":0.4},"clouds":{"all":100},"dt":1729245600,"sys":{"type":2,"id":2075536,"country":"IS","sunrise":1729237880,"sunset":1729271911},"timezone":0,"id":3413829,"name":"Reykjavik","cod":200})"},
+    {"dubai", R"({"coord":{"lon":55.3047,"lat":25.2582},"weather":[{"id":800,"main":"Clear","description":"clear sky","icon":"01d"}],"base":"stations","main":{"temp":38.96,"feels_like":41.3,"temp_min":37.2,"temp_max":39.8,"pressure":1009,"humidity":32,"sea_level":1009,"grnd_level":1008},"visibility":10000,"wind":{"speed":5.66,"deg":310},"clouds":{"all":0},"dt":1729245600,"sys":{"type":1,"id":7537,"country":"AE","sunrise":1729218215,"sunset":1729259852},"timezone":14400,"id":292223,"name":"Dubai","cod":200})"},
+};
+
+// Recorded /v1/forecast current conditions, served for any coordinates
+const char* OPEN_METEO_PAYLOAD = R"({"latitude":51.5,"longitude":-0.120000124,"generationtime_ms":0.0311136245727539,"utc_offset_seconds":0,"timezone":"GMT","timezone_abbreviation":"GMT","elevation":23.0,"current_units":{"time":"iso8601","interval":"seconds","temperature_2m":"°C","relative_humidity_2m":"%","apparent_temperature":"°C","wind_speed_10m":"m/s","weather_code":"wmo code","is_day":""},"current":{"time":"2024-10-18T10:00","interval":900,"temperature_2m":12.6,"relative_humidity_2m":83,"apparent_temperature":11.2,"wind_speed_10m":5.3,"weather_code":61,"is_day":1}})";
+
+const char* NOT_FOUND_PAYLOAD = R"({"cod":"404","message":"city not found"})";
+const char* ERROR_PAYLOAD = R"({"cod":"500","message":"Internal error"})";
+const char* THROTTLED_PAYLOAD = R"({"cod":429,"message":"Your account is temporary blocked due to exceeding of requests limitation of your subscription type."})";
+
+// Commands replayed when no --trace file is given
+const std::vector<std::string> DEFAULT_TRACE = {
+    "weather London",
+    "weather Paris",
+    "location 51.5085 -0.1257",
+    "weather London; Tokyo; Dubai",
+    "weather london",
+    "cache",
+    "weather New York",
+    "weather Atlantis",
+    "weather Reykjavik; Paris; New York",
+    "weather Tokyo",
+    "stats",
+    "weather Dubai",
+    "help",
+    "notifications",
+};
+
+struct ReplayConfig {
+    size_t requests = 2000;
+    std::chrono::microseconds latency{2000};
+    std::chrono::microseconds jitter{1000};
+    double errorRate = 0.0;
+    std::string tracePath;
+    unsigned seed = 42;
+    size_t quotaPerSecond = 200;
+    // Share of responses held back by tailDelay in the "providers" scenarios
+    double tailRate = 0.05;
+    std::chrono::microseconds tailDelay{50000};
+};
+
+std::string urlDecode(const std::string& value) {
+    std::string decoded;
+    for (size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '+') {
+            decoded += ' ';
+        } else if (value[i] == '%' && i + 2 < value.size()) {
+            decoded += static_cast<char>(std::strtol(value.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += value[i];
+        }
+    }
+    return decoded;
+}
+
+std::string queryParameter(const std::string& target, const std::string& name) {
+    size_t query = target.find('?');
+    while (query != std::string::npos) {
+        size_t start = query + 1;
+        size_t end = target.find('&', start);
+        std::string pair = target.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        if (pair.compare(0, name.size() + 1, name + "=") == 0) {
+            return urlDecode(pair.substr(name.size() + 1));
+        }
+        query = end;
+    }
+    return "";
+}
+
+// ---------------------------------------------------------------------------
+// Minimal HTTP/1.1 keep-alive server on 127.0.0.1 serving recorded payloads
+
+class MockWeatherServer {
+public:
+    explicit MockWeatherServer(const ReplayConfig& config)
+        : config_(config), listenFd_(-1), port_(0), running_(true), random_(config.seed), requests_(0),
+          throttled_(0), quota_(0), windowCount_(0), tailRate_(0.0) {
+    }
+
+    ~MockWeatherServer() {
+        stop();
+    }
+
+    bool start() {
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd_ < 0) {
+            return false;
+        }
+        int reuse = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t length = sizeof(address);
+        if (bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listenFd_, 128) != 0 ||
+            getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return false;
+        }
+        port_ = ntohs(address.sin_port);
+        acceptThread_ = std::thread(&MockWeatherServer::acceptLoop, this);
+        return true;
+    }
+
+    void stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        if (listenFd_ >= 0) {
+            shutdown(listenFd_, SHUT_RDWR);
+            close(listenFd_);
+        }
+        if (acceptThread_.joinable()) {
+            acceptThread_.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : connections_) {
+            shutdown(fd, SHUT_RDWR);
+        }
+        for (auto& thread : connectionThreads_) {
+            thread.join();
+        }
+    }
+
+    std::string baseUrl() const {
+        return "http://127.0.0.1:" + std::to_string(port_) + "/data/2.5";
+    }
+
+    std::string openMeteoUrl() const {
+        return "http://127.0.0.1:" + std::to_string(port_) + "/v1";
+    }
+
+    uint64_t getRequestCount() const { return requests_.load(); }
+    uint64_t getThrottledCount() const { return throttled_.load(); }
+    // Requests allowed per one-second window before answering 429; 0 for no quota
+    void setQuota(size_t perSecond) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quota_ = perSecond;
+        windowStart_ = std::chrono::steady_clock::now();
+        windowCount_ = 0;
+    }
+    // Share of requests delayed by the configured tail delay on top of the usual latency
+    void setTailRate(double rate) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tailRate_ = rate;
+    }
+
+private:
+    ReplayConfig config_;
+    int listenFd_;
+    uint16_t port_;
+    std::atomic<bool> running_;
+    std::thread acceptThread_;
+    std::mutex mutex_;
+    std::vector<int> connections_;
+    std::vector<std::thread> connectionThreads_;
+    std::mt19937 random_;
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> throttled_;
+    size_t quota_;
+    std::chrono::steady_clock::time_point windowStart_;
+    size_t windowCount_;
+    double tailRate_;
+
+    void acceptLoop() {
+        excludeAllocations = true;
+        while (running_) {
+            int fd = accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                close(fd);
+                break;
+            }
+            connections_.push_back(fd);
+            connectionThreads_.emplace_back(&MockWeatherServer::serveConnection, this, fd);
+        }
+    }
+
+    void serveConnection(int fd) {
+        excludeAllocations = true;
+        std::string buffer;
+        char chunk[4096];
+        while (running_) {
+            size_t headerEnd = buffer.find("\r\n\r\n");
+            if (headerEnd == std::string::npos) {
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    break;
+                }
+                buffer.append(chunk, static_cast<size_t>(received));
+                continue;
+            }
+
+            std::string requestLine = buffer.substr(0, buffer.find("\r\n"));
+            buffer.erase(0, headerEnd + 4);
+            size_t targetStart = requestLine.find(' ');
+            size_t targetEnd = requestLine.find(' ', targetStart + 1);
+            std::string target = requestLine.substr(targetStart + 1, targetEnd - targetStart - 1);
+
+            std::string response = respond(target);
+            if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    std::string respond(const std::string& target) {
+        ++requests_;
+
+        std::chrono::microseconds delay;
+        bool injectError;
+        bool overQuota = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (quota_ > 0) {
+                auto now = std::chrono::steady_clock::now();
+                if (now - windowStart_ >= std::chrono::seconds(1)) {
+                    windowStart_ = now;
+                    windowCount_ = 0;
+                }
+                overQuota = ++windowCount_ > quota_;
+            }
+            std::uniform_int_distribution<long long> jitter(-config_.jitter.count(), config_.jitter.count());
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            delay = std::max(std::chrono::microseconds(0), config_.latency + std::chrono::microseconds(jitter(random_)));
+            if (chance(random_) < tailRate_) {
+                delay += config_.tailDelay;
+            }
+            injectError = chance(random_) < config_.errorRate;
+        }
+        std::this_thread::sleep_for(delay);
+
+        int status = 200;
+        std::string body;
+        if (overQuota) {
+            ++throttled_;
+            status = 429;
+            body = THROTTLED_PAYLOAD;
+        } else if (injectError) {
+            status = 500;
+            body = ERROR_PAYLOAD;
+        } else if (target.compare(0, 13, "/v1/forecast?") == 0) {
+            body = OPEN_METEO_PAYLOAD;
+        } else if (!queryParameter(target, "lat").empty()) {
+            body = RECORDED_PAYLOADS.at("london");
+        } else {
+            auto found = RECORDED_PAYLOADS.find(WeatherCache::cityKey(queryParameter(target, "q")).substr(5));
+            if (found != RECORDED_PAYLOADS.end()) {
+                body = found->second;
+            } else {
+                status = 404;
+                body = NOT_FOUND_PAYLOAD;
+            }
+        }
+
+        std::ostringstream response;
+        const char* reason = status == 200 ? " OK" : status == 404 ? " Not Found"
+                           : status == 429 ? " Too Many Requests" : " Internal Server Error";
+        response << "HTTP/1.1 " << status << reason
+                 << (status == 429 ? "\r\nRetry-After: 1" : "")
+                 << "\r\nContent-Type: application/json; charset=utf-8"
+                 << "\r\nContent-Length: " << body.size()
+                 << "\r\nConnection: keep-alive\r\n\r\n"
+                 << body;
+        return response.str();
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Scenario driver
+
+struct ScenarioResult {
+    std::string name;
+    size_t commands = 0;
+    size_t lookups = 0;
+    bool countsOutcomes = false;  // Whether succeeded and throttled were measured
+    size_t succeeded = 0;
+    uint64_t upstreamRequests = 0;
+    uint64_t throttled = 0;
+    double seconds = 0.0;
+    std::vector<double> latenciesUs;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+double percentile(std::vector<double> sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size()));
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+size_t countLookups(const std::string& command) {
+    if (command.compare(0, 8, "weather ") == 0 || command.compare(0, 2, "w ") == 0) {
+        return static_cast<size_t>(std::count(command.begin(), command.end(), ';')) + 1;
+    }
+    if (command.compare(0, 9, "location ") == 0 || command.compare(0, 4, "loc ") == 0) {
+        return 1;
+    }
+    return 0;
+}
+
+// Completes one lookup and records how long after the common start it finished
+Task<WeatherData> timedLookup(WeatherService& service, double latitude, double longitude,
+                              std::chrono::steady_clock::time_point start, double& latencyUs) {
+    Task<WeatherData> lookup = service.getWeatherByCoordinatesAsync(latitude, longitude);
+    WeatherData data = co_await lookup;
+    latencyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    co_return data;
+}
+
+class ReplayRunner {
+public:
+    ReplayRunner(const std::string& baseUrl, MockWeatherServer& server)
+        : context_(makeContext(baseUrl)),
+          service_("replay-key", context_),
+          notifications_(output_),
+          bot_(service_, notifications_, output_),
+          server_(server) {
+    }
+
+    // Runs each command once; coldCache drops cached results before every command
+    ScenarioResult run(const std::string& name, const std::vector<std::string>& commands, bool coldCache) {
+        ScenarioResult result;
+        result.name = name;
+        result.latenciesUs.reserve(commands.size());
+        uint64_t upstreamBefore = server_.getRequestCount();
+
+        std::chrono::steady_clock::duration total{0};
+        for (const auto& command : commands) {
+            if (coldCache) {
+                context_->cache->clear();
+            }
+            output_.str("");
+            notifications_.clearNotifications();
+            output_.str("");
+
+            uint64_t allocationsBefore = allocationCount.load();
+            uint64_t bytesBefore = allocationBytes.load();
+            auto start = std::chrono::steady_clock::now();
+            bot_.processCommand(command);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            result.allocations += allocationCount.load() - allocationsBefore;
+            result.allocatedBytes += allocationBytes.load() - bytesBefore;
+
+            total += elapsed;
+            result.latenciesUs.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+            result.lookups += countLookups(command);
+            ++result.commands;
+        }
+
+        result.seconds = std::chrono::duration<double>(total).count();
+        result.upstreamRequests = server_.getRequestCount() - upstreamBefore;
+        return result;
+    }
+
+    // Starts every lookup before awaiting any; each uses its own coordinate cell so
+    // nothing is answered from the cache or coalesced
+    ScenarioResult runConcurrent(const std::string& name, size_t lookups) {
+        context_->cache->clear();
+        return runConcurrentOn(service_, name, lookups);
+    }
+
+    // Concurrent batch-priority lookups against a mock that answers 429 past
+    // quotaPerSecond. Paced, the limiter runs just under the quota; unpaced, every
+    // lookup is sent at once and only the 429s' Retry-After slows them down.
+    ScenarioResult runQuota(const std::string& name, size_t lookups, size_t quotaPerSecond, bool paced) {
+        auto context = makeContext(context_->config->get().baseUrl);
+        if (paced) {
+            // Sustained rate plus burst stays within any one-second window of the quota
+            RateLimitConfig limit;
+            limit.requestsPerMinute = static_cast<double>(quotaPerSecond) * 60.0 * 0.9;
+            limit.burst = std::max(1.0, static_cast<double>(quotaPerSecond) * 0.1);
+            context->rateLimiter = std::make_shared<RateLimiter>(limit);
+        }
+        WeatherService service("replay-key", context);
+        service.setPriority(RequestPriority::BATCH);
+
+        server_.setQuota(quotaPerSecond);
+        uint64_t throttledBefore = server_.getThrottledCount();
+
+        ScenarioResult result = runConcurrentOn(service, name, lookups);
+        result.throttled = server_.getThrottledCount() - throttledBefore;
+        server_.setQuota(0);
+        return result;
+    }
+
+    // Sequential coordinate lookups routed across both mock providers while
+    // tailRate of responses are slow. Racing sends each lookup to both and
+    // takes the first answer, so one slow response no longer sets its latency.
+    ScenarioResult runProviders(const std::string& name, size_t lookups, double tailRate, bool race) {
+        auto context = makeContext(context_->config->get().baseUrl);
+        ProviderRoutingConfig routing;
+        routing.race = race;
+        context->providers = std::make_shared<ProviderRouter>(routing);
+        context->providers->add(std::make_shared<OpenWeatherMapProvider>(context->config->get().baseUrl),
+                                context->breakers[static_cast<size_t>(Endpoint::WEATHER)]);
+        context->providers->add(std::make_shared<OpenMeteoProvider>(server_.openMeteoUrl()));
+        WeatherService service("replay-key", context);
+
+        ScenarioResult result;
+        result.name = name;
+        result.commands = lookups;
+        result.lookups = lookups;
+        result.latenciesUs.reserve(lookups);
+        server_.setTailRate(tailRate);
+        uint64_t upstreamBefore = server_.getRequestCount();
+        uint64_t allocationsBefore = allocationCount.load();
+        uint64_t bytesBefore = allocationBytes.load();
+
+        std::chrono::steady_clock::duration total{0};
+        for (size_t i = 0; i < lookups; ++i) {
+            double latitude = -60.0 + static_cast<double>(i / 100) * 0.5;
+            double longitude = -120.0 + static_cast<double>(i % 100) * 0.5;
+            auto start = std::chrono::steady_clock::now();
+            WeatherData data = syncWait(service.getWeatherByCoordinatesAsync(latitude, longitude));
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            total += elapsed;
+            result.latenciesUs.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+            result.succeeded += data.isValid ? 1 : 0;
+        }
+
+        result.seconds = std::chrono::duration<double>(total).count();
+        result.allocations = allocationCount.load() - allocationsBefore;
+        result.allocatedBytes = allocationBytes.load() - bytesBefore;
+        result.upstreamRequests = server_.getRequestCount() - upstreamBefore;
+        result.countsOutcomes = true;
+        server_.setTailRate(0.0);
+        return result;
+    }
+
+    void warm(const std::string& command) {
+        bot_.processCommand(command);
+    }
+
+    void clearCache() {
+        context_->cache->clear();
+    }
+
+private:
+    std::shared_ptr<WeatherServiceContext> context_;
+    WeatherService service_;
+    std::ostringstream output_;
+    NotificationManager notifications_;
+    WeatherBot bot_;
+    MockWeatherServer& server_;
+
+    ScenarioResult runConcurrentOn(WeatherService& service, const std::string& name, size_t lookups) {
+        ScenarioResult result;
+        result.name = name;
+        result.commands = 1;
+        result.lookups = lookups;
+        result.latenciesUs.assign(lookups, 0.0);
+        uint64_t upstreamBefore = server_.getRequestCount();
+        uint64_t allocationsBefore = allocationCount.load();
+        uint64_t bytesBefore = allocationBytes.load();
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Task<WeatherData>> tasks;
+        tasks.reserve(lookups);
+        for (size_t i = 0; i < lookups; ++i) {
+            double latitude = -60.0 + static_cast<double>(i / 100) * 0.5;
+            double longitude = -120.0 + static_cast<double>(i % 100) * 0.5;
+            tasks.push_back(timedLookup(service, latitude, longitude, start, result.latenciesUs[i]));
+        }
+        std::vector<WeatherData> data = syncWait(whenAll(std::move(tasks)));
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        result.allocations = allocationCount.load() - allocationsBefore;
+        result.allocatedBytes = allocationBytes.load() - bytesBefore;
+        result.upstreamRequests = server_.getRequestCount() - upstreamBefore;
+        result.countsOutcomes = true;
+        result.succeeded = static_cast<size_t>(std::count_if(data.begin(), data.end(),
+                                                             [](const WeatherData& d) { return d.isValid; }));
+        return result;
+    }
+
+    static std::shared_ptr<WeatherServiceContext> makeContext(const std::string& baseUrl) {
+        auto context = std::make_shared<WeatherServiceContext>();
+        context->config->setDefaults([&](RuntimeConfig& config) { config.baseUrl = baseUrl; });
+        // The mock has no quota; the "quota" scenario sets its own limiter
+        RateLimitConfig unlimited;
+        unlimited.requestsPerMinute = 0.0;
+        context->rateLimiter = std::make_shared<RateLimiter>(unlimited);
+        return context;
+    }
+};
+
+void printResult(const ScenarioResult& result, bool last) {
+    double perLookup = result.lookups > 0 ? static_cast<double>(result.lookups) : static_cast<double>(result.commands);
+    std::cout << "{\"name\":\"" << result.name << "\""
+              << ",\"commands\":" << result.commands
+              << ",\"lookups\":" << result.lookups
+              << ",\"upstream_requests\":" << result.upstreamRequests
+              << ",\"seconds\":" << result.seconds
+              << ",\"commands_per_sec\":" << (result.seconds > 0 ? result.commands / result.seconds : 0.0)
+              << ",\"lookups_per_sec\":" << (result.seconds > 0 ? result.lookups / result.seconds : 0.0)
+              << ",\"p50_us\":" << percentile(result.latenciesUs, 0.50)
+              << ",\"p99_us\":" << percentile(result.latenciesUs, 0.99)
+              << ",\"p999_us\":" << percentile(result.latenciesUs, 0.999)
+              << ",\"allocs_per_request\":" << result.allocations / perLookup
+              << ",\"alloc_bytes_per_request\":" << result.allocatedBytes / perLookup;
+    if (result.countsOutcomes) {
+        // Under a quota, lookups answered per upstream request is the number that matters
+        std::cout << ",\"succeeded\":" << result.succeeded
+                  << ",\"throttled\":" << result.throttled
+                  << ",\"succeeded_per_upstream_request\":"
+                  << (result.upstreamRequests > 0 ? static_cast<double>(result.succeeded) / result.upstreamRequests : 0.0);
+    }
+    std::cout << "}" << (last ? "" : ",");
+}
+
+bool parseArguments(int argc, char* argv[], ReplayConfig& config) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--requests") {
+            config.requests = std::stoul(value);
+        } else if (arg == "--latency-ms") {
+            config.latency = std::chrono::microseconds(static_cast<long long>(std::stod(value) * 1000));
+        } else if (arg == "--jitter-ms") {
+            config.jitter = std::chrono::microseconds(static_cast<long long>(std::stod(value) * 1000));
+        } else if (arg == "--error-rate") {
+            config.errorRate = std::stod(value);
+        } else if (arg == "--trace") {
+            config.tracePath = value;
+        } else if (arg == "--seed") {
+            config.seed = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--quota") {
+            config.quotaPerSecond = std::stoul(value);
+        } else if (arg == "--tail-rate") {
+            config.tailRate = std::stod(value);
+        } else if (arg == "--tail-ms") {
+            config.tailDelay = std::chrono::microseconds(static_cast<long long>(std::stod(value) * 1000));
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadTrace(const std::string& path, std::vector<std::string>& commands) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot open trace file " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            commands.push_back(line);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        return 2;
+    }
+
+    std::vector<std::string> trace = DEFAULT_TRACE;
+    if (!config.tracePath.empty()) {
+        trace.clear();
+        if (!loadTrace(config.tracePath, trace)) {
+            return 2;
+        }
+    }
+
+    // Route libcurl's allocations through the counters; this must precede any other curl_global_init
+    curl_global_init_mem(CURL_GLOBAL_DEFAULT, curlMalloc, curlFree, curlRealloc, curlStrdup, curlCalloc);
+    // Never send loopback traffic through a proxy configured in the environment
+    setenv("no_proxy", "127.0.0.1", 1);
+    setenv("NO_PROXY", "127.0.0.1", 1);
+
+    MockWeatherServer server(config);
+    if (!server.start()) {
+        std::cerr << "Error: Failed to start mock server" << std::endl;
+        return 1;
+    }
+
+    // Injected upstream errors are expected; keep the service's logging out of the results
+    std::ostringstream discarded;
+    std::streambuf* previous = std::cerr.rdbuf(discarded.rdbuf());
+
+    std::vector<ScenarioResult> results;
+    {
+        ReplayRunner runner(server.baseUrl(), server);
+        const std::vector<std::string> cities = {"London", "Paris", "Tokyo", "New York", "Reykjavik", "Dubai"};
+
+        std::vector<std::string> single;
+        std::vector<std::string> batch;
+        std::vector<std::string> cached;
+        for (size_t i = 0; i < config.requests; ++i) {
+            single.push_back("weather " + cities[i % cities.size()]);
+            cached.push_back("weather " + cities[i % cities.size()]);
+        }
+        std::string batchCommand = "weather London; Paris; Tokyo; New York; Reykjavik; Dubai";
+        for (size_t i = 0; i < std::max<size_t>(1, config.requests / cities.size()); ++i) {
+            batch.push_back(batchCommand);
+        }
+        std::vector<std::string> replay;
+        while (replay.size() < config.requests && !trace.empty()) {
+            replay.insert(replay.end(), trace.begin(), trace.end());
+        }
+
+        runner.warm("weather London");
+        results.push_back(runner.run("single", single, true));
+        results.push_back(runner.run("batch", batch, true));
+        runner.warm(batchCommand);
+        results.push_back(runner.run("cached", cached, false));
+        runner.clearCache();
+        results.push_back(runner.run("trace", replay, false));
+        results.push_back(runner.runConcurrent("concurrent", config.requests));
+        if (config.quotaPerSecond > 0) {
+            size_t quotaLookups = std::min<size_t>(config.requests, config.quotaPerSecond * 3);
+            results.push_back(runner.runQuota("quota_unpaced", quotaLookups, config.quotaPerSecond, false));
+            results.push_back(runner.runQuota("quota_paced", quotaLookups, config.quotaPerSecond, true));
+        }
+        size_t providerLookups = std::min<size_t>(config.requests, 500);
+        results.push_back(runner.runProviders("providers_single", providerLookups, config.tailRate, false));
+        results.push_back(runner.runProviders("providers_race", providerLookups, config.tailRate, true));
+    }
+
+    std::cerr.rdbuf(previous);
+    server.stop();
+    curl_global_cleanup();
+
+    std::cout << "{\"benchmark\":\"replay\",\"requests\":" << config.requests
+              << ",\"latency_ms\":" << config.latency.count() / 1000.0
+              << ",\"jitter_ms\":" << config.jitter.count() / 1000.0
+              << ",\"error_rate\":" << config.errorRate
+              << ",\"tail_rate\":" << config.tailRate
+              << ",\"tail_ms\":" << config.tailDelay.count() / 1000.0
+              << ",\"scenarios\":[";
+    for (size_t i = 0; i < results.size(); ++i) {
+        printResult(results[i], i + 1 == results.size());
+    }
+    std::cout << "]}" << std::endl;
+
+    return 0;
+}
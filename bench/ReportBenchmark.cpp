@@ -0,0 +1,176 @@
+// Compares the previous ostringstream/setw weather report against
+// ReportRenderer, in reports per second and heap allocations per report, for
+// each output style. The renderer appends to one buffer reused across reports,
+// as the bot and batch writer do. Also checks that every line of the box has
+// the same display width for ASCII, accented and CJK city names.
+//
+// Usage: weatherbot_report_bench [iterations]
+
+#include "ReportRenderer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount{0};
+volatile uint64_t sink = 0;
+
+struct Place {
+    const char* city;
+    const char* country;
+    const char* description;
+    float temperature;
+    float feelsLike;
+    float humidity;
+    float windSpeed;
+};
+
+const std::vector<Place> PLACES = {
+    {"London", "GB", "light rain", 12.47f, 11.96f, 84.0f, 5.14f},
+    {"Zürich", "CH", "clear sky", -3.2f, -7.9f, 61.0f, 2.3f},
+    {"東京都", "JP", "broken clouds", 21.0f, 21.4f, 70.0f, 3.6f},
+    {"Rio de Janeiro", "BR", "few clouds", 31.9f, 36.2f, 58.0f, 4.1f},
+    {"São Paulo", "BR", "thunderstorm with heavy rain", 24.3f, 25.0f, 94.0f, 7.7f},
+};
+
+// The report formatWeatherReport built before ReportRenderer
+std::string legacyReport(const WeatherData& data) {
+    std::ostringstream report;
+    report << "\n╔════════════════════════════════════════╗\n";
+    report << "║        WEATHER FORECAST REPORT        ║\n";
+    report << "╠════════════════════════════════════════╣\n";
+    report << "║ Location: " << std::left << std::setw(26) << (std::string(data.city()) + ", " + std::string(data.country())) << "║\n";
+    report << "║ Condition: " << std::setw(25) << data.description() << "║\n";
+    report << "║ Temperature: " << std::setw(23) << (std::to_string(static_cast<int>(data.temperature)) + "°C") << "║\n";
+    report << "║ Feels Like: " << std::setw(24) << (std::to_string(static_cast<int>(data.feelsLike)) + "°C") << "║\n";
+    report << "║ Humidity: " << std::setw(26) << (std::to_string(static_cast<int>(data.humidity)) + "%") << "║\n";
+    report << "║ Wind Speed: " << std::setw(23) << (std::to_string(static_cast<int>(data.windSpeed)) + " m/s") << "║\n";
+    report << "╚════════════════════════════════════════╝\n";
+    return report.str();
+}
+
+// True if every line of the report is as wide as the first border
+bool aligned(const std::string& report) {
+    size_t expected = 0;
+    size_t start = report.find('\n') + 1;
+    while (start < report.size()) {
+        size_t end = report.find('\n', start);
+        size_t width = ReportRenderer::displayWidth(std::string_view(report).substr(start, end - start));
+        if (expected == 0) {
+            expected = width;
+        } else if (width != expected) {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+struct Result {
+    double reportsPerSecond = 0.0;
+    double allocationsPerReport = 0.0;
+};
+
+template <typename Render>
+Result measure(const std::vector<WeatherData>& observations, size_t iterations, Render render) {
+    Result result;
+    uint64_t checksum = 0;
+    uint64_t allocationsBefore = allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (const auto& data : observations) {
+            checksum += render(data);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Keeps the rendering from being optimized away
+    sink = checksum;
+    double reports = static_cast<double>(iterations * observations.size());
+    result.reportsPerSecond = reports / seconds;
+    result.allocationsPerReport = static_cast<double>(allocationCount.load() - allocationsBefore) / reports;
+    return result;
+}
+
+template <ReportStyle Style>
+Result measureRenderer(const std::vector<WeatherData>& observations, size_t iterations) {
+    std::string buffer;
+    return measure(observations, iterations, [&buffer](const WeatherData& data) {
+        buffer.clear();
+        ReportRenderer::render<Style>(data, buffer);
+        return static_cast<uint64_t>(buffer.size());
+    });
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    std::vector<WeatherData> observations;
+    for (const Place& place : PLACES) {
+        WeatherData data;
+        data.setCity(place.city);
+        data.setCountry(place.country);
+        data.setDescription(place.description);
+        data.temperature = place.temperature;
+        data.feelsLike = place.feelsLike;
+        data.humidity = place.humidity;
+        data.windSpeed = place.windSpeed;
+        data.isValid = true;
+        observations.push_back(data);
+    }
+
+    bool legacyAligned = true;
+    bool boxAligned = true;
+    for (const auto& data : observations) {
+        std::string box;
+        ReportRenderer::render<ReportStyle::BOX>(data, box);
+        legacyAligned = legacyAligned && aligned(legacyReport(data));
+        boxAligned = boxAligned && aligned(box);
+    }
+
+    Result legacy = measure(observations, iterations, [](const WeatherData& data) {
+        return static_cast<uint64_t>(legacyReport(data).size());
+    });
+    Result box = measureRenderer<ReportStyle::BOX>(observations, iterations);
+    Result compact = measureRenderer<ReportStyle::COMPACT>(observations, iterations);
+    Result json = measureRenderer<ReportStyle::JSON>(observations, iterations);
+
+    std::cout << "{\"benchmark\":\"report\",\"reports\":" << iterations * observations.size()
+              << ",\"legacy_reports_per_sec\":" << legacy.reportsPerSecond
+              << ",\"box_reports_per_sec\":" << box.reportsPerSecond
+              << ",\"compact_reports_per_sec\":" << compact.reportsPerSecond
+              << ",\"json_reports_per_sec\":" << json.reportsPerSecond
+              << ",\"box_speedup\":" << box.reportsPerSecond / legacy.reportsPerSecond
+              << ",\"legacy_allocs_per_report\":" << legacy.allocationsPerReport
+              << ",\"box_allocs_per_report\":" << box.allocationsPerReport
+              << ",\"compact_allocs_per_report\":" << compact.allocationsPerReport
+              << ",\"json_allocs_per_report\":" << json.allocationsPerReport
+              << ",\"legacy_aligned\":" << (legacyAligned ? "true" : "false")
+              << ",\"box_aligned\":" << (boxAligned ? "true" : "false") << "}" << std::endl;
+
+    return boxAligned ? 0 : 1;
+}
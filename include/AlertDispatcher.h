@@ -0,0 +1,187 @@
+#ifndef ALERT_DISPATCHER_H
+#define ALERT_DISPATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include "AlertEngine.h"
+#include "NotificationManager.h"
+
+// One alert for one subscriber. The views stay valid for the duration of the
+// AlertSink::deliver call they are passed to.
+struct AlertMessage {
+    std::string_view subscriber;
+    std::string_view city;
+    std::string_view condition;
+};
+
+// Where alerts for the subscribers registered with it go. Each batch hands a
+// sink all of its messages in one call, on the dispatcher thread.
+class AlertSink {
+public:
+    virtual ~AlertSink() = default;
+
+    virtual void deliver(const std::vector<AlertMessage>& messages) = 0;
+    // Whether each subscriber is held to the per-subscriber rate; false for
+    // sinks that record rather than interrupt someone
+    virtual bool rateLimited() const { return true; }
+};
+
+// Shows alerts through a NotificationManager, which must outlive the sink's registration
+class ConsoleAlertSink : public AlertSink {
+public:
+    explicit ConsoleAlertSink(NotificationManager& notifications) : notifications_(notifications) {}
+
+    void deliver(const std::vector<AlertMessage>& messages) override;
+
+private:
+    NotificationManager& notifications_;
+};
+
+// Appends one JSON object per alert to a file, for another process to tail
+// as it would a message queue
+class FileAlertSink : public AlertSink {
+public:
+    explicit FileAlertSink(const std::string& path);
+
+    bool isOpen() const { return file_.is_open(); }
+    void deliver(const std::vector<AlertMessage>& messages) override;
+    bool rateLimited() const override { return false; }
+
+private:
+    std::ofstream file_;
+    std::string line_;  // Reused between batches
+};
+
+struct AlertDispatchConfig {
+    // Per subscriber, so a storm over many locations cannot flood one person
+    double alertsPerMinute = 6.0;
+    double burst = 5.0;
+    // The same alert for the same location is sent once per window, however
+    // often the observations cross its threshold
+    std::chrono::seconds repeatWindow{900};
+    size_t queueCapacity = 65536;  // Events waiting for the dispatcher; newer ones are dropped
+};
+
+struct AlertDispatchStats {
+    size_t subscribers = 0;
+    size_t subscriptions = 0;   // (subscriber, location) pairs, subscribe-all ones excluded
+    size_t locations = 0;       // With at least one subscriber
+    uint64_t published = 0;     // Events accepted for delivery
+    uint64_t delivered = 0;     // Messages handed to sinks
+    uint64_t repeats = 0;       // Events dropped as repeats within the window
+    uint64_t throttled = 0;     // Messages dropped by the per-subscriber rate
+    uint64_t dropped = 0;       // Events refused with the queue full
+    uint64_t batches = 0;
+};
+
+// Fans raised alerts out to the users who want them. Subscribers register
+// under a name with a sink, then subscribe to locations; an inverted index
+// maps each location to its subscribers, so a batch of events reaches every
+// affected subscriber in one pass over the index, however many there are.
+// Events for a rule with an owner go to that owner alone.
+//
+// publish() only queues. A dispatcher thread takes everything queued at
+// once, drops repeats, resolves subscribers, applies each one's rate and
+// hands every sink its share of the batch in a single call.
+class AlertDispatcher {
+public:
+    explicit AlertDispatcher(const AlertDispatchConfig& config = AlertDispatchConfig());
+    ~AlertDispatcher();
+
+    AlertDispatcher(const AlertDispatcher&) = delete;
+    AlertDispatcher& operator=(const AlertDispatcher&) = delete;
+
+    // Registers name, or moves it to another sink keeping its subscriptions
+    void addSubscriber(const std::string& name, std::shared_ptr<AlertSink> sink);
+    // Drops name and its subscriptions. Does not wait for a batch being delivered.
+    bool removeSubscriber(const std::string& name);
+    // Drops every subscriber on sink and waits until no batch is being
+    // delivered, after which the sink is no longer called
+    void removeSink(const AlertSink* sink);
+
+    // False if name is not registered or already subscribed to city
+    bool subscribe(const std::string& name, const std::string& city);
+    bool unsubscribe(const std::string& name, const std::string& city);
+    // Every location's alerts, present and future
+    bool subscribeAll(const std::string& name);
+    // Subscribers to city, subscribe-all ones excluded
+    size_t getSubscriberCount(const std::string& city);
+
+    // Queues events for delivery; safe from any thread
+    void publish(std::vector<AlertEvent> events);
+    // Waits until everything published so far has been delivered
+    void flush();
+
+    AlertDispatchStats getStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Where a subscriber sits in one location's subscriber list, so leaving is O(1)
+    struct Membership {
+        uint32_t location;
+        uint32_t position;
+    };
+
+    struct Subscriber {
+        std::string name;
+        std::shared_ptr<AlertSink> sink;  // Null for a free slot
+        std::vector<Membership> memberships;
+        bool everywhere = false;
+        double tokens = 0.0;
+        Clock::time_point refilled;
+    };
+
+    struct Delivery {
+        uint32_t subscriber;
+        uint32_t event;
+
+        bool operator<(const Delivery& other) const {
+            return subscriber != other.subscriber ? subscriber < other.subscriber : event < other.event;
+        }
+        bool operator==(const Delivery&) const = default;
+    };
+
+    AlertDispatchConfig config_;
+
+    std::mutex mutex_;  // Registry, queue and counters
+    std::vector<Subscriber> subscribers_;
+    std::vector<uint32_t> freeSlots_;
+    std::unordered_map<std::string, uint32_t> byName_;
+    // The inverted index: location id to the slots subscribed to it
+    std::unordered_map<std::string, uint32_t> locationIds_;
+    std::vector<std::vector<uint32_t>> locationSubscribers_;
+    std::vector<uint32_t> everywhere_;
+    size_t subscriptions_;
+
+    std::vector<AlertEvent> queue_;
+    std::condition_variable wakeup_;
+    std::condition_variable idle_;
+    std::thread thread_;
+    bool stopping_;
+    bool dispatching_;
+    AlertDispatchStats stats_;
+
+    // Held while a batch is resolved and delivered, so removeSink can wait it out
+    std::mutex deliveryMutex_;
+    // Dispatcher thread only: when each alert was last sent, by owner, location and condition
+    std::unordered_map<std::string, Clock::time_point> recent_;
+    Clock::time_point pruned_;
+
+    void run();
+    void dispatch(std::vector<AlertEvent>& events);
+    uint32_t locationIdLocked(const std::string& key);
+    void leaveLocked(uint32_t slot, size_t membership);
+    void removeLocked(uint32_t slot);
+};
+
+#endif // ALERT_DISPATCHER_H
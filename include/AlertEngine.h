@@ -0,0 +1,143 @@
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "WeatherData.h"
+
+enum class AlertMetric : uint8_t {
+    TEMPERATURE,
+    WIND_SPEED,
+    HUMIDITY,
+    COUNT
+};
+
+enum class AlertComparison : uint8_t {
+    ABOVE,
+    BELOW
+};
+
+enum class AlertRuleKind : uint8_t {
+    THRESHOLD,
+    RATE_OF_CHANGE  // Compares the change per hour between consecutive observations
+};
+
+struct AlertRule {
+    std::string owner;        // User the rule belongs to; empty for rules that apply to everyone
+    std::string location;     // City the rule is limited to; empty for every location
+    AlertMetric metric = AlertMetric::TEMPERATURE;
+    AlertComparison comparison = AlertComparison::ABOVE;
+    AlertRuleKind kind = AlertRuleKind::THRESHOLD;
+    float threshold = 0.0f;   // Metric units, or metric units per hour for rate rules
+    float hysteresis = 0.0f;  // How far back past the threshold a value must go to clear the alert
+    std::string condition;    // Shown with the alert
+};
+
+// Where the rules addDefaultRules installs raise their alerts
+struct AlertThresholds {
+    float freezingBelow = 0.0f;  // °C
+    float heatAbove = 35.0f;     // °C
+    float windAbove = 15.0f;     // m/s
+
+    bool operator==(const AlertThresholds&) const = default;
+};
+
+struct AlertEvent {
+    uint32_t ruleId;
+    std::string owner;
+    std::string city;
+    std::string condition;
+};
+
+// Evaluates threshold and rate-of-change rules for every observed location.
+//
+// Each rule is expanded into one instance per location it applies to. The
+// instances are kept as parallel arrays and evaluated in blocks of eight with
+// AVX2 where the CPU supports it (scalar otherwise), producing one state bit
+// and one "newly raised" bit per instance.
+class AlertEngine {
+public:
+    AlertEngine();
+    ~AlertEngine();
+
+    uint32_t addRule(const AlertRule& rule);
+    // Only the rule's owner may remove it
+    bool removeRule(uint32_t ruleId, const std::string& owner);
+    size_t removeRulesFor(const std::string& owner);
+    // Rules that apply to owner: their own plus everyone's
+    std::vector<std::pair<uint32_t, AlertRule>> getRules(const std::string& owner);
+    // Freezing, heat and strong wind alerts for everyone
+    void addDefaultRules(const AlertThresholds& thresholds = AlertThresholds());
+    // Moves the default rules' thresholds; alerts already raised stay raised
+    // until the value clears the new threshold
+    void setDefaultThresholds(const AlertThresholds& thresholds);
+
+    // Records an observation into the location columns
+    void update(const WeatherData& data);
+    // Evaluates one location's rules and returns the conditions currently active for owner
+    std::vector<std::string> evaluateLocation(const std::string& city, const std::string& owner);
+    // Evaluates every rule instance and appends the alerts raised since the last evaluation
+    void evaluate(std::vector<AlertEvent>& raised);
+
+    size_t getInstanceCount();
+    void setForceScalar(bool forceScalar);
+    static bool hasAvx2();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Inputs per location: the three metrics, then their rates of change
+    static const size_t INPUT_COLUMNS = 2 * static_cast<size_t>(AlertMetric::COUNT);
+
+    struct StoredRule {
+        AlertRule rule;
+        std::string locationKey;
+    };
+
+    struct Location {
+        std::string key;
+        std::string city;
+        float previous[static_cast<size_t>(AlertMetric::COUNT)];
+        Clock::time_point previousAt;
+        bool hasPrevious = false;
+        size_t firstInstance = 0;
+        size_t instanceCount = 0;
+    };
+
+    std::mutex mutex_;
+    std::map<uint32_t, StoredRule> rules_;
+    uint32_t nextRuleId_;
+    std::vector<uint32_t> defaultRules_;  // Freezing, heat and wind, once added
+
+    std::vector<Location> locations_;
+    std::unordered_map<std::string, size_t> locationIndex_;
+    // Column-major: columns_[column * capacity_ + location], plus one trailing NaN used for padding
+    std::vector<float> columns_;
+    size_t capacity_;
+
+    // Rule instances as parallel arrays, padded to a multiple of eight
+    std::vector<uint32_t> instanceRule_;
+    std::vector<int32_t> instanceInput_;
+    std::vector<float> instanceSign_;
+    std::vector<float> instanceThreshold_;  // sign * threshold
+    std::vector<float> instanceHysteresis_;
+    std::vector<uint8_t> active_;            // One bit per instance
+    std::vector<uint8_t> raised_;            // One bit per instance, from the last evaluation
+    size_t instanceCount_;
+    bool dirty_;
+    bool forceScalar_;
+
+    void rebuildLocked();
+    void growLocked();
+    void evaluateScalar(size_t begin, size_t end);
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __attribute__((target("avx2"))) void evaluateAvx2(size_t begin, size_t end);
+#endif
+};
+
+#endif // ALERT_ENGINE_H
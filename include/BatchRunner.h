@@ -0,0 +1,84 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+#include <cstdint>
+#include "WeatherService.h"
+#include "Task.h"
+
+enum class BatchFormat {
+    NDJSON,
+    CSV
+};
+
+enum class BatchOrder {
+    COMPLETION,  // Each result is written as soon as it arrives
+    INPUT        // Results are held back until every earlier line has been written
+};
+
+struct BatchConfig {
+    std::string inputPath = "-";  // "-" reads standard input
+    std::string outputPath;       // Standard output when empty
+    BatchFormat format = BatchFormat::NDJSON;
+    BatchOrder order = BatchOrder::COMPLETION;
+    size_t parallelism = 64;      // Lines started but not yet written
+};
+
+// Non-interactive mode for scripts and cron jobs. Reads one lookup per line
+// ("weather <city>", "location <lat> <lon>", a city ID or a bare city name;
+// blank lines and '#' comments are skipped), runs them through the
+// asynchronous lookup path with bounded parallelism and streams one record
+// per line as NDJSON or CSV. Input is read as it is consumed, so memory use
+// does not grow with the number of lines.
+class BatchRunner {
+public:
+    BatchRunner(const std::string& apiKey, const BatchConfig& config = BatchConfig(),
+                std::shared_ptr<WeatherServiceContext> context = nullptr);
+
+    // Returns the process exit code: 0 if every line produced a result
+    int run();
+
+private:
+    struct Result {
+        uint64_t sequence = 0;
+        std::string input;
+        WeatherData data;
+        const char* error = nullptr;  // Set when no result could be produced
+    };
+
+    BatchConfig config_;
+    WeatherService weatherService_;
+
+    // Filled from the event loop thread, drained by the thread in run()
+    std::mutex mutex_;
+    std::condition_variable completed_;
+    std::vector<Result> finished_;
+
+    // Only touched by the thread in run()
+    size_t outstanding_;                        // Started but not yet written
+    std::vector<std::optional<Result>> window_;  // Reorder buffer for BatchOrder::INPUT
+    uint64_t nextToWrite_;
+    uint64_t written_;
+    uint64_t failed_;
+    std::string buffer_;
+    std::ostream* out_;
+
+    static bool parseQuery(std::string_view line, WeatherQuery& query);
+    Task<void> lookup(uint64_t sequence, std::string input, WeatherQuery query);
+    void finish(Result result);
+    // Writes whatever has finished, blocking while `limit` or more lines are outstanding
+    void drainBelow(size_t limit);
+    void accept(Result result);
+    void write(const Result& result);
+    void writeHeader();
+    void flush(bool force);
+};
+
+#endif // BATCH_RUNNER_H
@@ -0,0 +1,62 @@
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Upstream endpoints, each guarded by its own breaker
+enum class Endpoint {
+    WEATHER,
+    GROUP,
+    FORECAST,
+    COUNT
+};
+
+enum class BreakerState {
+    CLOSED,     // Requests flow normally
+    OPEN,       // Requests fail fast until the open period ends
+    HALF_OPEN   // One probe request decides whether to close again
+};
+
+struct CircuitBreakerConfig {
+    size_t failureThreshold = 5;                    // Consecutive failures that open the breaker
+    std::chrono::milliseconds openDuration{15000};  // How long to fail fast before probing
+};
+
+// Stops sending requests to an endpoint that keeps failing, so callers get an
+// immediate answer (usually a stale result) instead of waiting out timeouts.
+// After the open period a single probe is let through; its outcome closes the
+// breaker or opens it for another period.
+class CircuitBreaker {
+public:
+    explicit CircuitBreaker(const CircuitBreakerConfig& config = CircuitBreakerConfig());
+
+    // False while open; every allowed request must be followed by recordSuccess,
+    // recordFailure or recordCancelled
+    bool allowRequest();
+    void recordSuccess();
+    void recordFailure();
+    // The allowed request was never sent, so it says nothing about the endpoint
+    void recordCancelled();
+
+    BreakerState getState();
+    uint64_t getRejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+    static const char* stateName(BreakerState state);
+    static const char* endpointName(Endpoint endpoint);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    CircuitBreakerConfig config_;
+    std::mutex mutex_;
+    BreakerState state_;
+    size_t consecutiveFailures_;
+    Clock::time_point openedAt_;
+    bool probeInFlight_;
+    std::atomic<uint64_t> rejected_{0};
+};
+
+#endif // CIRCUIT_BREAKER_H
@@ -0,0 +1,162 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+enum class Command : uint8_t {
+    NONE,  // Blank line
+    UNKNOWN,
+    WEATHER,
+    FORECAST,
+    LOCATION,
+    HISTORY,
+    HELP,
+    NOTIFICATIONS,
+    WATCH,
+    UNWATCH,
+    FIND,
+    ALERT,
+    CACHE,
+    STATS,
+    CONFIG,
+    CLEAR,
+    EXIT
+};
+
+// A parsed command line; verb and args view into the line they came from
+struct CommandLine {
+    Command command = Command::NONE;
+    std::string_view verb;
+    std::string_view args;      // Everything after the verb, trimmed
+    std::string_view provider;  // From a trailing "@name" (removed from args); empty to let the router choose
+};
+
+// Splits text on whitespace without copying it
+class CommandTokenizer {
+public:
+    explicit CommandTokenizer(std::string_view text) : rest_(text) {}
+
+    // False once no tokens are left
+    bool next(std::string_view& token);
+    // The text after the last token returned, trimmed
+    std::string_view remainder() const;
+
+private:
+    std::string_view rest_;
+};
+
+namespace detail {
+
+struct CommandName {
+    std::string_view name;
+    Command command;
+};
+
+// Verbs and their aliases; matched case-insensitively
+inline constexpr CommandName COMMAND_NAMES[] = {
+    {"weather", Command::WEATHER},        {"w", Command::WEATHER},
+    {"forecast", Command::FORECAST},      {"fc", Command::FORECAST},
+    {"location", Command::LOCATION},      {"loc", Command::LOCATION},
+    {"history", Command::HISTORY},        {"hist", Command::HISTORY},
+    {"help", Command::HELP},              {"h", Command::HELP},
+    {"notifications", Command::NOTIFICATIONS}, {"notif", Command::NOTIFICATIONS},
+    {"watch", Command::WATCH},            {"unwatch", Command::UNWATCH},
+    {"find", Command::FIND},              {"alert", Command::ALERT},
+    {"alerts", Command::ALERT},           {"cache", Command::CACHE},
+    {"stats", Command::STATS},            {"clear", Command::CLEAR},
+    {"config", Command::CONFIG},          {"exit", Command::EXIT},
+    {"quit", Command::EXIT},              {"q", Command::EXIT},
+};
+
+inline constexpr size_t COMMAND_SLOT_COUNT = 128;
+inline constexpr size_t COMMAND_NAME_COUNT = sizeof(COMMAND_NAMES) / sizeof(COMMAND_NAMES[0]);
+
+constexpr char lowerAscii(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr uint32_t commandHash(std::string_view name, uint32_t seed) {
+    uint32_t hash = seed;
+    for (char c : name) {
+        hash = (hash ^ static_cast<uint8_t>(lowerAscii(c))) * 16777619u;
+    }
+    return hash;
+}
+
+constexpr bool isPerfectSeed(uint32_t seed) {
+    bool used[COMMAND_SLOT_COUNT] = {};
+    for (const CommandName& entry : COMMAND_NAMES) {
+        size_t slot = commandHash(entry.name, seed) % COMMAND_SLOT_COUNT;
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+// Searched at compile time: the first seed under which no two names share a slot
+constexpr uint32_t findCommandSeed() {
+    for (uint32_t seed = 2166136261u; seed < 2166136261u + 100000; ++seed) {
+        if (isPerfectSeed(seed)) {
+            return seed;
+        }
+    }
+    return 0;
+}
+
+inline constexpr uint32_t COMMAND_SEED = findCommandSeed();
+static_assert(isPerfectSeed(COMMAND_SEED), "No collision-free seed for the command table; grow COMMAND_SLOT_COUNT");
+
+// Index into COMMAND_NAMES plus one per slot, zero for an empty slot
+constexpr std::array<uint8_t, COMMAND_SLOT_COUNT> buildCommandSlots() {
+    std::array<uint8_t, COMMAND_SLOT_COUNT> slots = {};
+    for (size_t i = 0; i < COMMAND_NAME_COUNT; ++i) {
+        slots[commandHash(COMMAND_NAMES[i].name, COMMAND_SEED) % COMMAND_SLOT_COUNT] = static_cast<uint8_t>(i + 1);
+    }
+    return slots;
+}
+
+inline constexpr std::array<uint8_t, COMMAND_SLOT_COUNT> COMMAND_SLOTS = buildCommandSlots();
+
+} // namespace detail
+
+// Turns REPL and server command lines into a Command plus argument views.
+// Verbs are resolved through a perfect hash built at compile time, so one
+// probe and one comparison decide any verb, and nothing on the parse path
+// allocates.
+class CommandParser {
+public:
+    static CommandLine parse(std::string_view line);
+
+    static constexpr Command lookup(std::string_view verb) {
+        uint8_t entry = detail::COMMAND_SLOTS[detail::commandHash(verb, detail::COMMAND_SEED) % detail::COMMAND_SLOT_COUNT];
+        if (entry == 0) {
+            return Command::UNKNOWN;
+        }
+        std::string_view name = detail::COMMAND_NAMES[entry - 1].name;
+        if (name.size() != verb.size()) {
+            return Command::UNKNOWN;
+        }
+        for (size_t i = 0; i < name.size(); ++i) {
+            if (detail::lowerAscii(verb[i]) != name[i]) {
+                return Command::UNKNOWN;
+            }
+        }
+        return detail::COMMAND_NAMES[entry - 1].command;
+    }
+
+    static std::string_view trim(std::string_view text);
+    // Copies text with each run of whitespace collapsed to one space
+    static std::string joinWords(std::string_view text);
+};
+
+static_assert(CommandParser::lookup("Weather") == Command::WEATHER);
+static_assert(CommandParser::lookup("q") == Command::EXIT);
+static_assert(CommandParser::lookup("weathe") == Command::UNKNOWN);
+
+#endif // COMMAND_PARSER_H
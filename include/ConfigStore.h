@@ -0,0 +1,113 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <filesystem>
+#include <cstdint>
+#include "RcuCell.h"
+#include "WeatherCache.h"
+#include "RateLimiter.h"
+#include "AlertEngine.h"
+#include "WeatherProvider.h"
+#include "EventLoop.h"
+
+// Time budget and retry behaviour for one upstream request
+struct RequestPolicy {
+    std::chrono::milliseconds deadline{8000};        // Whole request, retries and hedges included
+    std::chrono::milliseconds attemptTimeout{3000};  // One attempt
+    std::chrono::milliseconds connectTimeout{2000};
+    // A second attempt is started if the first has not answered by the observed
+    // p95 upstream latency, kept within these bounds
+    std::chrono::milliseconds minHedgeDelay{150};
+    std::chrono::milliseconds maxHedgeDelay{1500};
+    size_t maxAttempts = 3;                          // Hedges and retries included
+    std::chrono::milliseconds backoffBase{200};      // Retry backoff, doubled per failure with full jitter
+    std::chrono::milliseconds backoffMax{2000};
+
+    bool operator==(const RequestPolicy&) const = default;
+};
+
+// Every setting that can change while the process runs. Each published
+// version is complete and consistent, so a request reads get() once and
+// works from that version throughout.
+struct RuntimeConfig {
+    // OpenWeatherMap key; empty keeps the key each service was created with
+    std::string apiKey;
+    // OpenWeatherMap API root for current weather, group and forecast requests
+    std::string baseUrl = OpenWeatherMapProvider::DEFAULT_URL;
+    WeatherCacheConfig cache;
+    RateLimitConfig rateLimit;
+    RequestPolicy requestPolicy;
+    size_t maxConcurrency = 16;  // Transfers one getWeatherBatch call runs at once
+    AlertThresholds alerts;
+};
+
+struct ConfigStats {
+    std::string path;       // Empty without a config file
+    bool watching = false;  // Reloaded when the file changes
+    uint64_t reloads = 0;   // File versions applied, the first load included
+    uint64_t rejected = 0;  // File versions left unapplied for an error
+};
+
+// Holds the current RuntimeConfig and replaces it as a whole. Readers call
+// get() without locking; a new version is built from the defaults (what the
+// command line set) plus every `key = value` line of the config file, and is
+// published only if the whole file parses, so a half-edited file changes
+// nothing. The listener then brings the components that copy settings into
+// line. Watching the file reloads it as soon as an editor writes or replaces it.
+class ConfigStore {
+public:
+    // previous is the version that was current until now
+    using Listener = std::function<void(const RuntimeConfig& previous, const RuntimeConfig& current)>;
+
+    explicit ConfigStore(const RuntimeConfig& defaults = RuntimeConfig());
+    ~ConfigStore();
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    const RuntimeConfig& get() const { return current_.get(); }
+
+    // Edits the settings the file leaves alone and publishes the result
+    void setDefaults(const std::function<void(RuntimeConfig&)>& change);
+    // Reads path and publishes defaults plus its settings; false, with the
+    // errors reported and nothing changed, if it cannot be read or has a bad line
+    bool load(const std::string& path);
+    // Reads the loaded file again
+    bool reload();
+    // Reloads on the loop whenever the file changes; load() first
+    bool watch(EventLoop& loop);
+    // Called on every publish, from whichever thread published
+    void setListener(Listener listener);
+
+    ConfigStats getStats() const;
+
+    // The settings as config file lines, API key masked
+    static std::string format(const RuntimeConfig& config);
+
+private:
+    RcuCell<RuntimeConfig> current_;
+    mutable std::mutex mutex_;  // Serializes writers
+    RuntimeConfig defaults_;
+    std::vector<std::pair<std::string, std::string>> overrides_;  // The file's settings, in file order
+    Listener listener_;
+    std::string path_;
+    std::string watchedName_;  // path_'s file name, as inotify reports it
+    int watchFd_;
+    bool watching_;
+    std::filesystem::file_time_type lastModified_;
+    uint64_t reloads_;
+    uint64_t rejected_;
+
+    bool reloadLocked();
+    void publishLocked();
+    void readEvents();
+    void pollForChanges(EventLoop& loop);
+};
+
+#endif // CONFIG_STORE_H
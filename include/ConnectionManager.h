@@ -0,0 +1,93 @@
+#ifndef CONNECTION_MANAGER_H
+#define CONNECTION_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <curl/curl.h>
+#include "EventLoop.h"
+
+enum class HttpVersion {
+    AUTO,   // HTTP/2 where TLS negotiates it, HTTP/1.1 otherwise
+    HTTP1   // Always HTTP/1.1
+};
+
+struct ConnectionConfig {
+    HttpVersion httpVersion = HttpVersion::AUTO;
+    // Resolve and connect to every upstream host at startup, and ping hosts
+    // that go idle so their connections stay open
+    bool warmup = true;
+    // A host with no request for this long is pinged; libcurl drops
+    // connections idle for about two minutes and servers often sooner
+    std::chrono::seconds pingInterval{25};
+    // Hosts unused for longer than this are left to go cold
+    std::chrono::seconds keepWarmFor{600};
+};
+
+struct ConnectionStats {
+    size_t hosts = 0;
+    uint64_t warmups = 0;      // Startup connections that succeeded
+    uint64_t pings = 0;        // Idle pings that succeeded
+    uint64_t failed = 0;       // Warmups and pings that did not
+};
+
+// Owns what upstream transfers share beyond a multi handle's connection pool:
+// one CURLSH holds the DNS cache, TLS sessions and public suffix list for
+// every handle in the process, whichever thread or multi handle runs it.
+// Connections themselves stay in the event loop's pool, which every
+// asynchronous lookup already uses; libcurl does not support sharing them
+// between threads. Also sets the HTTP version, so concurrent lookups to an
+// HTTP/2 server multiplex over one connection, and keeps the connections to
+// known upstream hosts warm.
+class ConnectionManager {
+public:
+    explicit ConnectionManager(const ConnectionConfig& config = ConnectionConfig());
+    ~ConnectionManager();
+
+    ConnectionManager(const ConnectionManager&) = delete;
+    ConnectionManager& operator=(const ConnectionManager&) = delete;
+
+    // Puts a handle about to fetch url on the share and the configured HTTP
+    // version, and marks url's host as in use. Safe from any thread.
+    void prepare(CURL* handle, const std::string& url);
+    // Connects to the host of each URL on the loop, then keeps them warm; does
+    // nothing when warmup is off. Call once, before lookups start.
+    void start(EventLoop& loop, const std::vector<std::string>& urls);
+
+    const ConnectionConfig& getConfig() const { return config_; }
+    ConnectionStats getStats() const;
+
+    static const char* httpVersionName(HttpVersion version);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Host {
+        std::string origin;  // scheme://host[:port]
+        Clock::time_point lastUsed;
+        bool pinging = false;
+    };
+
+    ConnectionConfig config_;
+    CURLSH* share_;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> shareLocks_;
+
+    mutable std::mutex mutex_;
+    std::vector<Host> hosts_;
+    uint64_t warmups_;
+    uint64_t pings_;
+    uint64_t failed_;
+
+    // The loop's share of the work: connect or ping one host, and the ping timer
+    void connect(EventLoop& loop, size_t host, bool warmup);
+    void schedulePings(EventLoop& loop);
+
+    static std::string originOf(const std::string& url);
+    static void lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void unlock(CURL* handle, curl_lock_data data, void* userp);
+};
+
+#endif // CONNECTION_MANAGER_H
@@ -0,0 +1,164 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <coroutine>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <memory>
+#include <curl/curl.h>
+
+// Invoked on the loop thread when a transfer finishes; the handle is already
+// detached from the loop but not yet returned to the pool
+using TransferCallback = std::function<void(CURL* handle, CURLcode result)>;
+
+// One thread driving every asynchronous transfer in the process. libcurl
+// reports the sockets it needs through curl_multi_socket_action and the loop
+// waits on them with epoll, so the cost of a wakeup does not grow with the
+// number of transfers in flight. Coroutines hop onto the loop with
+// schedule() and are resumed there when their transfers or timers complete.
+//
+// Apart from schedule(), post() and stop(), everything here must be called on
+// the loop thread. The loop must be owned by a std::shared_ptr: its thread
+// holds a reference while it runs, so the last owner may let go from a
+// callback on the loop without freeing it under run().
+class EventLoop : public std::enable_shared_from_this<EventLoop> {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerHandle = std::multimap<Clock::time_point, std::function<void()>>::iterator;
+
+    struct ScheduleAwaiter {
+        EventLoop& loop;
+        bool await_ready() const noexcept { return loop.isLoopThread(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop.post([handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct SleepAwaiter {
+        EventLoop& loop;
+        Clock::time_point until;
+        bool await_ready() const noexcept { return Clock::now() >= until; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop.addTimer(until, [handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    // Suspends one coroutine until notify() is called or a deadline passes.
+    // A notify() that arrives while nobody waits is kept for the next wait.
+    class Wakeup {
+    public:
+        explicit Wakeup(EventLoop& loop) : loop_(loop) {}
+        ~Wakeup();
+
+        struct Awaiter {
+            Wakeup& wakeup;
+            Clock::time_point until;
+            bool await_ready() noexcept;
+            void await_suspend(std::coroutine_handle<> handle);
+            void await_resume() const noexcept {}
+        };
+
+        Awaiter waitUntil(Clock::time_point until) { return Awaiter{*this, until}; }
+        void notify();
+
+    private:
+        EventLoop& loop_;
+        std::coroutine_handle<> waiter_;
+        TimerHandle timer_;
+        bool notified_ = false;
+
+        void resumeWaiter();
+    };
+
+    // Lets one coroutine end another's wait early: cancel() notifies whichever
+    // Wakeup the cancelled side is watching, and it checks isCancelled() when
+    // it resumes. Loop thread only.
+    class CancelToken {
+    public:
+        void cancel();
+        bool isCancelled() const { return cancelled_; }
+        // Sets the wait cancel() interrupts (nullptr for none); returns the previous one
+        Wakeup* watch(Wakeup* wakeup) { return std::exchange(wakeup_, wakeup); }
+
+    private:
+        bool cancelled_ = false;
+        Wakeup* wakeup_ = nullptr;
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Resumes the awaiting coroutine on the loop thread (at once if already there)
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{*this}; }
+    SleepAwaiter sleepUntil(Clock::time_point until) { return SleepAwaiter{*this, until}; }
+    // Runs a function on the loop thread; safe from any thread
+    void post(std::function<void()> function);
+    bool isLoopThread() const { return std::this_thread::get_id() == threadId_.load(); }
+    // Ends the loop thread, dropping posted work, timers and transfers that have
+    // not run. Waits for the thread unless called on it. Safe from any thread.
+    void stop();
+
+    // Starts a configured easy handle; false if it could not be added
+    bool addTransfer(CURL* handle, TransferCallback onDone);
+    // Abandons a transfer without invoking its callback
+    void removeTransfer(CURL* handle);
+    TimerHandle addTimer(Clock::time_point at, std::function<void()> callback);
+    void cancelTimer(TimerHandle timer);
+    // Runs onReadable on the loop whenever fd has input, for as long as the loop
+    // runs; the caller keeps fd open until then. Safe from any thread. Needs
+    // epoll, so false (and nothing watched) elsewhere.
+    bool watchFd(int fd, std::function<void()> onReadable);
+
+    // Reusable easy handles keep their connections warm between transfers
+    CURL* acquireHandle();
+    void releaseHandle(CURL* handle);
+
+    size_t getActiveTransfers() const { return activeTransfers_.load(std::memory_order_relaxed); }
+    // Every connection is busy, so new transfers queue inside libcurl
+    bool isSaturated() const;
+
+private:
+    CURLM* multi_;
+    int epollFd_;
+    int wakeFd_;
+    std::thread thread_;
+    std::atomic<std::thread::id> threadId_;
+    std::once_flag started_;
+    std::atomic<bool> running_;
+
+    std::mutex postMutex_;
+    std::vector<std::function<void()>> posted_;
+
+    std::unordered_map<CURL*, TransferCallback> transfers_;
+    std::multimap<Clock::time_point, std::function<void()>> timers_;
+    std::unordered_map<int, std::function<void()>> watchers_;
+    Clock::time_point curlTimeout_;
+    std::vector<CURL*> handlePool_;
+    std::atomic<size_t> activeTransfers_;
+
+    void ensureStarted();
+    bool initialize();
+    void run();
+    void wake();
+    void runPosted();
+    void runTimers();
+    void completeTransfers();
+    int nextTimeoutMs();
+
+    static int socketCallback(CURL* handle, curl_socket_t socket, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeoutMs, void* userp);
+};
+
+#endif // EVENT_LOOP_H
@@ -0,0 +1,83 @@
+#ifndef FORECAST_STORE_H
+#define FORECAST_STORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// One location's 5-day/3-hour forecast, stored column by column so range
+// aggregates are a linear scan over contiguous arrays. All columns have the
+// same length and are ordered by time.
+struct ForecastSeries {
+    std::string city;
+    std::string country;
+    long cityId = 0;
+    int32_t timezoneOffset = 0;        // Seconds east of UTC
+
+    std::vector<int64_t> time;         // Unix seconds
+    std::vector<float> temperature;
+    std::vector<float> humidity;
+    std::vector<float> windSpeed;
+    std::vector<uint16_t> condition;   // OpenWeatherMap condition code, see ConditionTable
+
+    bool isValid = false;
+
+    size_t size() const { return time.size(); }
+};
+
+struct ForecastSummary {
+    size_t count = 0;
+    float minTemperature = 0.0f;
+    float maxTemperature = 0.0f;
+    float avgTemperature = 0.0f;
+    float avgHumidity = 0.0f;
+    float maxWindSpeed = 0.0f;
+    uint16_t dominantCondition = 0;
+};
+
+// Interns condition descriptions by their numeric code so the series only
+// store two bytes per entry
+class ConditionTable {
+public:
+    void intern(uint16_t code, std::string_view description);
+    std::string describe(uint16_t code);
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<uint16_t, std::string> descriptions_;
+};
+
+class ForecastStore {
+public:
+    explicit ForecastStore(std::chrono::seconds ttl = std::chrono::seconds(1800));
+
+    // Returns nullptr when the key is missing or its forecast has expired
+    std::shared_ptr<const ForecastSeries> get(const std::string& key);
+    void put(const std::string& key, std::shared_ptr<const ForecastSeries> series);
+    void clear();
+
+    ConditionTable& getConditions() { return conditions_; }
+
+    // Aggregates the entries with from <= time < to
+    static ForecastSummary summarize(const ForecastSeries& series, int64_t from, int64_t to);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::shared_ptr<const ForecastSeries> series;
+        Clock::time_point expiresAt;
+    };
+
+    std::chrono::seconds ttl_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    ConditionTable conditions_;
+};
+
+#endif // FORECAST_STORE_H
@@ -0,0 +1,112 @@
+#ifndef GAZETTEER_H
+#define GAZETTEER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+#include "MappedFile.h"
+
+struct GazetteerCity {
+    long id = 0;  // OpenWeatherMap city ID (the GeoNames ID)
+    std::string name;
+    std::string country;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    uint32_t population = 0;
+};
+
+// On-disk layout of the compiled gazetteer. The file is a header followed by
+// the city records, the name trie, the trie's city entries, the grid cells and
+// the string table, each section 4-byte aligned.
+struct GazetteerHeader {
+    char magic[8];
+    uint32_t cityCount;
+    uint32_t nodeCount;
+    uint32_t entryCount;
+    uint32_t cellCount;
+    uint32_t stringBytes;
+    uint32_t reserved;
+};
+
+struct GazetteerRecord {
+    uint32_t id;
+    uint32_t nameOffset;  // Display name in the string table
+    uint32_t population;
+    float latitude;
+    float longitude;
+    uint16_t nameLength;
+    char country[2];
+};
+
+// Trie nodes are stored in depth-first order: a node's first child follows it
+// directly, and its whole subtree's city entries are one contiguous range
+// ordered by population within each name.
+struct GazetteerNode {
+    uint32_t nextSibling;  // 0 for the last child (the root is never a sibling)
+    uint32_t entryBegin;   // Cities named exactly by this node start here
+    uint32_t exactEnd;     // ...and end here
+    uint32_t subtreeEnd;   // End of the entries for every name below this node
+    uint8_t label;
+    uint8_t hasChildren;
+    uint16_t reserved;
+};
+
+// One city in one geohash cell; cells are sorted by hash
+struct GazetteerCell {
+    uint32_t cell;
+    uint32_t city;
+};
+
+static_assert(sizeof(GazetteerHeader) == 32, "GazetteerHeader layout must stay fixed");
+static_assert(sizeof(GazetteerRecord) == 24, "GazetteerRecord layout must stay fixed");
+static_assert(sizeof(GazetteerNode) == 20, "GazetteerNode layout must stay fixed");
+static_assert(sizeof(GazetteerCell) == 8, "GazetteerCell layout must stay fixed");
+static_assert(std::is_trivially_copyable<GazetteerNode>::value, "Gazetteer sections are written with fwrite");
+
+// Offline index of known cities, compiled once from a GeoNames-style TSV and
+// memory-mapped at startup. Resolves free-form city names (case- and
+// whitespace-insensitive, optionally suffixed with ",CC") to canonical city
+// IDs through a byte trie, and snaps coordinates to the nearest city through
+// a geohash grid. Read-only once opened, so it is shared without locking.
+class Gazetteer {
+public:
+    Gazetteer();
+    ~Gazetteer();
+
+    // Builds a gazetteer file from a GeoNames dump (cities15000.txt and friends)
+    // or from "id<TAB>name<TAB>country<TAB>lat<TAB>lon[<TAB>population]" lines
+    static bool compile(const std::string& tsvPath, const std::string& outputPath);
+
+    bool open(const std::string& path);
+    bool isLoaded() const { return header_ != nullptr; }
+    size_t size() const { return isLoaded() ? header_->cityCount : 0; }
+
+    // Most populous city with exactly this name (within the country, if given)
+    bool resolve(std::string_view name, GazetteerCity& city) const;
+    // Cities whose name starts with prefix, most populous first
+    std::vector<GazetteerCity> complete(std::string_view prefix, size_t limit) const;
+    // Closest city within maxDistanceKm
+    bool nearest(double latitude, double longitude, double maxDistanceKm, GazetteerCity& city) const;
+
+    // Lowercase with runs of whitespace collapsed to one space and trimmed
+    static std::string normalize(std::string_view name);
+
+private:
+    std::unique_ptr<MappedFile> file_;
+    const GazetteerHeader* header_;
+    const GazetteerRecord* records_;
+    const GazetteerNode* nodes_;
+    const uint32_t* entries_;
+    const GazetteerCell* cells_;
+    const char* strings_;
+
+    bool validate() const;
+    // Index of the trie node spelling key, or -1
+    long findNode(std::string_view key) const;
+    GazetteerCity cityAt(uint32_t index) const;
+};
+
+#endif // GAZETTEER_H
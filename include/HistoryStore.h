@@ -0,0 +1,133 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include "WeatherData.h"
+
+// On-disk header of one compressed block; the payload follows it directly
+struct HistoryBlockHeader {
+    uint32_t magic;
+    uint32_t count;         // Samples in the block
+    uint32_t payloadBytes;
+    uint32_t reserved;
+    int64_t firstTime;      // Unix seconds of the first and last sample
+    int64_t lastTime;
+    uint64_t checksum;      // FNV-1a of the payload
+};
+
+static_assert(sizeof(HistoryBlockHeader) == 40, "HistoryBlockHeader layout must stay fixed");
+static_assert(std::is_trivially_copyable<HistoryBlockHeader>::value, "HistoryBlockHeader is written with fwrite");
+
+struct HistorySample {
+    int64_t time = 0;  // Unix seconds
+    float temperature = 0.0f;
+    float humidity = 0.0f;
+    float windSpeed = 0.0f;
+};
+
+struct HistoryRange {
+    float min = 0.0f;
+    float max = 0.0f;
+    double sum = 0.0;
+
+    float mean(size_t count) const { return count > 0 ? static_cast<float>(sum / static_cast<double>(count)) : 0.0f; }
+};
+
+struct HistorySummary {
+    size_t count = 0;
+    int64_t firstTime = 0;
+    int64_t lastTime = 0;
+    HistoryRange temperature;
+    HistoryRange humidity;
+    HistoryRange windSpeed;
+    size_t blocksRead = 0;     // Decoded
+    size_t blocksSkipped = 0;  // Entirely outside the range, never decoded
+};
+
+struct HistoryStats {
+    size_t locations = 0;         // Files in the directory
+    uint64_t diskBytes = 0;
+    uint64_t pending = 0;         // Samples still in open blocks
+    uint64_t writtenSamples = 0;  // Written in blocks since startup
+    uint64_t writtenBytes = 0;    // Headers included
+};
+
+// Appends every fetched observation to a per-location time series under one
+// directory, one file per city and country. Samples are packed into blocks
+// Gorilla-style: timestamps as delta-of-delta, and temperature, humidity and
+// wind as the XOR of each float with the previous one, so a slowly changing
+// series takes a few bits per value. Each location keeps its open block in
+// memory until it holds BLOCK_SAMPLES samples or flush() is called; queries
+// stream the file one block at a time and skip blocks outside the range.
+class HistoryStore {
+public:
+    static const size_t BLOCK_SAMPLES = 128;
+
+    explicit HistoryStore(const std::string& directory);
+    ~HistoryStore();
+
+    // False if the directory cannot be created
+    bool open();
+    void append(const WeatherData& data);
+    void append(const WeatherData& data, int64_t time);
+    // Writes every open block, so a restart loses nothing
+    void flush();
+
+    // Calls visit for each sample of the location with since <= time < until,
+    // in time order; false if the location has no history
+    bool scan(const std::string& location, int64_t since, int64_t until,
+              const std::function<void(const HistorySample&)>& visit, HistorySummary* blocks = nullptr);
+    bool summarize(const std::string& location, int64_t since, int64_t until, HistorySummary& summary);
+    // Locations matching "city" or "city,country", case-insensitively, as "city,country" keys
+    std::vector<std::string> findLocations(std::string_view query);
+    HistoryStats getStats();
+
+    const std::string& getDirectory() const { return directory_; }
+
+    // "city,country" in lowercase, the key a location is stored under
+    static std::string locationKey(std::string_view city, std::string_view country);
+
+private:
+    // Encoder state of a block still being filled
+    struct OpenBlock {
+        std::vector<uint8_t> payload;
+        uint64_t bitBuffer = 0;
+        unsigned bitCount = 0;
+        uint32_t count = 0;
+        int64_t firstTime = 0;
+        int64_t lastTime = 0;
+        int64_t lastDelta = 0;
+        uint32_t lastBits[3] = {};
+        unsigned leading[3] = {};
+        unsigned trailing[3] = {};
+    };
+
+    std::string directory_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, OpenBlock> open_;
+    std::unordered_set<std::string> recovered_;  // Files whose torn tail has been checked this run
+    uint64_t writtenSamples_;
+    uint64_t writtenBytes_;
+
+    std::string pathFor(const std::string& location) const;
+    void writeBlockLocked(const std::string& location, OpenBlock& block);
+    void recoverLocked(const std::string& location);
+
+    static void encode(OpenBlock& block, int64_t time, const float values[3]);
+    // The block as it would be written, leaving it open
+    static void seal(const OpenBlock& block, HistoryBlockHeader& header, std::vector<uint8_t>& payload);
+    static void decode(const HistoryBlockHeader& header, const std::vector<uint8_t>& payload,
+                       const std::function<void(const HistorySample&)>& visit);
+    static uint64_t checksum(const std::vector<uint8_t>& payload);
+};
+
+#endif // HISTORY_STORE_H
@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of a whole file, memory-mapped where available (read into
+// memory on Windows). data() is nullptr if the file is missing or empty.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+#ifdef _WIN32
+    std::vector<char> buffer_;
+#endif
+};
+
+#endif // MAPPED_FILE_H
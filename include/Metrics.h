@@ -0,0 +1,107 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <curl/curl.h>
+
+enum class Stage {
+    DNS,
+    CONNECT,
+    TLS,
+    TIME_TO_FIRST_BYTE,
+    TRANSFER,
+    UPSTREAM,  // One whole upstream attempt
+    PARSE,
+    FORMAT,
+    COMMAND,
+    COUNT
+};
+
+enum class UpstreamEvent {
+    RETRY,
+    HEDGE,
+    HEDGE_WON,         // The hedged attempt answered first
+    BREAKER_REJECTED,  // Failed fast because the endpoint's circuit breaker was open
+    STALE_SERVED,      // An expired result was served instead of a fresh one
+    THROTTLED,         // Upstream answered 429 Too Many Requests
+    RATE_LIMITED,      // Gave up waiting for a rate limiter token
+    FAILOVER,          // Asked the next weather provider after one could not answer
+    RACE,              // Sent a lookup to two providers at once
+    COUNT
+};
+
+// Lock-free latency histogram with fixed, roughly logarithmic buckets (seconds)
+class Histogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 17;
+    static const std::array<double, BUCKET_COUNT - 1> BOUNDS;
+
+    void observe(double seconds);
+    uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+    double getSum() const;
+    uint64_t getBucket(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    double quantile(double q) const;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sumMicros_{0};
+};
+
+class Metrics {
+public:
+    Metrics();
+
+    void observe(Stage stage, double seconds);
+    void observe(Stage stage, std::chrono::steady_clock::duration elapsed);
+    // Records connection timings, the HTTP status and any curl error for a finished transfer
+    void recordTransfer(CURL* handle, CURLcode result);
+    void recordEvent(UpstreamEvent event);
+
+    const Histogram& getHistogram(Stage stage) const { return histograms_[static_cast<size_t>(stage)]; }
+    uint64_t getRequestCount() const { return requests_.load(); }
+    uint64_t getConnectionCount() const { return connections_.load(std::memory_order_relaxed); }
+    uint64_t getHttp2Count() const { return http2Requests_.load(std::memory_order_relaxed); }
+    uint64_t getEventCount(UpstreamEvent event) const {
+        return events_[static_cast<size_t>(event)].load(std::memory_order_relaxed);
+    }
+
+    std::string formatSummary() const;
+    std::string formatPrometheus() const;
+
+    static const char* stageName(Stage stage);
+    static const char* eventName(UpstreamEvent event);
+
+private:
+    static constexpr size_t MAX_HTTP_STATUS = 600;
+
+    std::array<Histogram, static_cast<size_t>(Stage::COUNT)> histograms_;
+    std::array<std::atomic<uint64_t>, CURL_LAST> curlErrors_{};
+    std::array<std::atomic<uint64_t>, MAX_HTTP_STATUS> httpStatus_{};
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(UpstreamEvent::COUNT)> events_{};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> connections_{0};    // New connections transfers had to open
+    std::atomic<uint64_t> http2Requests_{0};
+};
+
+// Records the lifetime of the enclosing scope into a stage histogram
+class StageTimer {
+public:
+    StageTimer(Metrics& metrics, Stage stage)
+        : metrics_(metrics), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    ~StageTimer() { metrics_.observe(stage_, std::chrono::steady_clock::now() - start_); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    Metrics& metrics_;
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // METRICS_H
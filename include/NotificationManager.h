@@ -2,9 +2,16 @@
 #define NOTIFICATION_MANAGER_H
 
 #include <string>
-#include <vector>
+#include <string_view>
 #include <chrono>
 #include <memory>
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
 
 enum class NotificationType {
     INFO,
@@ -13,28 +20,76 @@ enum class NotificationType {
     SUCCESS
 };
 
+// Fixed-size record so the history never allocates; longer messages are truncated
 struct Notification {
-    std::string message;
-    NotificationType type;
+    static constexpr size_t MAX_MESSAGE_BYTES = 230;
+
     std::chrono::system_clock::time_point timestamp;
+    NotificationType type;
+    uint16_t length;
+    char text[MAX_MESSAGE_BYTES];
+
+    std::string_view message() const { return std::string_view(text, length); }
 };
 
+enum class NotificationOutput {
+    SYNCHRONOUS,  // Written to the stream by the caller (e.g. per-session buffers)
+    BACKGROUND    // Written and flushed in batches by a writer thread (console)
+};
+
+// Keeps the most recent notifications in a bounded lock-free ring buffer.
+// Any thread may post; the history can be read while others are posting.
 class NotificationManager {
 public:
-    NotificationManager();
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    explicit NotificationManager(std::ostream& out = std::cout,
+                                 NotificationOutput output = NotificationOutput::SYNCHRONOUS,
+                                 size_t capacity = DEFAULT_CAPACITY);
     ~NotificationManager();
-    
-    void showNotification(const std::string& message, NotificationType type = NotificationType::INFO);
-    void showWeatherAlert(const std::string& city, const std::string& condition);
+
+    NotificationManager(const NotificationManager&) = delete;
+    NotificationManager& operator=(const NotificationManager&) = delete;
+
+    void showNotification(std::string_view message, NotificationType type = NotificationType::INFO);
+    void showWeatherAlert(std::string_view city, std::string_view condition);
     void displayNotifications();
     void clearNotifications();
-    
+    // Writes out anything still queued for the background writer, so it appears
+    // before output the caller is about to print directly
+    void sync();
+    // Visits the retained history, oldest first
+    void forEachNotification(const std::function<void(const Notification&)>& visit);
+
 private:
-    std::vector<Notification> notifications_;
+    struct Slot {
+        // Seqlock: 2 * position + 1 while being written, 2 * position + 2 once complete
+        std::atomic<uint64_t> sequence{0};
+        Notification notification;
+    };
+
+    std::ostream& out_;
+    NotificationOutput output_;
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> historyStart_{0};
+
+    std::mutex outputMutex_;  // Guards out_ and written_
+    uint64_t written_ = 0;
+
+    std::mutex writerMutex_;
+    std::condition_variable writerWakeup_;
+    bool stopping_ = false;
+    std::thread writer_;
+
+    bool readSlot(uint64_t position, Notification& notification) const;
+    void drainLocked();
+    void writerLoop();
+    void printNotification(const Notification& notification);
     std::string getNotificationSymbol(NotificationType type);
     std::string getNotificationColor(NotificationType type);
     void printColored(const std::string& text, const std::string& color);
 };
 
 #endif // NOTIFICATION_MANAGER_H
-
@@ -0,0 +1,95 @@
+#ifndef PREFETCH_SCHEDULER_H
+#define PREFETCH_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include "WeatherService.h"
+#include "AlertEngine.h"
+
+struct PrefetchConfig {
+    double refreshFraction = 0.8;     // Refresh after this fraction of the cache TTL
+    double jitterFraction = 0.1;      // Spread refreshes by ±10% of the interval
+    double requestsPerMinute = 30.0;  // Cap on background refreshes, within the shared RateLimiter quota
+    std::chrono::seconds retryDelay{30};
+    std::chrono::milliseconds tick{1000};
+    size_t wheelSlots = 512;
+};
+
+// Keeps watched locations fresh in the background. Refreshes are kept on a
+// hashed timer wheel and run ahead of cache expiry, with jitter and a global
+// requests-per-minute budget. Also refreshes results that were just served
+// stale, ahead of the wheel but within the same budget. The alerts each
+// refresh cycle raises are published to the context's dispatcher as one batch.
+class PrefetchScheduler {
+public:
+    PrefetchScheduler(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context,
+                      const PrefetchConfig& config = PrefetchConfig());
+    ~PrefetchScheduler();
+
+    bool watch(const std::string& city);
+    bool unwatch(const std::string& city);
+    std::vector<std::string> getWatched();
+    // Latest refreshed result for a watched city, if it is still within the TTL
+    bool lookup(const std::string& city, WeatherData& data);
+    // Queues a one-off refresh; duplicates of a pending query are ignored
+    void revalidate(const WeatherQuery& query);
+
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct WatchedLocation {
+        std::string city;
+        uint64_t generation;
+        WeatherData latest;
+        Clock::time_point refreshedAt;
+    };
+
+    struct WheelEntry {
+        std::string key;
+        uint64_t generation;
+        size_t rounds;
+    };
+
+    PrefetchConfig config_;
+    std::unique_ptr<WeatherService> weatherService_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::thread thread_;
+    bool running_;
+    bool started_;
+
+    std::unordered_map<std::string, WatchedLocation> watched_;
+    std::vector<std::vector<WheelEntry>> wheel_;
+    size_t cursor_;
+    uint64_t nextGeneration_;
+    std::deque<WeatherQuery> revalidations_;
+    std::unordered_set<std::string> pendingRevalidations_;  // Cache keys of queued revalidations
+    bool revalidationQueued_;
+    double tokens_;
+    Clock::time_point lastRefill_;
+    std::mt19937 random_;
+
+    void run();
+    void startLocked();
+    void raiseAlerts();
+    void scheduleLocked(const std::string& key, uint64_t generation, Clock::duration delay);
+    Clock::duration jittered(Clock::duration interval);
+    bool takeTokenLocked();
+    bool refresh(const std::string& key, uint64_t generation);
+};
+
+#endif // PREFETCH_SCHEDULER_H
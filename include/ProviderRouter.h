@@ -0,0 +1,88 @@
+#ifndef PROVIDER_ROUTER_H
+#define PROVIDER_ROUTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "WeatherProvider.h"
+#include "CircuitBreaker.h"
+
+struct ProviderRoutingConfig {
+    // Start the two best providers together and take the first valid answer.
+    // The second request only goes out on spare rate limiter quota.
+    bool race = false;
+    double latencyWeight = 0.2;  // EWMA weight of each new latency sample
+    // Every this many routed lookups the runner-up goes first, so a provider
+    // that was slow once is measured again; 0 never explores
+    uint64_t exploreEvery = 50;
+};
+
+struct ProviderStats {
+    std::string name;
+    double latencyMs = 0.0;  // EWMA of answered requests
+    uint64_t samples = 0;
+    uint64_t answered = 0;   // Valid observations
+    uint64_t failed = 0;     // Errors, timeouts and unusable answers
+    uint64_t raceWins = 0;
+    BreakerState breaker = BreakerState::CLOSED;
+};
+
+// Chooses which WeatherProvider answers a lookup. Tracks an exponentially
+// weighted moving average of each provider's latency and puts the fastest
+// healthy one first, with providers whose circuit breaker is open last;
+// WeatherService fails over along that order. Each provider has its own
+// breaker. Safe from any thread.
+class ProviderRouter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ProviderRouter(const ProviderRoutingConfig& config = ProviderRoutingConfig());
+
+    // Registration order breaks ties, so the first provider is preferred until
+    // others have been measured; a null breaker gets a fresh one
+    void add(std::shared_ptr<WeatherProvider> provider, std::shared_ptr<CircuitBreaker> breaker = nullptr);
+    size_t size() const { return slots_.size(); }
+    const WeatherProvider& provider(size_t index) const { return *slots_[index].provider; }
+    WeatherProvider& provider(size_t index) { return *slots_[index].provider; }
+    CircuitBreaker& breaker(size_t index) const { return *slots_[index].breaker; }
+    // Index of the provider with this name or alias, or -1
+    long find(std::string_view name) const;
+
+    // Providers able to answer the query, best first: only the requested one
+    // when the query names a provider
+    std::vector<size_t> route(const WeatherQuery& query);
+
+    void recordAnswer(size_t index, Clock::duration latency, bool valid);
+    void recordFailure(size_t index, Clock::duration elapsed);
+    // Lost a race and was abandoned after elapsed: at least that slow
+    void recordAbandoned(size_t index, Clock::duration elapsed);
+    void recordRaceWin(size_t index);
+
+    bool isRacing() const { return config_.race; }
+    const ProviderRoutingConfig& getConfig() const { return config_; }
+    std::vector<ProviderStats> getStats() const;
+
+private:
+    struct Slot {
+        std::shared_ptr<WeatherProvider> provider;
+        std::shared_ptr<CircuitBreaker> breaker;
+        double latencyMs = 0.0;
+        uint64_t samples = 0;
+        uint64_t answered = 0;
+        uint64_t failed = 0;
+        uint64_t raceWins = 0;
+    };
+
+    ProviderRoutingConfig config_;
+    mutable std::mutex mutex_;
+    std::vector<Slot> slots_;  // Fixed once lookups start
+    uint64_t routed_;
+
+    void sampleLocked(Slot& slot, Clock::duration latency);
+};
+
+#endif // PROVIDER_ROUTER_H
@@ -0,0 +1,138 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "EventLoop.h"
+#include "Task.h"
+
+// Who is waiting on an upstream request; lower values are served first
+enum class RequestPriority {
+    INTERACTIVE,  // A user is waiting for the answer
+    BACKGROUND,   // Prefetch refreshes and stale-result revalidation
+    BATCH,        // --batch jobs
+    COUNT
+};
+
+struct RateLimitConfig {
+    // Sustained rate; 0 disables the limiter. With the default burst no 60-second
+    // window sees more than 60 requests, the free plan's per-minute quota
+    double requestsPerMinute = 55.0;
+    double burst = 5.0;
+    uint64_t requestsPerDay = 0;      // 0 for no daily quota; the count restarts at midnight UTC
+    // Tokens that background and batch work leave in the bucket, so an
+    // interactive query does not queue behind them
+    double interactiveReserve = 1.0;
+    // How long each priority may wait for a token before the request fails
+    // (and a stale result is served, if there is one); 0 waits indefinitely
+    std::array<std::chrono::milliseconds, static_cast<size_t>(RequestPriority::COUNT)> maxQueueDelay{
+        std::chrono::milliseconds(5000), std::chrono::milliseconds(60000), std::chrono::milliseconds(0)};
+    // A 429 halves the rate, down to this fraction of requestsPerMinute; each
+    // successful request then wins back a twentieth of the configured rate
+    double minRateFraction = 0.1;
+
+    bool operator==(const RateLimitConfig&) const = default;
+};
+
+struct RateLimiterStats {
+    bool enabled = false;
+    double tokens = 0.0;
+    double requestsPerMinute = 0.0;   // Current rate, below the configured one after a 429
+    bool paused = false;              // Holding off until an upstream Retry-After passes
+    uint64_t usedToday = 0;
+    uint64_t granted = 0;
+    uint64_t expired = 0;             // Gave up waiting for a token
+    uint64_t throttled = 0;           // 429 responses seen
+    std::array<size_t, static_cast<size_t>(RequestPriority::COUNT)> queued{};
+};
+
+// Token bucket shared by every upstream request in the process, with a
+// priority queue in front of it. Requests that find no token wait in order of
+// priority, each up to its own deadline, instead of failing; expired waiters
+// never consume a token. 429 responses and their Retry-After header pause the
+// bucket and lower its rate until requests succeed again.
+//
+// acquire() must be called on the event loop thread; the other methods are
+// safe from any thread.
+class RateLimiter {
+public:
+    using Clock = EventLoop::Clock;
+
+    explicit RateLimiter(const RateLimitConfig& config = RateLimitConfig());
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    // Waits for a token behind every queued request of the same or higher
+    // priority; false if none was granted by `until`, the priority's queue limit
+    // or the time cancel (if given) is cancelled
+    Task<bool> acquire(EventLoop& loop, RequestPriority priority, Clock::time_point until = Clock::time_point::max(),
+                       EventLoop::CancelToken* cancel = nullptr);
+    // Takes a token only if one is free now and no request of the same or higher priority is queued
+    bool tryAcquire(RequestPriority priority);
+    // Returns a token that was acquired but not spent on a request
+    void release();
+    // Time until tryAcquire could succeed, assuming nobody else takes a token first
+    Clock::duration nextAvailableIn(RequestPriority priority);
+    // When a request of this priority that starts waiting now gives up
+    Clock::time_point queueDeadline(RequestPriority priority, Clock::time_point now) const;
+
+    // Upstream answered 429: grant nothing until retryAfter has passed and halve the rate
+    void onThrottled(std::chrono::seconds retryAfter);
+    void onSuccess();
+
+    // Takes on a new rate, burst, quota and queue limits at once; requests
+    // already queued are re-timed on the loop. Today's count is kept.
+    void reconfigure(const RateLimitConfig& config, EventLoop& loop);
+
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    RateLimitConfig getConfig() const;
+    RateLimiterStats getStats();
+
+    static const char* priorityName(RequestPriority priority);
+
+private:
+    static constexpr size_t PRIORITY_COUNT = static_cast<size_t>(RequestPriority::COUNT);
+
+    struct Waiter {
+        EventLoop::Wakeup* wakeup;
+        bool granted = false;
+    };
+
+    RateLimitConfig config_;
+    std::atomic<bool> enabled_;
+    mutable std::mutex mutex_;
+    double tokens_;
+    double rate_;                  // Tokens per second
+    Clock::time_point lastRefill_;
+    Clock::time_point pausedUntil_;
+    int64_t day_;                  // Days since the epoch (UTC) that usedToday_ counts
+    uint64_t usedToday_;
+    std::array<std::deque<Waiter*>, PRIORITY_COUNT> queues_;
+    uint64_t granted_;
+    uint64_t expired_;
+    uint64_t throttled_;
+
+    // Only touched on the loop thread
+    bool timerArmed_;
+    Clock::time_point timerAt_;
+    EventLoop::TimerHandle timer_;
+
+    void applyLocked(const RateLimitConfig& config);
+    void refillLocked(Clock::time_point now);
+    Clock::time_point queueDeadlineLocked(RequestPriority priority, Clock::time_point now) const;
+    double reserveFor(RequestPriority priority) const;
+    bool queuedAheadLocked(RequestPriority priority) const;
+    bool availableLocked(RequestPriority priority, Clock::time_point now) const;
+    Clock::time_point nextAvailableLocked(RequestPriority priority, Clock::time_point now) const;
+    void takeLocked();
+    // Grants tokens to queued requests in priority order, then sleeps until the next can be served
+    void dispatch(EventLoop& loop);
+    void armLocked(EventLoop& loop, Clock::time_point now);
+};
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,45 @@
+#ifndef RCU_CELL_H
+#define RCU_CELL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// One value that any number of threads read without locking while a writer
+// now and then replaces it. A reader gets a complete version, never half of
+// an update, and keeps reading that version for as long as it holds the
+// reference. Old versions are never reclaimed (as SymbolTable never removes
+// symbols), which makes a grace period unnecessary; meant for settings that
+// change a handful of times in a process's life, not for data.
+template <typename T>
+class RcuCell {
+public:
+    explicit RcuCell(T value = T()) { publish(std::move(value)); }
+
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    // Valid until the cell is destroyed, whatever is published meanwhile
+    const T& get() const { return *current_.load(std::memory_order_acquire); }
+
+    // Makes value the version later get() calls see
+    const T& publish(T value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        versions_.push_back(std::make_unique<const T>(std::move(value)));
+        current_.store(versions_.back().get(), std::memory_order_release);
+        return *versions_.back();
+    }
+
+    size_t versionCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return versions_.size();
+    }
+
+private:
+    std::atomic<const T*> current_{nullptr};
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<const T>> versions_;
+};
+
+#endif // RCU_CELL_H
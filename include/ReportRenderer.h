@@ -0,0 +1,43 @@
+#ifndef REPORT_RENDERER_H
+#define REPORT_RENDERER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "WeatherData.h"
+
+enum class ReportStyle {
+    BOX,      // Framed report for the interactive prompt
+    COMPACT,  // One line per observation
+    JSON      // One object per line, in the fields and number format of --batch NDJSON
+};
+
+// Renders observations without streams or temporary strings. The frame of
+// each style is built once per process; numbers go through std::to_chars and
+// everything is appended to a buffer the caller owns, so a caller that keeps
+// its buffer renders without allocating once it has grown. The style is a
+// template argument and each one is compiled as its own function.
+class ReportRenderer {
+public:
+    // Appends the report to out; an invalid observation renders as an error
+    template <ReportStyle Style>
+    static void render(const WeatherData& data, std::string& out);
+    static void render(ReportStyle style, const WeatherData& data, std::string& out);
+
+    // Terminal columns UTF-8 text takes up: combining marks take none, East Asian
+    // wide characters and emoji two. Malformed bytes count one column each.
+    static size_t displayWidth(std::string_view text);
+    // Length of the longest prefix of text that fits in columns, ending on a code point
+    static size_t fitWidth(std::string_view text, size_t columns);
+
+    // Shortest form that reads back as the same float, so 12.47f prints as 12.47
+    static void appendNumber(std::string& out, float value);
+    static void appendNumber(std::string& out, int64_t value);
+    static void appendJsonString(std::string& out, std::string_view text);
+};
+
+extern template void ReportRenderer::render<ReportStyle::BOX>(const WeatherData&, std::string&);
+extern template void ReportRenderer::render<ReportStyle::COMPACT>(const WeatherData&, std::string&);
+extern template void ReportRenderer::render<ReportStyle::JSON>(const WeatherData&, std::string&);
+
+#endif // REPORT_RENDERER_H
@@ -0,0 +1,40 @@
+#ifndef REQUEST_COALESCER_H
+#define REQUEST_COALESCER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <coroutine>
+#include <atomic>
+#include <cstdint>
+#include "WeatherData.h"
+#include "Task.h"
+
+// Single-flight guard: the first lookup for a key runs the fetch, concurrent
+// lookups for the same key suspend until it publishes its result instead of
+// issuing their own request. Only used on the event loop thread, so the
+// in-flight table needs no lock.
+class RequestCoalescer {
+public:
+    RequestCoalescer();
+    ~RequestCoalescer();
+
+    Task<WeatherData> run(std::string key, std::function<Task<WeatherData>()> fetch);
+
+    uint64_t getLeaderCount() const { return leaders_.load(); }
+    uint64_t getCoalescedCount() const { return coalesced_.load(); }
+
+private:
+    struct Flight {
+        std::vector<std::coroutine_handle<>> waiters;
+        WeatherData result;
+    };
+
+    std::unordered_map<std::string, std::shared_ptr<Flight>> inFlight_;
+    std::atomic<uint64_t> leaders_{0};
+    std::atomic<uint64_t> coalesced_{0};
+};
+
+#endif // REQUEST_COALESCER_H
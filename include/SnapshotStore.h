@@ -0,0 +1,82 @@
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <type_traits>
+#include "WeatherData.h"
+#include "WeatherCache.h"
+
+// On-disk layout of one cached result. Strings are stored once in a separate
+// string table file and referenced by byte offset.
+struct SnapshotRecord {
+    uint32_t keyOffset;
+    uint32_t cityOffset;
+    uint32_t countryOffset;
+    uint32_t descriptionOffset;
+    uint32_t iconOffset;
+    uint32_t reserved;
+    int64_t fetchedAtMs;  // Unix epoch milliseconds
+    double temperature;
+    double feelsLike;
+    double humidity;
+    double windSpeed;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(SnapshotRecord) == 72, "SnapshotRecord layout must stay fixed");
+static_assert(std::is_trivially_copyable<SnapshotRecord>::value, "SnapshotRecord is written with fwrite");
+
+// Persists fetched results across restarts. Records and strings are appended
+// to two files (<path> and <path>.strings); on startup both are memory-mapped
+// and replayed into the cache. The files are rewritten without superseded or
+// expired records once they grow well beyond the live set.
+class SnapshotStore {
+public:
+    SnapshotStore(const std::string& path, std::chrono::seconds ttl);
+    ~SnapshotStore();
+
+    // Loads unexpired records into the cache and opens the files for appending
+    size_t loadInto(WeatherCache& cache);
+    void append(const std::string& key, const WeatherData& data);
+    void compact();
+
+    size_t getRecordCount() const { return recordCount_; }
+
+private:
+    using Clock = std::chrono::system_clock;
+
+    struct LiveEntry {
+        WeatherData data;
+        int64_t fetchedAtMs;
+    };
+
+    std::string path_;
+    std::string stringsPath_;
+    std::chrono::seconds ttl_;
+
+    std::mutex mutex_;
+    std::FILE* records_;
+    std::FILE* strings_;
+    uint32_t stringsSize_;
+    size_t recordCount_;
+    std::unordered_map<std::string, uint32_t> stringOffsets_;
+    std::unordered_map<std::string, LiveEntry> live_;
+
+    bool openForAppend();
+    void closeFiles();
+    uint32_t internString(std::string_view text);
+    void writeRecordLocked(const std::string& key, const LiveEntry& entry);
+    void compactLocked();
+    bool isExpired(int64_t fetchedAtMs, int64_t nowMs) const;
+
+    static int64_t nowMs();
+    static uint64_t checksum(const SnapshotRecord& record);
+};
+
+#endif // SNAPSHOT_STORE_H
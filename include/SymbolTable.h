@@ -0,0 +1,53 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string_view>
+#include <unordered_map>
+#include <memory_resource>
+#include <shared_mutex>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+using Symbol = uint32_t;
+
+// Interns strings that repeat across many results (city names, country
+// codes, condition descriptions, icon codes) and hands out small integer IDs
+// for them. Symbols are never removed, so a view returned by lookup() stays
+// valid as long as the table. Symbol 0 is always the empty string.
+//
+// lookup() takes no lock; intern() takes a shared lock when the string is
+// already known and an exclusive one only to add it.
+class SymbolTable {
+public:
+    SymbolTable();
+    ~SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // The table behind WeatherData's strings
+    static SymbolTable& global();
+
+    // Returns 0 for the empty string, or if the table is full
+    Symbol intern(std::string_view text);
+    std::string_view lookup(Symbol symbol) const;
+
+    size_t size() const { return count_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr size_t CHUNK_BITS = 12;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+    static constexpr size_t MAX_CHUNKS = 4096;
+
+    mutable std::shared_mutex mutex_;
+    std::pmr::monotonic_buffer_resource text_;  // Interned characters, released with the table
+    std::unordered_map<std::string_view, Symbol> index_;
+    // Chunks never move once published, so readers index them without locking
+    std::array<std::atomic<std::string_view*>, MAX_CHUNKS> chunks_;
+    std::atomic<size_t> count_;
+};
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,269 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <iostream>
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    // Resumes whoever awaited the task, without growing the stack
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+    T take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+
+    void take() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+// Fire-and-forget coroutine that frees itself when it finishes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Unhandled exception in background task: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "Error: Unhandled exception in background task" << std::endl;
+            }
+        }
+    };
+};
+
+} // namespace detail
+
+// Lazily started coroutine producing a T. Nothing runs until the task is
+// awaited (or handed to startDetached/syncWait); the awaiting coroutine is
+// resumed on whichever thread the task completes on.
+//
+// Await tasks through a named variable (Task<T> t = f(); co_await t;) rather
+// than as a temporary: GCC 12 can destroy temporaries that live across a
+// co_await twice.
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+    Task() = default;
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().take(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+inline DetachedTask runDetached(Task<void> task) {
+    co_await task;
+}
+
+// Lives on the stack of the thread blocked in syncWait
+template <typename T>
+struct SyncWaitState {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::optional<T> value;
+    std::exception_ptr exception;
+};
+
+template <>
+struct SyncWaitState<void> {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::exception_ptr exception;
+};
+
+template <typename T>
+DetachedTask driveSyncWait(Task<T> task, SyncWaitState<T>& state) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+        } else {
+            state.value.emplace(co_await task);
+        }
+    } catch (...) {
+        state.exception = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.done = true;
+    state.finished.notify_one();
+}
+
+template <typename T>
+struct WhenAllState {
+    std::vector<std::optional<T>> results;
+    std::vector<std::exception_ptr> errors;
+    std::atomic<size_t> remaining;
+    std::coroutine_handle<> continuation;
+};
+
+// Records one result; whoever finishes last (counting the parent) resumes the parent
+template <typename T>
+Task<void> whenAllChild(Task<T> task, std::shared_ptr<WhenAllState<T>> state, size_t index) {
+    try {
+        state->results[index].emplace(co_await task);
+    } catch (...) {
+        state->errors[index] = std::current_exception();
+    }
+    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        state->continuation.resume();
+    }
+}
+
+} // namespace detail
+
+// Starts a task on the calling thread; it runs until it first suspends and
+// finishes wherever it is resumed. Exceptions are logged and dropped.
+inline void startDetached(Task<void> task) {
+    detail::runDetached(std::move(task));
+}
+
+// Runs a task to completion, blocking the calling thread. Must not be called
+// on the thread the task needs to make progress (e.g. the event loop thread).
+template <typename T>
+T syncWait(Task<T> task) {
+    detail::SyncWaitState<T> state;
+    detail::driveSyncWait(std::move(task), state);
+    {
+        // Tasks that never suspend are already done here
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.finished.wait(lock, [&state] { return state.done; });
+    }
+    if (state.exception) {
+        std::rethrow_exception(state.exception);
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*state.value);
+    }
+}
+
+// Awaits every task concurrently; results are returned in input order and the
+// first failure (by index) is rethrown once all of them have finished
+template <typename T>
+Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks) {
+    struct Awaiter {
+        std::vector<Task<T>>& tasks;
+        std::shared_ptr<detail::WhenAllState<T>> state;
+
+        bool await_ready() const noexcept { return tasks.empty(); }
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            state->continuation = awaiting;
+            for (size_t i = 0; i < tasks.size(); ++i) {
+                startDetached(detail::whenAllChild(std::move(tasks[i]), state, i));
+            }
+            // The parent holds one count itself, so children cannot resume it before it has suspended
+            return state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() noexcept {}
+    };
+
+    auto state = std::make_shared<detail::WhenAllState<T>>();
+    state->results.resize(tasks.size());
+    state->errors.resize(tasks.size());
+    state->remaining.store(tasks.size() + 1);
+    Awaiter children{tasks, state};
+    co_await children;
+
+    for (const std::exception_ptr& error : state->errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    std::vector<T> results;
+    results.reserve(tasks.size());
+    for (auto& result : state->results) {
+        results.push_back(std::move(*result));
+    }
+    co_return results;
+}
+
+#endif // TASK_H
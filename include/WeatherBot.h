@@ -2,31 +2,73 @@
 #define WEATHER_BOT_H
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <memory>
+#include <iostream>
 #include "WeatherService.h"
 #include "NotificationManager.h"
+#include "PrefetchScheduler.h"
+#include "CommandParser.h"
 
 class WeatherBot {
 public:
-    WeatherBot(const std::string& apiKey);
+    WeatherBot(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context = nullptr);
+    // Non-owning bot bound to an existing service and session (used by server mode)
+    WeatherBot(WeatherService& weatherService, NotificationManager& notificationManager, std::ostream& out,
+               PrefetchScheduler* scheduler = nullptr, const std::string& userId = "local");
     ~WeatherBot();
     
     void start();
+    // Blocks until the command has finished
     void processCommand(const std::string& command);
+    // Lookups suspend instead of blocking, so the calling thread is free until the
+    // upstream answers; the command then finishes on the event loop thread
+    Task<void> processCommandAsync(std::string command);
     void showHelp();
     void showWelcome();
+    bool isRunning() const { return running_; }
     
 private:
-    std::unique_ptr<WeatherService> weatherService_;
-    std::unique_ptr<NotificationManager> notificationManager_;
+    std::unique_ptr<WeatherService> ownedWeatherService_;
+    std::unique_ptr<NotificationManager> ownedNotificationManager_;
+    std::unique_ptr<PrefetchScheduler> ownedScheduler_;
+    std::shared_ptr<ConsoleAlertSink> ownedAlertSink_;  // Background alerts on the console, for an owning bot
+    WeatherService* weatherService_;
+    NotificationManager* notificationManager_;
+    PrefetchScheduler* scheduler_;
+    std::ostream& out_;
+    std::string userId_;  // Owner of the alert rules added through this bot
     bool running_;
     
-    void handleWeatherQuery(const std::string& city);
-    void handleLocationQuery(const std::string& lat, const std::string& lon);
+    // Runs a command that completes without a lookup; false if it must be awaited through awaitCommand
+    bool runCommand(const CommandLine& line);
+    // The views in line must stay valid until the task finishes
+    Task<void> awaitCommand(CommandLine line);
+    // Canonical name of the provider a command pinned with "@name" (empty when it
+    // pinned none); warns and returns false if no such provider is configured
+    bool resolveProvider(std::string_view name, std::string& provider);
+    Task<void> handleWeatherQuery(std::string city, std::string provider);
+    // Semicolon-separated names and city IDs, fetched as a batch
+    void handleWeatherList(std::string_view list, const std::string& provider);
+    void handleBatchWeatherQuery(const std::vector<std::string>& cities, const std::string& provider);
+    void handleCityIdQuery(const std::vector<long>& cityIds);
+    void handleForecastQuery(const std::string& city, int hours);
+    // "history <city>[,<country>] [<n>h|d|w]", or the log's size with no arguments
+    void handleHistoryCommand(std::string_view args);
+    void reportWeather(const WeatherData& data);
+    Task<void> handleLocationQuery(double latitude, double longitude, std::string provider);
+    void handleWatchCommand(const std::string& city);
+    void handleUnwatchCommand(const std::string& city);
+    void handleAlertCommand(std::string_view args);
+    void handleFindCommand(const std::string& prefix);
+    // Explains a failed lookup, distinguishing names the gazetteer does not know
+    void reportLookupFailure(const std::string& city);
+    void handleCacheCommand(std::string_view action);
+    void handleStatsCommand(std::string_view format);
+    void handleConfigCommand(std::string_view action);
     void handleHelpCommand();
     void handleExitCommand();
-    std::string trim(const std::string& str);
-    std::vector<std::string> splitCommand(const std::string& command);
 };
 
 #endif // WEATHER_BOT_H
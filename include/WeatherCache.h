@@ -0,0 +1,96 @@
+#ifndef WEATHER_CACHE_H
+#define WEATHER_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include "WeatherData.h"
+#include "RcuCell.h"
+
+struct WeatherCacheConfig {
+    std::chrono::seconds ttl{600};
+    std::chrono::seconds staleTtl{3600};  // How long past the TTL a result may still be served as stale
+    size_t maxBytes = 8 * 1024 * 1024;
+    size_t shardCount = 16;              // Fixed once the cache is built
+
+    bool operator==(const WeatherCacheConfig&) const = default;
+};
+
+struct WeatherCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    uint64_t insertions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Thread-safe LRU cache of parsed weather results. Keys are spread over
+// independently locked shards so concurrent lookups rarely contend. The TTLs
+// and size budget can be changed while the cache is in use.
+class WeatherCache {
+public:
+    explicit WeatherCache(const WeatherCacheConfig& config = WeatherCacheConfig());
+    ~WeatherCache();
+
+    // Fresh results only; expired entries are kept for getStale until staleTtl passes
+    bool get(const std::string& key, WeatherData& data);
+    // Any result within ttl + staleTtl, with isStale set once past the TTL; not counted as a hit or miss
+    bool getStale(const std::string& key, WeatherData& data);
+    void put(const std::string& key, const WeatherData& data);
+    // Inserts a result fetched earlier (e.g. restored from disk); it expires ttl after fetchedAt
+    void put(const std::string& key, const WeatherData& data, std::chrono::system_clock::time_point fetchedAt);
+    void clear();
+
+    WeatherCacheStats getStats() const;
+    const WeatherCacheConfig& getConfig() const { return config_.get(); }
+    // New TTLs apply to results stored from now on, the stale window and size
+    // budget at once (shards over budget shrink on their next insert); the
+    // shard count stays as built
+    void setConfig(const WeatherCacheConfig& config);
+
+    static std::string cityKey(const std::string& cityName);
+    static std::string coordinatesKey(double latitude, double longitude);
+    static std::string idKey(long cityId);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        WeatherData data;
+        Clock::time_point expiresAt;
+        size_t bytes;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    RcuCell<WeatherCacheConfig> config_;
+    std::atomic<size_t> shardBudget_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+    std::atomic<uint64_t> insertions_{0};
+
+    Shard& shardFor(const std::string& key);
+    void removeEntry(Shard& shard, std::list<Entry>::iterator it);
+    void insert(const std::string& key, const WeatherData& data, Clock::time_point expiresAt);
+    static size_t entrySize(const std::string& key, const WeatherData& data);
+};
+
+#endif // WEATHER_CACHE_H
@@ -0,0 +1,40 @@
+#ifndef WEATHER_DATA_H
+#define WEATHER_DATA_H
+
+#include <string_view>
+#include <type_traits>
+#include <cstdint>
+#include "SymbolTable.h"
+
+// One observation in a fixed-size, trivially copyable layout. The strings are
+// interned in SymbolTable::global() and stored as symbols, so copying a result
+// into or out of the cache is a plain 48-byte copy. Measurements are floats,
+// as in ForecastSeries and AlertEngine.
+struct WeatherData {
+    float temperature = 0.0f;
+    float feelsLike = 0.0f;
+    float humidity = 0.0f;
+    float windSpeed = 0.0f;
+    int64_t cityId = 0;  // OpenWeatherMap city ID, 0 when unknown
+    Symbol citySymbol = 0;
+    Symbol countrySymbol = 0;
+    Symbol descriptionSymbol = 0;
+    Symbol iconSymbol = 0;
+    bool isStale = false;  // Served past its TTL because a fresh result was not available in time
+    bool isValid = false;
+
+    std::string_view city() const { return SymbolTable::global().lookup(citySymbol); }
+    std::string_view country() const { return SymbolTable::global().lookup(countrySymbol); }
+    std::string_view description() const { return SymbolTable::global().lookup(descriptionSymbol); }
+    std::string_view icon() const { return SymbolTable::global().lookup(iconSymbol); }
+
+    void setCity(std::string_view value) { citySymbol = SymbolTable::global().intern(value); }
+    void setCountry(std::string_view value) { countrySymbol = SymbolTable::global().intern(value); }
+    void setDescription(std::string_view value) { descriptionSymbol = SymbolTable::global().intern(value); }
+    void setIcon(std::string_view value) { iconSymbol = SymbolTable::global().intern(value); }
+};
+
+static_assert(std::is_trivially_copyable_v<WeatherData>, "WeatherData is copied as plain bytes");
+static_assert(sizeof(WeatherData) <= 48, "WeatherData should stay within 48 bytes");
+
+#endif // WEATHER_DATA_H
@@ -0,0 +1,31 @@
+#ifndef WEATHER_JSON_PARSER_H
+#define WEATHER_JSON_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "WeatherData.h"
+#include "ForecastStore.h"
+
+// Parses OpenWeatherMap "current weather" responses.
+//
+// parse() is a single-pass pull parser that validates the whole document but
+// only materializes the handful of fields WeatherData needs, without building
+// a DOM. parseDom() is the original nlohmann::json based implementation, kept
+// as the reference the streaming parser is benchmarked and checked against.
+//
+// parseGroup() and parseForecast() use the same pull parser for the /group
+// (one entry per city ID) and /forecast (5-day/3-hour) endpoints, and
+// parseOpenMeteo() for Open-Meteo's "current" block, whose WMO weather code is
+// mapped to an OpenWeatherMap-style description and icon. Open-Meteo does not
+// name the location, so city and country are left empty.
+class WeatherJsonParser {
+public:
+    static WeatherData parse(std::string_view json);
+    static WeatherData parseDom(const std::string& json);
+    static std::vector<WeatherData> parseGroup(std::string_view json);
+    static ForecastSeries parseForecast(std::string_view json, ConditionTable& conditions);
+    static WeatherData parseOpenMeteo(std::string_view json);
+};
+
+#endif // WEATHER_JSON_PARSER_H
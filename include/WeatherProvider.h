@@ -0,0 +1,104 @@
+#ifndef WEATHER_PROVIDER_H
+#define WEATHER_PROVIDER_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include "WeatherData.h"
+#include "RcuCell.h"
+
+struct WeatherQuery {
+    enum class Kind {
+        CITY,
+        COORDINATES,
+        CITY_ID
+    };
+
+    Kind kind = Kind::CITY;
+    std::string city;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    long cityId = 0;
+    // Set by the gazetteer on the CITY_ID queries it resolves, so providers that
+    // only take coordinates can answer them; city then holds the display name
+    bool hasCoordinates = false;
+    std::string country;
+    // Provider that must answer this query; empty to let the router choose
+    std::string provider;
+
+    static WeatherQuery byCity(const std::string& cityName);
+    static WeatherQuery byCoordinates(double latitude, double longitude);
+    static WeatherQuery byId(long cityId);
+
+    bool isLocated() const { return kind == Kind::COORDINATES || hasCoordinates; }
+};
+
+// One upstream source of current weather: how to ask it for a query and how
+// to read its answer. Implementations are shared by every request; their one
+// piece of state, the base URL, can be moved at runtime and is read without
+// locks. ProviderRouter decides which one is asked.
+class WeatherProvider {
+public:
+    virtual ~WeatherProvider() = default;
+
+    // Stable lowercase name, used on the command line and in "weather <city> @name"
+    virtual const char* name() const = 0;
+    virtual bool matches(std::string_view alias) const;
+    virtual bool supports(const WeatherQuery& query) const = 0;
+    // API root every request URL starts with
+    virtual const std::string& getBaseUrl() const = 0;
+    // Requests built from now on go to baseUrl; safe while others are built
+    virtual void setBaseUrl(std::string baseUrl) = 0;
+    // apiKey is the OpenWeatherMap key the service was created with; providers
+    // that need no key ignore it
+    virtual std::string buildUrl(const WeatherQuery& query, const std::string& apiKey) const = 0;
+    // Invalid data if the response is not a usable observation
+    virtual WeatherData parse(std::string_view response, const WeatherQuery& query) const = 0;
+
+    // Provider by name or alias, talking to baseUrl (its public API when empty); nullptr if unknown
+    static std::shared_ptr<WeatherProvider> create(std::string_view name, const std::string& baseUrl = "");
+    // Percent-encodes a query string value
+    static std::string urlEncode(const std::string& value);
+};
+
+// api.openweathermap.org current weather: names, coordinates and city IDs
+class OpenWeatherMapProvider : public WeatherProvider {
+public:
+    static constexpr const char* DEFAULT_URL = "http://api.openweathermap.org/data/2.5";
+
+    explicit OpenWeatherMapProvider(std::string baseUrl = DEFAULT_URL) : baseUrl_(std::move(baseUrl)) {}
+
+    const char* name() const override { return "openweathermap"; }
+    bool matches(std::string_view alias) const override;
+    bool supports(const WeatherQuery&) const override { return true; }
+    const std::string& getBaseUrl() const override { return baseUrl_.get(); }
+    void setBaseUrl(std::string baseUrl) override { baseUrl_.publish(std::move(baseUrl)); }
+    std::string buildUrl(const WeatherQuery& query, const std::string& apiKey) const override;
+    WeatherData parse(std::string_view response, const WeatherQuery& query) const override;
+
+private:
+    RcuCell<std::string> baseUrl_;
+};
+
+// Open-Meteo forecast API: keyless, but coordinates only, so city names need
+// the gazetteer. Reports WMO weather codes, turned into OpenWeatherMap-style
+// descriptions and icons.
+class OpenMeteoProvider : public WeatherProvider {
+public:
+    static constexpr const char* DEFAULT_URL = "https://api.open-meteo.com/v1";
+
+    explicit OpenMeteoProvider(std::string baseUrl = DEFAULT_URL) : baseUrl_(std::move(baseUrl)) {}
+
+    const char* name() const override { return "open-meteo"; }
+    bool matches(std::string_view alias) const override;
+    bool supports(const WeatherQuery& query) const override { return query.isLocated(); }
+    const std::string& getBaseUrl() const override { return baseUrl_.get(); }
+    void setBaseUrl(std::string baseUrl) override { baseUrl_.publish(std::move(baseUrl)); }
+    std::string buildUrl(const WeatherQuery& query, const std::string& apiKey) const override;
+    WeatherData parse(std::string_view response, const WeatherQuery& query) const override;
+
+private:
+    RcuCell<std::string> baseUrl_;
+};
+
+#endif // WEATHER_PROVIDER_H
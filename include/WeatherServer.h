@@ -0,0 +1,94 @@
+#ifndef WEATHER_SERVER_H
+#define WEATHER_SERVER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "WeatherService.h"
+#include "NotificationManager.h"
+#include "PrefetchScheduler.h"
+#include "Task.h"
+
+struct WeatherServerConfig {
+    std::string host = "127.0.0.1";
+    int port = 5555;
+    std::string unixSocketPath;  // Listens on a Unix socket instead of TCP when set
+    size_t workerCount = 4;
+    size_t maxSessions = 1024;
+};
+
+// Serves many line-protocol sessions from one process. A single I/O thread
+// polls all sockets and hands complete command lines to a fixed pool of
+// workers, each owning its own WeatherService on top of a shared cache and
+// request coalescer. Lookups suspend on the shared event loop rather than
+// holding a worker, so a small pool keeps thousands of them in flight; the
+// finished reply is handed back to a worker to send. Each session is an
+// alert subscriber: alerts for the cities it watches are pushed to it between
+// replies.
+class WeatherServer {
+public:
+    WeatherServer(const std::string& apiKey, const WeatherServerConfig& config = WeatherServerConfig(),
+                  std::shared_ptr<WeatherServiceContext> context = nullptr);
+    ~WeatherServer();
+
+    bool start();
+    void run();
+    void stop();
+
+private:
+    struct Session;
+    class SessionAlertSink;
+
+    struct Job {
+        std::shared_ptr<Session> session;
+        std::string line;
+        bool deliver = false;   // The reply is ready and only needs sending
+        bool keepOpen = true;
+    };
+
+    std::string apiKey_;
+    WeatherServerConfig config_;
+    std::shared_ptr<WeatherServiceContext> context_;
+    // Alerts from background refreshes are reported on the server console
+    NotificationManager consoleNotifications_;
+    std::shared_ptr<ConsoleAlertSink> consoleAlerts_;
+    std::shared_ptr<SessionAlertSink> sessionAlerts_;
+    std::unique_ptr<PrefetchScheduler> scheduler_;
+
+    int listenFd_;
+    int wakePipe_[2];
+    std::atomic<bool> running_;
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable jobAvailable_;
+    std::deque<Job> jobs_;
+    std::map<int, std::shared_ptr<Session>> sessions_;
+    std::unordered_map<std::string, std::shared_ptr<Session>> sessionsByUser_;
+    uint64_t nextSessionId_;
+    size_t busySessions_;  // Sessions with a command queued, running or awaiting delivery
+
+    bool openListener();
+    void acceptSessions();
+    void readSession(const std::shared_ptr<Session>& session);
+    void dispatchLocked(const std::shared_ptr<Session>& session);
+    void closeSessionLocked(const std::shared_ptr<Session>& session);
+    void workerLoop();
+    Task<void> runCommand(Job job, WeatherService& weatherService);
+    void deliver(const std::shared_ptr<Session>& session, bool keepOpen);
+    // Called by the dispatcher with a batch of alerts for sessions
+    void pushAlerts(const std::vector<AlertMessage>& messages);
+    // Queues an idle session's pending alerts for sending
+    void pushAlertsLocked(const std::shared_ptr<Session>& session);
+    void wake();
+    static bool sendAll(int fd, const std::string& data);
+};
+
+#endif // WEATHER_SERVER_H
@@ -2,38 +2,191 @@
 #define WEATHER_SERVICE_H
 
 #include <string>
+#include <string_view>
+#include <memory_resource>
+#include <vector>
+#include <array>
 #include <memory>
+#include <functional>
+#include <chrono>
+#include <random>
 #include <curl/curl.h>
-#include <nlohmann/json.hpp>
+#include "WeatherData.h"
+#include "WeatherProvider.h"
+#include "ProviderRouter.h"
+#include "WeatherCache.h"
+#include "RequestCoalescer.h"
+#include "Metrics.h"
+#include "SnapshotStore.h"
+#include "HistoryStore.h"
+#include "ReportRenderer.h"
+#include "ForecastStore.h"
+#include "AlertEngine.h"
+#include "AlertDispatcher.h"
+#include "Gazetteer.h"
+#include "CircuitBreaker.h"
+#include "RateLimiter.h"
+#include "ConnectionManager.h"
+#include "ConfigStore.h"
+#include "EventLoop.h"
+#include "Task.h"
 
-struct WeatherData {
-    std::string city;
-    std::string description;
-    double temperature;
-    double feelsLike;
-    double humidity;
-    double windSpeed;
-    std::string country;
-    std::string icon;
-    bool isValid;
+// Invoked once per query as soon as its result is available (completion order)
+using BatchCallback = std::function<void(size_t index, const WeatherData& data)>;
+// Refreshes a query in the background after its stale result was served
+using RevalidateCallback = std::function<void(const WeatherQuery& query)>;
+
+// Process-wide state shared by every WeatherService instance (e.g. server workers)
+struct WeatherServiceContext {
+    WeatherServiceContext();
+    ~WeatherServiceContext();
+    
+    std::shared_ptr<WeatherCache> cache;
+    std::shared_ptr<RequestCoalescer> coalescer;
+    std::shared_ptr<Metrics> metrics;
+    std::shared_ptr<ForecastStore> forecasts;
+    std::shared_ptr<AlertEngine> alerts;
+    std::shared_ptr<AlertDispatcher> dispatcher;  // Sends raised alerts to their subscribers
+    std::shared_ptr<SnapshotStore> snapshot;  // Optional on-disk persistence
+    std::shared_ptr<HistoryStore> history;    // Optional log of every fetched observation
+    std::shared_ptr<Gazetteer> gazetteer;     // Optional offline city index for canonical city IDs
+    std::array<std::shared_ptr<CircuitBreaker>, static_cast<size_t>(Endpoint::COUNT)> breakers;
+    std::shared_ptr<RateLimiter> rateLimiter;  // Upstream quota shared by every request
+    std::shared_ptr<ConnectionManager> connections;  // DNS and TLS caches, HTTP version and warm connections
+    // Settings that may change at runtime; every publish is applied to the
+    // components above. Outlives the loop, which may be watching its file.
+    std::shared_ptr<ConfigStore> config;
+    // Current-weather sources. Left null, the first WeatherService on this context
+    // sets up OpenWeatherMap alone at the configured baseUrl, sharing the weather endpoint's breaker
+    std::shared_ptr<ProviderRouter> providers;
+    ReportStyle reportStyle = ReportStyle::BOX;  // How formatWeatherReport renders
+    // Stopped by the destructor before the state it works on is destroyed
+    std::shared_ptr<EventLoop> loop;
+    
+    CircuitBreaker& breaker(Endpoint endpoint) { return *breakers[static_cast<size_t>(endpoint)]; }
+    // Brings the cache, rate limiter, alert thresholds and OpenWeatherMap
+    // providers in line with a newly published config
+    void applyConfig(const RuntimeConfig& previous, const RuntimeConfig& current);
 };
 
 class WeatherService {
 public:
-    WeatherService(const std::string& apiKey);
+    WeatherService(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context = nullptr);
     ~WeatherService();
     
     WeatherData getWeatherByCity(const std::string& cityName);
     WeatherData getWeatherByCoordinates(double latitude, double longitude);
+    // Coroutine versions of the lookups: cache hits complete at once, anything else
+    // suspends the caller and resumes it on the event loop thread. Blocking calls
+    // (the plain methods above) must not be made after such an await.
+    Task<WeatherData> getWeatherByCityAsync(std::string cityName);
+    Task<WeatherData> getWeatherByCoordinatesAsync(double latitude, double longitude);
+    Task<WeatherData> getWeatherAsync(WeatherQuery query);
+    // Looks up OpenWeatherMap city IDs through the group endpoint, up to 20 per request;
+    // results are returned in input order
+    std::vector<WeatherData> getWeatherByIds(const std::vector<long>& cityIds);
+    // 5-day/3-hour forecast; nullptr if it could not be retrieved
+    std::shared_ptr<const ForecastSeries> getForecast(const std::string& cityName);
     std::string formatWeatherReport(const WeatherData& data);
+    // Appends the report to out in the context's style; reusing out avoids allocating
+    void formatWeatherReport(const WeatherData& data, std::string& out);
+    std::string formatForecast(const ForecastSeries& series, int hours);
+    // Aggregates of a location's logged observations; title names the location and window
+    std::string formatHistory(const std::string& title, const HistorySummary& summary);
+    // Fetches from upstream even if a cached result exists, then updates the cache
+    WeatherData refresh(const WeatherQuery& query);
+    Task<WeatherData> refreshAsync(WeatherQuery query);
+    
+    // Fetches all queries concurrently, up to the configured maxConcurrency at
+    // once; results are returned in input order
+    std::vector<WeatherData> getWeatherBatch(const std::vector<WeatherQuery>& queries,
+                                             const BatchCallback& onComplete = nullptr);
+    // With a revalidator, expired results are served at once (marked stale) and
+    // refreshed through it; without one, lookups wait for upstream and only fall
+    // back to a stale result if that fails
+    void setRevalidator(RevalidateCallback revalidate);
+    // Where this service's upstream requests queue when the rate limiter is out
+    // of tokens; INTERACTIVE unless set
+    void setPriority(RequestPriority priority) { priority_ = priority; }
+    
+    // Queries pinned to a provider are cached apart from routed ones
+    static std::string cacheKey(const WeatherQuery& query);
+    
+    WeatherCache& getCache() { return *context_->cache; }
+    RequestCoalescer& getCoalescer() { return *context_->coalescer; }
+    Metrics& getMetrics() { return *context_->metrics; }
+    const std::shared_ptr<WeatherServiceContext>& getContext() const { return context_; }
     
 private:
+    struct Transfer;
+    struct ProviderRace;
+    
+    // How performRequestAsync ended
+    enum class RequestOutcome {
+        NOT_SENT,   // Breaker open, or no rate limiter token
+        SUCCEEDED,  // Any answer below 500 other than 429
+        FAILED,
+        CANCELLED   // Abandoned through its cancel token
+    };
+    
+    // Optional inputs and results of one performRequestAsync call
+    struct RequestControl {
+        EventLoop::CancelToken* cancel = nullptr;  // Lets another coroutine abandon the request
+        bool spareQuotaOnly = false;               // Never queue for a token, like a hedge
+        RequestOutcome outcome = RequestOutcome::NOT_SENT;
+        EventLoop::Clock::duration elapsed{};      // From the first attempt to the answer or giving up
+    };
+    
     std::string apiKey_;
-    CURL* curl_;
+    CURLM* multi_;                // Drives getWeatherBatch on the calling thread
+    std::vector<CURL*> handlePool_;
+    std::shared_ptr<WeatherServiceContext> context_;
+    WeatherCache* cache_;
+    RevalidateCallback revalidate_;
+    RequestPriority priority_;
+    std::mt19937 random_;         // Retry jitter; only used on the loop thread
     
-    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* data);
-    std::string performRequest(const std::string& url);
-    WeatherData parseWeatherJson(const nlohmann::json& json);
+    static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::pmr::string* data);
+    // Runs one request on the event loop within the policy deadline, hedging slow attempts
+    // and retrying failed ones. Every attempt first takes a rate limiter token, waiting
+    // for one at this service's priority; a 429 pauses the limiter and is retried.
+    // The body is left empty on failure, while the endpoint's breaker is open or if
+    // no token was granted in time. Every attempt's body is allocated from the
+    // resource behind response, so one arena can back the whole request.
+    Task<void> performRequestAsync(std::string url, CircuitBreaker& breaker, std::pmr::string& response,
+                                   RequestControl* control = nullptr);
+    void performRequest(const std::string& url, Endpoint endpoint, std::pmr::string& response);
+    // Waits for a loop task from a caller thread; refuses (with a default result) on the loop itself
+    template <typename T>
+    T blockOn(Task<T> task);
+    WeatherData lookup(const WeatherQuery& query);
+    Task<WeatherData> lookupAsync(WeatherQuery query);
+    // Fresh cached result, or a stale one while a revalidator refreshes it
+    bool answerFromCache(const WeatherQuery& query, const std::string& key, WeatherData& data);
+    Task<WeatherData> fetchAsync(WeatherQuery query, std::string key);
+    // Asks the router's providers in turn (racing the first two if configured)
+    // until one answers, then caches the answer
+    Task<WeatherData> fetchAndStore(WeatherQuery query, std::string key);
+    Task<WeatherData> fetchFrom(size_t provider, WeatherQuery query, RequestControl& control);
+    // One side of a race; the first valid answer cancels the other side
+    Task<WeatherData> raceEntrant(WeatherQuery query, ProviderRace& race, size_t lane);
+    // Rewrites names and nearby coordinates to city IDs via the gazetteer;
+    // false for a city name the gazetteer does not know
+    bool canonicalize(WeatherQuery& query) const;
+    void storeResult(const std::string& key, const WeatherData& data);
+    // Stale result for key, if any, after a failed or skipped refresh
+    bool serveStale(const std::string& key, WeatherData& data);
+    WeatherData parseResponse(const WeatherProvider& provider, std::string_view response, const WeatherQuery& query);
+    // The configured key if one was rotated in, else the one this service was created with
+    const std::string& currentApiKey() const;
+    std::string buildGroupUrl(const std::vector<long>& cityIds) const;
+    std::string buildForecastUrl(const WeatherQuery& query) const;
+    void configureHandle(CURL* handle, const std::string& url, std::pmr::string* response,
+                         std::chrono::milliseconds timeout);
+    std::chrono::milliseconds hedgeDelay() const;
+    bool ensureMulti();
+    CURL* acquireHandle();
+    void releaseHandle(CURL* handle);
     void initializeCurl();
 };
 
@@ -0,0 +1,373 @@
+#include "AlertDispatcher.h"
+#include "WeatherCache.h"
+#include "ReportRenderer.h"
+#include <iostream>
+#include <algorithm>
+
+void ConsoleAlertSink::deliver(const std::vector<AlertMessage>& messages) {
+    for (const AlertMessage& message : messages) {
+        notifications_.showWeatherAlert(message.city, message.condition);
+    }
+}
+
+FileAlertSink::FileAlertSink(const std::string& path) : file_(path, std::ios::app) {
+    if (!file_.is_open()) {
+        std::cerr << "Error: Cannot open alert log " << path << std::endl;
+    }
+}
+
+void FileAlertSink::deliver(const std::vector<AlertMessage>& messages) {
+    if (!file_.is_open()) {
+        return;
+    }
+    long long now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    line_.clear();
+    for (const AlertMessage& message : messages) {
+        line_ += "{\"time\":";
+        line_ += std::to_string(now);
+        line_ += ",\"subscriber\":";
+        ReportRenderer::appendJsonString(line_, message.subscriber);
+        line_ += ",\"city\":";
+        ReportRenderer::appendJsonString(line_, message.city);
+        line_ += ",\"condition\":";
+        ReportRenderer::appendJsonString(line_, message.condition);
+        line_ += "}\n";
+    }
+    // One write per batch keeps a reader from seeing half a line for long
+    file_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+    file_.flush();
+}
+
+AlertDispatcher::AlertDispatcher(const AlertDispatchConfig& config)
+    : config_(config), subscriptions_(0), stopping_(false), dispatching_(false), pruned_(Clock::now()) {
+}
+
+AlertDispatcher::~AlertDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_all();
+    // Whatever is still queued is delivered first
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void AlertDispatcher::addSubscriber(const std::string& name, std::shared_ptr<AlertSink> sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byName_.find(name);
+    if (found != byName_.end()) {
+        subscribers_[found->second].sink = std::move(sink);
+        return;
+    }
+
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(subscribers_.size());
+        subscribers_.emplace_back();
+    }
+    Subscriber& subscriber = subscribers_[slot];
+    subscriber.name = name;
+    subscriber.sink = std::move(sink);
+    subscriber.tokens = config_.burst;
+    subscriber.refilled = Clock::now();
+    byName_.emplace(name, slot);
+}
+
+bool AlertDispatcher::removeSubscriber(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byName_.find(name);
+    if (found == byName_.end()) {
+        return false;
+    }
+    removeLocked(found->second);
+    return true;
+}
+
+void AlertDispatcher::removeSink(const AlertSink* sink) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (uint32_t slot = 0; slot < subscribers_.size(); ++slot) {
+            if (subscribers_[slot].sink.get() == sink) {
+                removeLocked(slot);
+            }
+        }
+    }
+    // Batches resolved from here on no longer see the sink
+    std::lock_guard<std::mutex> delivering(deliveryMutex_);
+}
+
+void AlertDispatcher::removeLocked(uint32_t slot) {
+    Subscriber& subscriber = subscribers_[slot];
+    while (!subscriber.memberships.empty()) {
+        leaveLocked(slot, subscriber.memberships.size() - 1);
+    }
+    if (subscriber.everywhere) {
+        everywhere_.erase(std::find(everywhere_.begin(), everywhere_.end(), slot));
+    }
+    byName_.erase(subscriber.name);
+    subscriber = Subscriber();
+    freeSlots_.push_back(slot);
+}
+
+uint32_t AlertDispatcher::locationIdLocked(const std::string& key) {
+    auto [found, added] = locationIds_.try_emplace(key, static_cast<uint32_t>(locationSubscribers_.size()));
+    if (added) {
+        locationSubscribers_.emplace_back();
+    }
+    return found->second;
+}
+
+void AlertDispatcher::leaveLocked(uint32_t slot, size_t membership) {
+    std::vector<Membership>& memberships = subscribers_[slot].memberships;
+    Membership leaving = memberships[membership];
+    memberships[membership] = memberships.back();
+    memberships.pop_back();
+
+    // The last subscriber in the list takes the leaving one's place
+    std::vector<uint32_t>& members = locationSubscribers_[leaving.location];
+    uint32_t moved = members.back();
+    members[leaving.position] = moved;
+    members.pop_back();
+    if (moved != slot) {
+        for (Membership& other : subscribers_[moved].memberships) {
+            if (other.location == leaving.location) {
+                other.position = leaving.position;
+                break;
+            }
+        }
+    }
+    --subscriptions_;
+}
+
+bool AlertDispatcher::subscribe(const std::string& name, const std::string& city) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byName_.find(name);
+    if (found == byName_.end()) {
+        return false;
+    }
+    uint32_t slot = found->second;
+    uint32_t location = locationIdLocked(WeatherCache::cityKey(city));
+    Subscriber& subscriber = subscribers_[slot];
+    for (const Membership& membership : subscriber.memberships) {
+        if (membership.location == location) {
+            return false;
+        }
+    }
+
+    std::vector<uint32_t>& members = locationSubscribers_[location];
+    subscriber.memberships.push_back(Membership{location, static_cast<uint32_t>(members.size())});
+    members.push_back(slot);
+    ++subscriptions_;
+    return true;
+}
+
+bool AlertDispatcher::unsubscribe(const std::string& name, const std::string& city) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byName_.find(name);
+    auto location = locationIds_.find(WeatherCache::cityKey(city));
+    if (found == byName_.end() || location == locationIds_.end()) {
+        return false;
+    }
+    const std::vector<Membership>& memberships = subscribers_[found->second].memberships;
+    for (size_t i = 0; i < memberships.size(); ++i) {
+        if (memberships[i].location == location->second) {
+            leaveLocked(found->second, i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AlertDispatcher::subscribeAll(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byName_.find(name);
+    if (found == byName_.end() || subscribers_[found->second].everywhere) {
+        return false;
+    }
+    subscribers_[found->second].everywhere = true;
+    everywhere_.push_back(found->second);
+    return true;
+}
+
+size_t AlertDispatcher::getSubscriberCount(const std::string& city) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto location = locationIds_.find(WeatherCache::cityKey(city));
+    return location == locationIds_.end() ? 0 : locationSubscribers_[location->second].size();
+}
+
+void AlertDispatcher::publish(std::vector<AlertEvent> events) {
+    if (events.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        size_t room = config_.queueCapacity - std::min(config_.queueCapacity, queue_.size());
+        if (events.size() > room) {
+            stats_.dropped += events.size() - room;
+            events.resize(room);
+        }
+        stats_.published += events.size();
+        if (queue_.empty()) {
+            queue_ = std::move(events);
+        } else {
+            queue_.insert(queue_.end(), std::make_move_iterator(events.begin()), std::make_move_iterator(events.end()));
+        }
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&AlertDispatcher::run, this);
+        }
+    }
+    wakeup_.notify_one();
+}
+
+void AlertDispatcher::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && !dispatching_; });
+}
+
+void AlertDispatcher::run() {
+    std::vector<AlertEvent> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wakeup_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        // Everything queued meanwhile goes out as one batch
+        batch.swap(queue_);
+        dispatching_ = true;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> delivering(deliveryMutex_);
+            dispatch(batch);
+        }
+        batch.clear();
+        lock.lock();
+        dispatching_ = false;
+        idle_.notify_all();
+    }
+}
+
+void AlertDispatcher::dispatch(std::vector<AlertEvent>& events) {
+    Clock::time_point now = Clock::now();
+
+    // A value hovering around a threshold raises the same alert again and
+    // again; only the first within the window is sent
+    if (now - pruned_ >= config_.repeatWindow) {
+        std::erase_if(recent_, [&](const auto& entry) { return now - entry.second >= config_.repeatWindow; });
+        pruned_ = now;
+    }
+    std::vector<std::pair<uint32_t, std::string>> fresh;  // Event index and location key
+    uint64_t repeats = 0;
+    std::string key;
+    for (uint32_t i = 0; i < events.size(); ++i) {
+        const AlertEvent& event = events[i];
+        std::string location = WeatherCache::cityKey(event.city);
+        key.assign(event.owner).append(1, '\n').append(location).append(1, '\n').append(event.condition);
+        auto [sent, added] = recent_.try_emplace(key, now);
+        if (!added) {
+            if (now - sent->second < config_.repeatWindow) {
+                ++repeats;
+                continue;
+            }
+            sent->second = now;
+        }
+        fresh.emplace_back(i, std::move(location));
+    }
+
+    std::vector<std::shared_ptr<AlertSink>> sinks;
+    std::vector<std::vector<AlertMessage>> outgoing;  // Per sink
+    std::vector<std::string> names;                   // What the messages' subscriber views point at
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.batches;
+        stats_.repeats += repeats;
+
+        // One pass over the index collects every (subscriber, event) pair
+        std::vector<Delivery> deliveries;
+        for (const auto& [index, location] : fresh) {
+            const AlertEvent& event = events[index];
+            if (!event.owner.empty()) {
+                auto owner = byName_.find(event.owner);
+                if (owner != byName_.end()) {
+                    deliveries.push_back(Delivery{owner->second, index});
+                }
+                continue;
+            }
+            auto found = locationIds_.find(location);
+            if (found != locationIds_.end()) {
+                for (uint32_t slot : locationSubscribers_[found->second]) {
+                    deliveries.push_back(Delivery{slot, index});
+                }
+            }
+            for (uint32_t slot : everywhere_) {
+                deliveries.push_back(Delivery{slot, index});
+            }
+        }
+        // Subscribed to the location and to everything, a subscriber still hears it once
+        std::sort(deliveries.begin(), deliveries.end());
+        deliveries.erase(std::unique(deliveries.begin(), deliveries.end()), deliveries.end());
+
+        size_t distinct = 0;
+        for (size_t i = 0; i < deliveries.size(); ++i) {
+            distinct += i == 0 || deliveries[i].subscriber != deliveries[i - 1].subscriber;
+        }
+        names.reserve(distinct);
+
+        std::unordered_map<const AlertSink*, size_t> sinkIndex;
+        double perSecond = config_.alertsPerMinute / 60.0;
+        for (size_t i = 0; i < deliveries.size();) {
+            uint32_t slot = deliveries[i].subscriber;
+            Subscriber& subscriber = subscribers_[slot];
+            bool limited = subscriber.sink->rateLimited();
+            if (limited) {
+                double elapsed = std::chrono::duration<double>(now - subscriber.refilled).count();
+                subscriber.tokens = std::min(config_.burst, subscriber.tokens + elapsed * perSecond);
+                subscriber.refilled = now;
+            }
+            auto [sink, added] = sinkIndex.try_emplace(subscriber.sink.get(), sinks.size());
+            if (added) {
+                sinks.push_back(subscriber.sink);
+                outgoing.emplace_back();
+            }
+            names.push_back(subscriber.name);
+
+            for (; i < deliveries.size() && deliveries[i].subscriber == slot; ++i) {
+                if (limited) {
+                    if (subscriber.tokens < 1.0) {
+                        ++stats_.throttled;
+                        continue;
+                    }
+                    subscriber.tokens -= 1.0;
+                }
+                const AlertEvent& event = events[deliveries[i].event];
+                outgoing[sink->second].push_back(AlertMessage{names.back(), event.city, event.condition});
+                ++stats_.delivered;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < sinks.size(); ++i) {
+        if (!outgoing[i].empty()) {
+            sinks[i]->deliver(outgoing[i]);
+        }
+    }
+}
+
+AlertDispatchStats AlertDispatcher::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AlertDispatchStats stats = stats_;
+    stats.subscribers = byName_.size();
+    stats.subscriptions = subscriptions_;
+    stats.locations = static_cast<size_t>(std::count_if(locationSubscribers_.begin(), locationSubscribers_.end(),
+                                                        [](const std::vector<uint32_t>& members) { return !members.empty(); }));
+    return stats;
+}
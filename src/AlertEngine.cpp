@@ -0,0 +1,420 @@
+#include "AlertEngine.h"
+#include "WeatherCache.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_set>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WEATHERBOT_AVX2_KERNEL 1
+#endif
+
+namespace {
+const size_t LANES = 8;
+const size_t INITIAL_CAPACITY = 64;
+// Rates are only recomputed once observations are at least this far apart
+const std::chrono::seconds MIN_RATE_INTERVAL(60);
+const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+
+uint64_t instanceKey(uint32_t ruleId, size_t location) {
+    return (static_cast<uint64_t>(ruleId) << 32) | static_cast<uint64_t>(location);
+}
+
+float metricValue(const WeatherData& data, size_t metric) {
+    switch (static_cast<AlertMetric>(metric)) {
+        case AlertMetric::TEMPERATURE:
+            return static_cast<float>(data.temperature);
+        case AlertMetric::WIND_SPEED:
+            return static_cast<float>(data.windSpeed);
+        case AlertMetric::HUMIDITY:
+            return static_cast<float>(data.humidity);
+        default:
+            return NOT_A_NUMBER;
+    }
+}
+
+bool testBit(const std::vector<uint8_t>& bits, size_t index) {
+    return (bits[index >> 3] >> (index & 7)) & 1;
+}
+
+void assignBit(std::vector<uint8_t>& bits, size_t index, bool value) {
+    uint8_t mask = static_cast<uint8_t>(1u << (index & 7));
+    if (value) {
+        bits[index >> 3] |= mask;
+    } else {
+        bits[index >> 3] &= static_cast<uint8_t>(~mask);
+    }
+}
+}
+
+AlertEngine::AlertEngine()
+    : nextRuleId_(1), capacity_(INITIAL_CAPACITY), instanceCount_(0), dirty_(false), forceScalar_(false) {
+    columns_.assign(INPUT_COLUMNS * capacity_ + 1, NOT_A_NUMBER);
+}
+
+AlertEngine::~AlertEngine() {
+}
+
+bool AlertEngine::hasAvx2() {
+#ifdef WEATHERBOT_AVX2_KERNEL
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+void AlertEngine::setForceScalar(bool forceScalar) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    forceScalar_ = forceScalar;
+}
+
+void AlertEngine::addDefaultRules(const AlertThresholds& thresholds) {
+    AlertRule freezing;
+    freezing.metric = AlertMetric::TEMPERATURE;
+    freezing.comparison = AlertComparison::BELOW;
+    freezing.threshold = thresholds.freezingBelow;
+    freezing.hysteresis = 1.0f;
+    freezing.condition = "Freezing temperatures!";
+    uint32_t freezingId = addRule(freezing);
+
+    AlertRule heat;
+    heat.metric = AlertMetric::TEMPERATURE;
+    heat.comparison = AlertComparison::ABOVE;
+    heat.threshold = thresholds.heatAbove;
+    heat.hysteresis = 1.0f;
+    heat.condition = "Very hot weather!";
+    uint32_t heatId = addRule(heat);
+
+    AlertRule wind;
+    wind.metric = AlertMetric::WIND_SPEED;
+    wind.comparison = AlertComparison::ABOVE;
+    wind.threshold = thresholds.windAbove;
+    wind.hysteresis = 2.0f;
+    wind.condition = "Strong winds detected!";
+    uint32_t windId = addRule(wind);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    defaultRules_ = {freezingId, heatId, windId};
+}
+
+void AlertEngine::setDefaultThresholds(const AlertThresholds& thresholds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (defaultRules_.empty()) {
+        return;
+    }
+    const float values[] = {thresholds.freezingBelow, thresholds.heatAbove, thresholds.windAbove};
+    for (size_t i = 0; i < defaultRules_.size(); ++i) {
+        auto found = rules_.find(defaultRules_[i]);
+        if (found != rules_.end()) {
+            found->second.rule.threshold = values[i];
+        }
+    }
+    // Rebuilding keeps which instances are active
+    dirty_ = true;
+}
+
+uint32_t AlertEngine::addRule(const AlertRule& rule) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t id = nextRuleId_++;
+    StoredRule stored{rule, rule.location.empty() ? std::string() : WeatherCache::cityKey(rule.location)};
+    stored.rule.hysteresis = std::max(0.0f, stored.rule.hysteresis);
+    rules_.emplace(id, std::move(stored));
+    dirty_ = true;
+    return id;
+}
+
+bool AlertEngine::removeRule(uint32_t ruleId, const std::string& owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = rules_.find(ruleId);
+    if (found == rules_.end() || found->second.rule.owner != owner) {
+        return false;
+    }
+    rules_.erase(found);
+    dirty_ = true;
+    return true;
+}
+
+size_t AlertEngine::removeRulesFor(const std::string& owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t removed = 0;
+    for (auto it = rules_.begin(); it != rules_.end();) {
+        if (!owner.empty() && it->second.rule.owner == owner) {
+            it = rules_.erase(it);
+            ++removed;
+        } else {
+            ++it;
+        }
+    }
+    dirty_ = dirty_ || removed > 0;
+    return removed;
+}
+
+std::vector<std::pair<uint32_t, AlertRule>> AlertEngine::getRules(const std::string& owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<uint32_t, AlertRule>> visible;
+    for (const auto& entry : rules_) {
+        if (entry.second.rule.owner.empty() || entry.second.rule.owner == owner) {
+            visible.emplace_back(entry.first, entry.second.rule);
+        }
+    }
+    return visible;
+}
+
+size_t AlertEngine::getInstanceCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_) {
+        rebuildLocked();
+    }
+    return instanceCount_;
+}
+
+void AlertEngine::growLocked() {
+    size_t capacity = capacity_ * 2;
+    std::vector<float> columns(INPUT_COLUMNS * capacity + 1, NOT_A_NUMBER);
+    for (size_t column = 0; column < INPUT_COLUMNS; ++column) {
+        std::copy(columns_.begin() + column * capacity_, columns_.begin() + (column + 1) * capacity_,
+                  columns.begin() + column * capacity);
+    }
+    columns_.swap(columns);
+    capacity_ = capacity;
+    dirty_ = true;  // Instance input offsets depend on the capacity
+}
+
+void AlertEngine::update(const WeatherData& data) {
+    if (!data.isValid) {
+        return;
+    }
+
+    std::string key = WeatherCache::cityKey(std::string(data.city()));
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto found = locationIndex_.find(key);
+    size_t index;
+    if (found == locationIndex_.end()) {
+        if (locations_.size() == capacity_) {
+            growLocked();
+        }
+        index = locations_.size();
+        Location location;
+        location.key = key;
+        location.city = data.city();
+        locations_.push_back(std::move(location));
+        locationIndex_.emplace(key, index);
+        dirty_ = true;
+    } else {
+        index = found->second;
+    }
+
+    Location& location = locations_[index];
+    Clock::time_point now = Clock::now();
+    const size_t metrics = static_cast<size_t>(AlertMetric::COUNT);
+    bool rollBaseline = !location.hasPrevious || now - location.previousAt >= MIN_RATE_INTERVAL;
+    double hours = std::chrono::duration<double, std::ratio<3600>>(now - location.previousAt).count();
+
+    for (size_t metric = 0; metric < metrics; ++metric) {
+        float value = metricValue(data, metric);
+        columns_[metric * capacity_ + index] = value;
+        if (!rollBaseline) {
+            continue;
+        }
+        columns_[(metrics + metric) * capacity_ + index] =
+            location.hasPrevious ? static_cast<float>((value - location.previous[metric]) / hours) : NOT_A_NUMBER;
+        location.previous[metric] = value;
+    }
+    if (rollBaseline) {
+        location.previousAt = now;
+        location.hasPrevious = true;
+    }
+}
+
+void AlertEngine::rebuildLocked() {
+    // Carry alert state over to the new layout so rebuilding never re-raises
+    std::unordered_set<uint64_t> previous;
+    for (const Location& location : locations_) {
+        size_t locationNumber = static_cast<size_t>(&location - locations_.data());
+        for (size_t i = location.firstInstance; i < location.firstInstance + location.instanceCount; ++i) {
+            if (i < instanceCount_ && testBit(active_, i)) {
+                previous.insert(instanceKey(instanceRule_[i], locationNumber));
+            }
+        }
+    }
+
+    std::vector<const std::pair<const uint32_t, StoredRule>*> everywhere;
+    std::unordered_map<std::string, std::vector<const std::pair<const uint32_t, StoredRule>*>> byLocation;
+    for (const auto& entry : rules_) {
+        if (entry.second.locationKey.empty()) {
+            everywhere.push_back(&entry);
+        } else {
+            byLocation[entry.second.locationKey].push_back(&entry);
+        }
+    }
+
+    instanceRule_.clear();
+    instanceInput_.clear();
+    instanceSign_.clear();
+    instanceThreshold_.clear();
+    instanceHysteresis_.clear();
+
+    auto addInstance = [this](const std::pair<const uint32_t, StoredRule>& entry, size_t location) {
+        const AlertRule& rule = entry.second.rule;
+        size_t column = static_cast<size_t>(rule.metric) +
+                        (rule.kind == AlertRuleKind::RATE_OF_CHANGE ? static_cast<size_t>(AlertMetric::COUNT) : 0);
+        float sign = rule.comparison == AlertComparison::ABOVE ? 1.0f : -1.0f;
+        instanceRule_.push_back(entry.first);
+        instanceInput_.push_back(static_cast<int32_t>(column * capacity_ + location));
+        instanceSign_.push_back(sign);
+        instanceThreshold_.push_back(sign * rule.threshold);
+        instanceHysteresis_.push_back(rule.hysteresis);
+    };
+
+    // Instances are grouped by location so one location's rules are a contiguous range
+    for (size_t location = 0; location < locations_.size(); ++location) {
+        Location& current = locations_[location];
+        current.firstInstance = instanceRule_.size();
+        for (const auto* entry : everywhere) {
+            addInstance(*entry, location);
+        }
+        auto specific = byLocation.find(current.key);
+        if (specific != byLocation.end()) {
+            for (const auto* entry : specific->second) {
+                addInstance(*entry, location);
+            }
+        }
+        current.instanceCount = instanceRule_.size() - current.firstInstance;
+    }
+
+    instanceCount_ = instanceRule_.size();
+    size_t padded = (instanceCount_ + LANES - 1) / LANES * LANES;
+    // Padding lanes read the NaN slot, which never raises an alert
+    instanceRule_.resize(padded, 0);
+    instanceInput_.resize(padded, static_cast<int32_t>(columns_.size() - 1));
+    instanceSign_.resize(padded, 1.0f);
+    instanceThreshold_.resize(padded, 0.0f);
+    instanceHysteresis_.resize(padded, 0.0f);
+
+    active_.assign(padded / LANES, 0);
+    raised_.assign(padded / LANES, 0);
+    for (size_t location = 0; location < locations_.size(); ++location) {
+        const Location& current = locations_[location];
+        for (size_t i = current.firstInstance; i < current.firstInstance + current.instanceCount; ++i) {
+            if (previous.count(instanceKey(instanceRule_[i], location)) > 0) {
+                assignBit(active_, i, true);
+            }
+        }
+    }
+
+    dirty_ = false;
+}
+
+void AlertEngine::evaluateScalar(size_t begin, size_t end) {
+    const float* columns = columns_.data();
+    for (size_t i = begin; i < end; ++i) {
+        float value = columns[instanceInput_[i]];
+        bool wasActive = testBit(active_, i);
+        bool isActive = wasActive;
+        // A missing value (no observation or no rate yet) leaves the state unchanged
+        if (!std::isnan(value)) {
+            float threshold = instanceThreshold_[i] - (wasActive ? instanceHysteresis_[i] : 0.0f);
+            isActive = instanceSign_[i] * value > threshold;
+        }
+        assignBit(active_, i, isActive);
+        assignBit(raised_, i, isActive && !wasActive);
+    }
+}
+
+#ifdef WEATHERBOT_AVX2_KERNEL
+__attribute__((target("avx2"))) void AlertEngine::evaluateAvx2(size_t begin, size_t end) {
+    const float* columns = columns_.data();
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    for (size_t i = begin; i < end; i += LANES) {
+        uint8_t wasActive = active_[i / LANES];
+
+        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&instanceInput_[i]));
+        __m256 value = _mm256_i32gather_ps(columns, input, 4);
+        __m256 sign = _mm256_loadu_ps(&instanceSign_[i]);
+        __m256 threshold = _mm256_loadu_ps(&instanceThreshold_[i]);
+        __m256 hysteresis = _mm256_loadu_ps(&instanceHysteresis_[i]);
+
+        // Expand the eight state bits into lane masks
+        __m256i stateBits = _mm256_and_si256(_mm256_set1_epi32(wasActive), laneBits);
+        __m256 activeMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(stateBits, laneBits));
+
+        __m256 effective = _mm256_sub_ps(threshold, _mm256_and_ps(hysteresis, activeMask));
+        __m256 exceeded = _mm256_cmp_ps(_mm256_mul_ps(sign, value), effective, _CMP_GT_OQ);
+        __m256 present = _mm256_cmp_ps(value, value, _CMP_ORD_Q);
+        __m256 next = _mm256_blendv_ps(activeMask, exceeded, present);
+
+        uint8_t isActive = static_cast<uint8_t>(_mm256_movemask_ps(next));
+        active_[i / LANES] = isActive;
+        raised_[i / LANES] = static_cast<uint8_t>(isActive & ~wasActive);
+    }
+}
+#endif
+
+void AlertEngine::evaluate(std::vector<AlertEvent>& raised) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_) {
+        rebuildLocked();
+    }
+
+    size_t padded = instanceRule_.size();
+#ifdef WEATHERBOT_AVX2_KERNEL
+    if (!forceScalar_ && hasAvx2()) {
+        evaluateAvx2(0, padded);
+    } else {
+        evaluateScalar(0, padded);
+    }
+#else
+    evaluateScalar(0, padded);
+#endif
+
+    // Raised alerts are rare, so events are only built for non-zero bytes
+    for (size_t block = 0; block < raised_.size(); ++block) {
+        uint8_t bits = raised_[block];
+        for (size_t lane = 0; bits != 0 && lane < LANES; ++lane) {
+            if (!(bits & (1u << lane))) {
+                continue;
+            }
+            bits &= static_cast<uint8_t>(~(1u << lane));
+            size_t instance = block * LANES + lane;
+
+            auto location = std::upper_bound(locations_.begin(), locations_.end(), instance,
+                                             [](size_t value, const Location& entry) {
+                                                 return value < entry.firstInstance;
+                                             }) - 1;
+            const AlertRule& rule = rules_.at(instanceRule_[instance]).rule;
+            raised.push_back(AlertEvent{instanceRule_[instance], rule.owner, location->city, rule.condition});
+        }
+    }
+}
+
+std::vector<std::string> AlertEngine::evaluateLocation(const std::string& city, const std::string& owner) {
+    std::vector<std::string> conditions;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_) {
+        rebuildLocked();
+    }
+
+    auto found = locationIndex_.find(WeatherCache::cityKey(city));
+    if (found == locationIndex_.end()) {
+        return conditions;
+    }
+
+    const Location& location = locations_[found->second];
+    size_t end = location.firstInstance + location.instanceCount;
+    evaluateScalar(location.firstInstance, end);
+
+    for (size_t i = location.firstInstance; i < end; ++i) {
+        if (!testBit(active_, i)) {
+            continue;
+        }
+        const AlertRule& rule = rules_.at(instanceRule_[i]).rule;
+        if (rule.owner.empty() || rule.owner == owner) {
+            conditions.push_back(rule.condition);
+        }
+    }
+    return conditions;
+}
@@ -0,0 +1,283 @@
+#include "BatchRunner.h"
+#include "CommandParser.h"
+#include "ReportRenderer.h"
+#include <fstream>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <cctype>
+
+namespace {
+const size_t FLUSH_BYTES = 64 * 1024;
+const char* const CSV_HEADER = "seq,query,ok,city,country,id,temperature,feels_like,humidity,wind_speed,description,stale,error\n";
+
+void appendCsvField(std::string& out, std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+bool parseNumber(std::string_view text, double& value) {
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+}
+
+BatchRunner::BatchRunner(const std::string& apiKey, const BatchConfig& config,
+                         std::shared_ptr<WeatherServiceContext> context)
+    : config_(config),
+      weatherService_(apiKey, std::move(context)),
+      outstanding_(0),
+      nextToWrite_(0),
+      written_(0),
+      failed_(0),
+      out_(&std::cout) {
+    config_.parallelism = std::max<size_t>(1, config_.parallelism);
+    // Lines queue for the shared upstream quota behind interactive and background work
+    weatherService_.setPriority(RequestPriority::BATCH);
+}
+
+bool BatchRunner::parseQuery(std::string_view line, WeatherQuery& query) {
+    CommandLine command = CommandParser::parse(line);
+    if (command.command == Command::LOCATION) {
+        CommandTokenizer tokens(command.args);
+        std::string_view lat;
+        std::string_view lon;
+        std::string_view extra;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        if (!tokens.next(lat) || !tokens.next(lon) || tokens.next(extra) ||
+            !parseNumber(lat, latitude) || !parseNumber(lon, longitude)) {
+            return false;
+        }
+        query = WeatherQuery::byCoordinates(latitude, longitude);
+        return true;
+    }
+
+    // Anything that is not a weather or location command is a city name
+    std::string_view city = command.command == Command::WEATHER ? command.args : line;
+    if (city.empty()) {
+        return false;
+    }
+    if (city.size() < 12 && std::all_of(city.begin(), city.end(),
+                                         [](unsigned char c) { return std::isdigit(c) != 0; })) {
+        long cityId = 0;
+        std::from_chars(city.data(), city.data() + city.size(), cityId);
+        query = WeatherQuery::byId(cityId);
+    } else {
+        query = WeatherQuery::byCity(CommandParser::joinWords(city));
+    }
+    return true;
+}
+
+int BatchRunner::run() {
+    std::ifstream inputFile;
+    std::istream* in = &std::cin;
+    if (config_.inputPath != "-") {
+        inputFile.open(config_.inputPath);
+        if (!inputFile.is_open()) {
+            std::cerr << "Error: Cannot open " << config_.inputPath << std::endl;
+            return 1;
+        }
+        in = &inputFile;
+    }
+
+    std::ofstream outputFile;
+    if (!config_.outputPath.empty()) {
+        outputFile.open(config_.outputPath, std::ios::binary | std::ios::trunc);
+        if (!outputFile.is_open()) {
+            std::cerr << "Error: Cannot write " << config_.outputPath << std::endl;
+            return 1;
+        }
+        out_ = &outputFile;
+    }
+
+    if (config_.order == BatchOrder::INPUT) {
+        window_.resize(config_.parallelism);
+    }
+    buffer_.reserve(FLUSH_BYTES * 2);
+    writeHeader();
+
+    auto started = std::chrono::steady_clock::now();
+    std::string line;
+    uint64_t sequence = 0;
+    while (std::getline(*in, line)) {
+        std::string_view text = CommandParser::trim(line);
+        if (text.empty() || text.front() == '#') {
+            continue;
+        }
+
+        drainBelow(config_.parallelism);
+        ++outstanding_;
+        WeatherQuery query;
+        if (parseQuery(text, query)) {
+            startDetached(lookup(sequence, std::string(text), std::move(query)));
+        } else {
+            Result result;
+            result.sequence = sequence;
+            result.input = std::string(text);
+            result.error = "invalid query";
+            finish(std::move(result));
+        }
+        ++sequence;
+    }
+    drainBelow(1);
+    flush(true);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::cerr << "Batch complete: " << written_ << " results, " << failed_ << " failed in "
+              << seconds << "s" << std::endl;
+
+    if (!*out_) {
+        std::cerr << "Error: Failed to write batch output" << std::endl;
+        return 1;
+    }
+    return failed_ == 0 ? 0 : 2;
+}
+
+Task<void> BatchRunner::lookup(uint64_t sequence, std::string input, WeatherQuery query) {
+    Result result;
+    result.sequence = sequence;
+    result.input = std::move(input);
+    try {
+        Task<WeatherData> fetch = weatherService_.getWeatherAsync(std::move(query));
+        result.data = co_await fetch;
+        if (!result.data.isValid) {
+            result.error = "lookup failed";
+        }
+    } catch (const std::exception&) {
+        result.error = "lookup failed";
+    }
+    finish(std::move(result));
+}
+
+void BatchRunner::finish(Result result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_.push_back(std::move(result));
+    completed_.notify_one();
+}
+
+void BatchRunner::drainBelow(size_t limit) {
+    std::vector<Result> ready;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (outstanding_ >= limit) {
+                completed_.wait(lock, [this] { return !finished_.empty(); });
+            }
+            ready.swap(finished_);
+        }
+        for (Result& result : ready) {
+            accept(std::move(result));
+        }
+        ready.clear();
+        if (outstanding_ < limit) {
+            return;
+        }
+    }
+}
+
+void BatchRunner::accept(Result result) {
+    if (config_.order == BatchOrder::COMPLETION) {
+        write(result);
+        --outstanding_;
+        return;
+    }
+
+    // Fewer than `parallelism` lines are outstanding, so their slots cannot clash
+    window_[result.sequence % window_.size()] = std::move(result);
+    while (true) {
+        std::optional<Result>& slot = window_[nextToWrite_ % window_.size()];
+        if (!slot) {
+            break;
+        }
+        write(*slot);
+        slot.reset();
+        ++nextToWrite_;
+        --outstanding_;
+    }
+}
+
+void BatchRunner::writeHeader() {
+    if (config_.format == BatchFormat::CSV) {
+        buffer_ += CSV_HEADER;
+    }
+}
+
+void BatchRunner::write(const Result& result) {
+    const WeatherData& data = result.data;
+    bool ok = result.error == nullptr;
+    ++written_;
+    if (!ok) {
+        ++failed_;
+    }
+
+    if (config_.format == BatchFormat::CSV) {
+        ReportRenderer::appendNumber(buffer_, static_cast<int64_t>(result.sequence));
+        buffer_ += ',';
+        appendCsvField(buffer_, result.input);
+        buffer_ += ok ? ",true," : ",false,";
+        if (ok) {
+            appendCsvField(buffer_, data.city());
+            buffer_ += ',';
+            appendCsvField(buffer_, data.country());
+            buffer_ += ',';
+            ReportRenderer::appendNumber(buffer_, data.cityId);
+            buffer_ += ',';
+            ReportRenderer::appendNumber(buffer_, data.temperature);
+            buffer_ += ',';
+            ReportRenderer::appendNumber(buffer_, data.feelsLike);
+            buffer_ += ',';
+            ReportRenderer::appendNumber(buffer_, data.humidity);
+            buffer_ += ',';
+            ReportRenderer::appendNumber(buffer_, data.windSpeed);
+            buffer_ += ',';
+            appendCsvField(buffer_, data.description());
+            buffer_ += data.isStale ? ",true," : ",false,";
+        } else {
+            buffer_ += ",,,,,,,,,";
+            buffer_ += result.error;
+        }
+        buffer_ += '\n';
+    } else {
+        buffer_ += "{\"seq\":";
+        ReportRenderer::appendNumber(buffer_, static_cast<int64_t>(result.sequence));
+        buffer_ += ",\"query\":";
+        ReportRenderer::appendJsonString(buffer_, result.input);
+        if (ok) {
+            // The rendered object continues this one: its opening brace becomes a comma
+            size_t object = buffer_.size();
+            ReportRenderer::render<ReportStyle::JSON>(data, buffer_);
+            buffer_[object] = ',';
+        } else {
+            buffer_ += ",\"ok\":false,\"error\":";
+            ReportRenderer::appendJsonString(buffer_, result.error);
+            buffer_ += "}\n";
+        }
+    }
+    flush(false);
+}
+
+void BatchRunner::flush(bool force) {
+    if (buffer_.empty() || (!force && buffer_.size() < FLUSH_BYTES)) {
+        return;
+    }
+    out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    if (force) {
+        out_->flush();
+    }
+    buffer_.clear();
+}
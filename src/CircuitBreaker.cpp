@@ -0,0 +1,83 @@
+#include "CircuitBreaker.h"
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerConfig& config)
+    : config_(config), state_(BreakerState::CLOSED), consecutiveFailures_(0), probeInFlight_(false) {
+    if (config_.failureThreshold == 0) {
+        config_.failureThreshold = 1;
+    }
+}
+
+bool CircuitBreaker::allowRequest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == BreakerState::OPEN && Clock::now() - openedAt_ >= config_.openDuration) {
+        state_ = BreakerState::HALF_OPEN;
+        probeInFlight_ = false;
+    }
+
+    if (state_ == BreakerState::CLOSED) {
+        return true;
+    }
+    if (state_ == BreakerState::HALF_OPEN && !probeInFlight_) {
+        probeInFlight_ = true;
+        return true;
+    }
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void CircuitBreaker::recordSuccess() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = BreakerState::CLOSED;
+    consecutiveFailures_ = 0;
+    probeInFlight_ = false;
+}
+
+void CircuitBreaker::recordFailure() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++consecutiveFailures_;
+    // A failed probe reopens at once; otherwise it takes a run of failures
+    if (state_ == BreakerState::HALF_OPEN || consecutiveFailures_ >= config_.failureThreshold) {
+        state_ = BreakerState::OPEN;
+        openedAt_ = Clock::now();
+    }
+    probeInFlight_ = false;
+}
+
+void CircuitBreaker::recordCancelled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    probeInFlight_ = false;
+}
+
+BreakerState CircuitBreaker::getState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == BreakerState::OPEN && Clock::now() - openedAt_ >= config_.openDuration) {
+        return BreakerState::HALF_OPEN;
+    }
+    return state_;
+}
+
+const char* CircuitBreaker::stateName(BreakerState state) {
+    switch (state) {
+        case BreakerState::CLOSED:
+            return "closed";
+        case BreakerState::OPEN:
+            return "open";
+        case BreakerState::HALF_OPEN:
+            return "half-open";
+        default:
+            return "unknown";
+    }
+}
+
+const char* CircuitBreaker::endpointName(Endpoint endpoint) {
+    switch (endpoint) {
+        case Endpoint::WEATHER:
+            return "weather";
+        case Endpoint::GROUP:
+            return "group";
+        case Endpoint::FORECAST:
+            return "forecast";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,64 @@
+#include "CommandParser.h"
+
+namespace {
+const char* const WHITESPACE = " \t\n\r";
+}
+
+bool CommandTokenizer::next(std::string_view& token) {
+    size_t start = rest_.find_first_not_of(WHITESPACE);
+    if (start == std::string_view::npos) {
+        rest_ = {};
+        return false;
+    }
+    size_t end = rest_.find_first_of(WHITESPACE, start);
+    if (end == std::string_view::npos) {
+        end = rest_.size();
+    }
+    token = rest_.substr(start, end - start);
+    rest_.remove_prefix(end);
+    return true;
+}
+
+std::string_view CommandTokenizer::remainder() const {
+    return CommandParser::trim(rest_);
+}
+
+CommandLine CommandParser::parse(std::string_view line) {
+    CommandLine parsed;
+    CommandTokenizer tokens(line);
+    if (!tokens.next(parsed.verb)) {
+        return parsed;
+    }
+    parsed.command = lookup(parsed.verb);
+    parsed.args = tokens.remainder();
+    size_t last = parsed.args.find_last_of(WHITESPACE);
+    size_t start = last == std::string_view::npos ? 0 : last + 1;
+    if (parsed.args.size() > start + 1 && parsed.args[start] == '@') {
+        parsed.provider = parsed.args.substr(start + 1);
+        parsed.args = trim(parsed.args.substr(0, start));
+    }
+    return parsed;
+}
+
+std::string_view CommandParser::trim(std::string_view text) {
+    size_t first = text.find_first_not_of(WHITESPACE);
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    size_t last = text.find_last_not_of(WHITESPACE);
+    return text.substr(first, last - first + 1);
+}
+
+std::string CommandParser::joinWords(std::string_view text) {
+    std::string joined;
+    joined.reserve(text.size());
+    CommandTokenizer tokens(text);
+    std::string_view word;
+    while (tokens.next(word)) {
+        if (!joined.empty()) {
+            joined += ' ';
+        }
+        joined += word;
+    }
+    return joined;
+}
@@ -0,0 +1,327 @@
+#include "ConfigStore.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// How often the file is checked where inotify is not available
+const std::chrono::seconds POLL_INTERVAL{2};
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return std::string_view();
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    T parsed{};
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// A whole, non-negative number of the duration's unit
+template <typename Duration>
+bool parseDuration(std::string_view text, Duration& value) {
+    long long count = 0;
+    if (!parseNumber(text, count) || count < 0) {
+        return false;
+    }
+    value = Duration(count);
+    return true;
+}
+
+bool parseCount(std::string_view text, size_t& value, size_t minimum) {
+    size_t count = 0;
+    if (!parseNumber(text, count) || count < minimum) {
+        return false;
+    }
+    value = count;
+    return true;
+}
+
+bool parseRate(std::string_view text, double& value, double minimum) {
+    double rate = 0.0;
+    if (!parseNumber(text, rate) || !(rate >= minimum)) {
+        return false;
+    }
+    value = rate;
+    return true;
+}
+
+// Enough of the key to tell which one is in use
+std::string maskKey(const std::string& key) {
+    if (key.empty()) {
+        return "";
+    }
+    return "..." + key.substr(key.size() > 4 ? key.size() - 4 : 0);
+}
+
+struct Setting {
+    const char* key;
+    // False if value is not valid for the setting
+    bool (*parse)(std::string_view value, RuntimeConfig& config);
+    void (*print)(const RuntimeConfig& config, std::ostream& out);
+};
+
+const Setting SETTINGS[] = {
+    {"api_key",
+     [](std::string_view value, RuntimeConfig& config) {
+         config.apiKey = std::string(value);
+         return !value.empty();
+     },
+     [](const RuntimeConfig& config, std::ostream& out) { out << maskKey(config.apiKey); }},
+    {"base_url",
+     [](std::string_view value, RuntimeConfig& config) {
+         config.baseUrl = std::string(value);
+         while (!config.baseUrl.empty() && config.baseUrl.back() == '/') {
+             config.baseUrl.pop_back();
+         }
+         return value.substr(0, 7) == "http://" || value.substr(0, 8) == "https://";
+     },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.baseUrl; }},
+    {"cache_ttl",
+     [](std::string_view value, RuntimeConfig& config) { return parseDuration(value, config.cache.ttl); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.cache.ttl.count(); }},
+    {"cache_stale_ttl",
+     [](std::string_view value, RuntimeConfig& config) { return parseDuration(value, config.cache.staleTtl); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.cache.staleTtl.count(); }},
+    {"cache_max_bytes",
+     [](std::string_view value, RuntimeConfig& config) { return parseCount(value, config.cache.maxBytes, 0); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.cache.maxBytes; }},
+    {"max_concurrency",
+     [](std::string_view value, RuntimeConfig& config) { return parseCount(value, config.maxConcurrency, 1); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.maxConcurrency; }},
+    {"rate_limit",
+     [](std::string_view value, RuntimeConfig& config) { return parseRate(value, config.rateLimit.requestsPerMinute, 0.0); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.rateLimit.requestsPerMinute; }},
+    {"rate_burst",
+     [](std::string_view value, RuntimeConfig& config) { return parseRate(value, config.rateLimit.burst, 1.0); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.rateLimit.burst; }},
+    {"daily_quota",
+     [](std::string_view value, RuntimeConfig& config) { return parseNumber(value, config.rateLimit.requestsPerDay); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.rateLimit.requestsPerDay; }},
+    {"request_deadline_ms",
+     [](std::string_view value, RuntimeConfig& config) { return parseDuration(value, config.requestPolicy.deadline); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.requestPolicy.deadline.count(); }},
+    {"attempt_timeout_ms",
+     [](std::string_view value, RuntimeConfig& config) { return parseDuration(value, config.requestPolicy.attemptTimeout); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.requestPolicy.attemptTimeout.count(); }},
+    {"connect_timeout_ms",
+     [](std::string_view value, RuntimeConfig& config) { return parseDuration(value, config.requestPolicy.connectTimeout); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.requestPolicy.connectTimeout.count(); }},
+    {"max_attempts",
+     [](std::string_view value, RuntimeConfig& config) { return parseCount(value, config.requestPolicy.maxAttempts, 1); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.requestPolicy.maxAttempts; }},
+    {"alert_freezing_below",
+     [](std::string_view value, RuntimeConfig& config) { return parseNumber(value, config.alerts.freezingBelow); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.alerts.freezingBelow; }},
+    {"alert_heat_above",
+     [](std::string_view value, RuntimeConfig& config) { return parseNumber(value, config.alerts.heatAbove); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.alerts.heatAbove; }},
+    {"alert_wind_above",
+     [](std::string_view value, RuntimeConfig& config) { return parseNumber(value, config.alerts.windAbove); },
+     [](const RuntimeConfig& config, std::ostream& out) { out << config.alerts.windAbove; }},
+};
+
+const Setting* findSetting(std::string_view key) {
+    for (const Setting& setting : SETTINGS) {
+        if (key == setting.key) {
+            return &setting;
+        }
+    }
+    return nullptr;
+}
+}
+
+ConfigStore::ConfigStore(const RuntimeConfig& defaults)
+    : current_(defaults), defaults_(defaults), watchFd_(-1), watching_(false), reloads_(0), rejected_(0) {
+}
+
+ConfigStore::~ConfigStore() {
+#ifdef __linux__
+    // The loop that watched it is stopped by now: the context they share stops it first
+    if (watchFd_ >= 0) {
+        close(watchFd_);
+    }
+#endif
+}
+
+void ConfigStore::setDefaults(const std::function<void(RuntimeConfig&)>& change) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    change(defaults_);
+    publishLocked();
+}
+
+bool ConfigStore::load(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    return reloadLocked();
+}
+
+bool ConfigStore::reload() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty()) {
+        return false;
+    }
+    return reloadLocked();
+}
+
+bool ConfigStore::reloadLocked() {
+    std::ifstream file(path_);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot read config file " << path_ << std::endl;
+        ++rejected_;
+        return false;
+    }
+    std::error_code error;
+    lastModified_ = std::filesystem::last_write_time(path_, error);
+
+    // Every line is checked before any is applied
+    std::vector<std::pair<std::string, std::string>> overrides;
+    RuntimeConfig scratch;
+    bool valid = true;
+    std::string line;
+    for (size_t number = 1; std::getline(file, line); ++number) {
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') {
+            continue;
+        }
+        size_t equals = text.find('=');
+        std::string_view key = trim(text.substr(0, equals));
+        std::string_view value = equals == std::string_view::npos ? std::string_view() : trim(text.substr(equals + 1));
+        const Setting* setting = findSetting(key);
+        if (!setting) {
+            std::cerr << "Error: " << path_ << ":" << number << ": unknown setting '" << key << "'" << std::endl;
+            valid = false;
+        } else if (equals == std::string_view::npos || !setting->parse(value, scratch)) {
+            std::cerr << "Error: " << path_ << ":" << number << ": invalid value for " << key << std::endl;
+            valid = false;
+        } else {
+            overrides.emplace_back(key, value);
+        }
+    }
+    if (!valid) {
+        std::cerr << "Error: Kept the previous configuration" << std::endl;
+        ++rejected_;
+        return false;
+    }
+
+    overrides_ = std::move(overrides);
+    ++reloads_;
+    publishLocked();
+    return true;
+}
+
+void ConfigStore::publishLocked() {
+    RuntimeConfig next = defaults_;
+    for (const auto& [key, value] : overrides_) {
+        findSetting(key)->parse(value, next);
+    }
+    const RuntimeConfig& previous = current_.get();
+    const RuntimeConfig& published = current_.publish(std::move(next));
+    if (listener_) {
+        listener_(previous, published);
+    }
+}
+
+bool ConfigStore::watch(EventLoop& loop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty() || watching_) {
+        return watching_;
+    }
+    std::filesystem::path file(path_);
+#ifdef __linux__
+    // Editors often write a new file and rename it over the old one, so the
+    // directory is watched rather than the file
+    std::string directory = file.has_parent_path() ? file.parent_path().string() : ".";
+    watchedName_ = file.filename().string();
+    watchFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd_ < 0 || inotify_add_watch(watchFd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        std::cerr << "Error: Cannot watch " << path_ << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    watching_ = loop.watchFd(watchFd_, [this] { readEvents(); });
+#else
+    loop.post([this, &loop] { pollForChanges(loop); });
+    watching_ = true;
+#endif
+    return watching_;
+}
+
+void ConfigStore::readEvents() {
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(watchFd_, buffer, sizeof(buffer))) > 0) {
+        for (char* at = buffer; at < buffer + length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(at);
+            if (event->len > 0 && watchedName_ == event->name) {
+                changed = true;
+            }
+            at += sizeof(inotify_event) + event->len;
+        }
+    }
+    if (changed) {
+        reload();
+    }
+#endif
+}
+
+void ConfigStore::pollForChanges(EventLoop& loop) {
+    loop.addTimer(EventLoop::Clock::now() + POLL_INTERVAL, [this, &loop] {
+        std::error_code error;
+        std::filesystem::file_time_type modified = std::filesystem::last_write_time(path_, error);
+        bool changed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            changed = !error && modified != lastModified_;
+        }
+        if (changed) {
+            reload();
+        }
+        pollForChanges(loop);
+    });
+}
+
+void ConfigStore::setListener(Listener listener) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    listener_ = std::move(listener);
+}
+
+ConfigStats ConfigStore::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConfigStats stats;
+    stats.path = path_;
+    stats.watching = watching_;
+    stats.reloads = reloads_;
+    stats.rejected = rejected_;
+    return stats;
+}
+
+std::string ConfigStore::format(const RuntimeConfig& config) {
+    std::ostringstream out;
+    for (const Setting& setting : SETTINGS) {
+        out << setting.key << " = ";
+        setting.print(config, out);
+        out << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,188 @@
+#include "ConnectionManager.h"
+#include <iostream>
+#include <algorithm>
+
+namespace {
+const long PING_TIMEOUT_MS = 5000;
+
+void applyOptions(CURL* handle, CURLSH* share, HttpVersion version) {
+    if (share) {
+        curl_easy_setopt(handle, CURLOPT_SHARE, share);
+    }
+    switch (version) {
+        case HttpVersion::AUTO:
+            curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+            break;
+        case HttpVersion::HTTP1:
+            curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_1_1));
+            break;
+    }
+    // A transfer started while a connection to the same host is still being set
+    // up waits to multiplex over it instead of opening another
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, version == HttpVersion::AUTO ? 1L : 0L);
+}
+
+bool startsWithOrigin(const std::string& url, const std::string& origin) {
+    return url.compare(0, origin.size(), origin) == 0 &&
+           (url.size() == origin.size() || url[origin.size()] == '/' || url[origin.size()] == '?');
+}
+}
+
+ConnectionManager::ConnectionManager(const ConnectionConfig& config)
+    : config_(config), share_(nullptr), warmups_(0), pings_(0), failed_(0) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    share_ = curl_share_init();
+    if (!share_) {
+        std::cerr << "Error: Failed to initialize CURL share handle" << std::endl;
+        return;
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_PSL);
+}
+
+ConnectionManager::~ConnectionManager() {
+    // Fails while a handle still uses the share, which only happens if the event
+    // loop could not be joined; the share is then left to the process exit
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+}
+
+void ConnectionManager::prepare(CURL* handle, const std::string& url) {
+    applyOptions(handle, share_, config_.httpVersion);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Host& host : hosts_) {
+        if (startsWithOrigin(url, host.origin)) {
+            host.lastUsed = Clock::now();
+            break;
+        }
+    }
+}
+
+void ConnectionManager::start(EventLoop& loop, const std::vector<std::string>& urls) {
+    if (!config_.warmup) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const std::string& url : urls) {
+            std::string origin = originOf(url);
+            bool known = std::any_of(hosts_.begin(), hosts_.end(), [&](const Host& host) { return host.origin == origin; });
+            if (!origin.empty() && !known) {
+                hosts_.push_back(Host{origin, Clock::now()});
+            }
+        }
+    }
+    loop.post([this, &loop] {
+        for (size_t i = 0; i < hosts_.size(); ++i) {
+            connect(loop, i, true);
+        }
+        schedulePings(loop);
+    });
+}
+
+void ConnectionManager::connect(EventLoop& loop, size_t index, bool warmup) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        hosts_[index].pinging = true;
+        url = hosts_[index].origin + "/";
+    }
+
+    // A HEAD request leaves the connection in the loop's pool for the next
+    // lookup. Not a pooled handle: NOBODY would stick to it.
+    CURL* handle = curl_easy_init();
+    bool added = false;
+    if (handle) {
+        applyOptions(handle, share_, config_.httpVersion);
+        curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+        // Connections are only reused by requests with the same TLS settings as lookups
+        curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, PING_TIMEOUT_MS);
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+        added = loop.addTransfer(handle, [this, index, warmup](CURL* done, CURLcode result) {
+            curl_easy_cleanup(done);
+            std::lock_guard<std::mutex> lock(mutex_);
+            hosts_[index].pinging = false;
+            // Any HTTP answer, even an error status, means the connection is up
+            if (result != CURLE_OK) {
+                ++failed_;
+            } else if (warmup) {
+                ++warmups_;
+            } else {
+                ++pings_;
+            }
+        });
+    }
+    if (!added) {
+        if (handle) {
+            curl_easy_cleanup(handle);
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        hosts_[index].pinging = false;
+        ++failed_;
+    }
+}
+
+void ConnectionManager::schedulePings(EventLoop& loop) {
+    if (config_.pingInterval.count() <= 0) {
+        return;
+    }
+    loop.addTimer(Clock::now() + config_.pingInterval, [this, &loop] {
+        Clock::time_point now = Clock::now();
+        std::vector<size_t> idle;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < hosts_.size(); ++i) {
+                Clock::duration unused = now - hosts_[i].lastUsed;
+                if (!hosts_[i].pinging && unused >= config_.pingInterval && unused <= config_.keepWarmFor) {
+                    idle.push_back(i);
+                }
+            }
+        }
+        for (size_t index : idle) {
+            connect(loop, index, false);
+        }
+        schedulePings(loop);
+    });
+}
+
+ConnectionStats ConnectionManager::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConnectionStats stats;
+    stats.hosts = hosts_.size();
+    stats.warmups = warmups_;
+    stats.pings = pings_;
+    stats.failed = failed_;
+    return stats;
+}
+
+const char* ConnectionManager::httpVersionName(HttpVersion version) {
+    switch (version) {
+        case HttpVersion::AUTO: return "auto";
+        case HttpVersion::HTTP1: return "1.1";
+    }
+    return "unknown";
+}
+
+std::string ConnectionManager::originOf(const std::string& url) {
+    size_t scheme = url.find("://");
+    if (scheme == std::string::npos) {
+        return "";
+    }
+    return url.substr(0, url.find_first_of("/?", scheme + 3));
+}
+
+void ConnectionManager::lock(CURL*, curl_lock_data data, curl_lock_access, void* userp) {
+    static_cast<ConnectionManager*>(userp)->shareLocks_[data].lock();
+}
+
+void ConnectionManager::unlock(CURL*, curl_lock_data data, void* userp) {
+    static_cast<ConnectionManager*>(userp)->shareLocks_[data].unlock();
+}
@@ -0,0 +1,401 @@
+#include "EventLoop.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const int MAX_EVENTS = 256;
+// Caps open sockets however many lookups are awaited at once; the rest queue inside libcurl
+const long MAX_CONNECTIONS = 256;
+const size_t MAX_POOLED_HANDLES = 64;
+}
+
+EventLoop::Wakeup::~Wakeup() {
+    // Only reached with a waiter if the waiting coroutine was destroyed while suspended
+    if (waiter_) {
+        loop_.cancelTimer(timer_);
+    }
+}
+
+bool EventLoop::Wakeup::Awaiter::await_ready() noexcept {
+    if (wakeup.notified_) {
+        wakeup.notified_ = false;
+        return true;
+    }
+    return Clock::now() >= until;
+}
+
+void EventLoop::Wakeup::Awaiter::await_suspend(std::coroutine_handle<> handle) {
+    Wakeup* target = &wakeup;
+    target->waiter_ = handle;
+    // The loop erases a timer before running it, so the timer path must not cancel it again
+    target->timer_ = target->loop_.addTimer(until, [target] { target->resumeWaiter(); });
+}
+
+void EventLoop::Wakeup::notify() {
+    if (!waiter_) {
+        notified_ = true;
+        return;
+    }
+    loop_.cancelTimer(timer_);
+    resumeWaiter();
+}
+
+void EventLoop::Wakeup::resumeWaiter() {
+    std::exchange(waiter_, {}).resume();
+}
+
+void EventLoop::CancelToken::cancel() {
+    cancelled_ = true;
+    // May resume the cancelled coroutine right here, and it may finish before notify() returns
+    if (Wakeup* wakeup = std::exchange(wakeup_, nullptr)) {
+        wakeup->notify();
+    }
+}
+
+EventLoop::EventLoop()
+    : multi_(nullptr), epollFd_(-1), wakeFd_(-1), running_(false),
+      curlTimeout_(Clock::time_point::max()), activeTransfers_(0) {
+}
+
+EventLoop::~EventLoop() {
+    stop();
+    // Still joinable only when run() has returned and its thread is dropping the last reference
+    if (thread_.joinable()) {
+        thread_.detach();
+    }
+
+    for (auto& transfer : transfers_) {
+        curl_multi_remove_handle(multi_, transfer.first);
+        curl_easy_cleanup(transfer.first);
+    }
+    for (CURL* handle : handlePool_) {
+        curl_easy_cleanup(handle);
+    }
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
+#ifdef __linux__
+    if (epollFd_ >= 0) {
+        close(epollFd_);
+    }
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+    }
+#endif
+}
+
+void EventLoop::ensureStarted() {
+    // The thread is only started once something is posted to it
+    std::call_once(started_, [this] {
+        if (!initialize()) {
+            std::cerr << "Error: Failed to start the event loop" << std::endl;
+            return;
+        }
+        running_ = true;
+        thread_ = std::thread([self = shared_from_this()] { self->run(); });
+    });
+}
+
+void EventLoop::stop() {
+    running_ = false;
+    wake();
+    // On the loop itself, run() returns once the current callback does
+    if (thread_.joinable() && !isLoopThread()) {
+        thread_.join();
+    }
+}
+
+bool EventLoop::initialize() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        return false;
+    }
+    curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS, MAX_CONNECTIONS);
+    // Lookups to an HTTP/2 upstream share one connection as concurrent streams
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+#ifdef __linux__
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        std::cerr << "Error: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd_;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event) != 0) {
+        return false;
+    }
+
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socketCallback);
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timerCallback);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+#endif
+    return true;
+}
+
+void EventLoop::post(std::function<void()> function) {
+    ensureStarted();
+    if (!running_) {
+        // Without a loop thread, run it here; transfers then fail to start and report an error
+        function();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        posted_.push_back(std::move(function));
+    }
+    wake();
+}
+
+void EventLoop::wake() {
+#ifdef __linux__
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+        (void)ignored;
+    }
+#else
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+#endif
+}
+
+bool EventLoop::addTransfer(CURL* handle, TransferCallback onDone) {
+    if (!multi_ || curl_multi_add_handle(multi_, handle) != CURLM_OK) {
+        return false;
+    }
+    transfers_.emplace(handle, std::move(onDone));
+    activeTransfers_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void EventLoop::removeTransfer(CURL* handle) {
+    if (transfers_.erase(handle) > 0) {
+        // Also drops any completion libcurl has queued for the handle
+        curl_multi_remove_handle(multi_, handle);
+        activeTransfers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+EventLoop::TimerHandle EventLoop::addTimer(Clock::time_point at, std::function<void()> callback) {
+    return timers_.emplace(at, std::move(callback));
+}
+
+void EventLoop::cancelTimer(TimerHandle timer) {
+    timers_.erase(timer);
+}
+
+CURL* EventLoop::acquireHandle() {
+    if (!handlePool_.empty()) {
+        CURL* handle = handlePool_.back();
+        handlePool_.pop_back();
+        return handle;
+    }
+    return curl_easy_init();
+}
+
+void EventLoop::releaseHandle(CURL* handle) {
+    if (handlePool_.size() < MAX_POOLED_HANDLES) {
+        handlePool_.push_back(handle);
+    } else {
+        curl_easy_cleanup(handle);
+    }
+}
+
+bool EventLoop::isSaturated() const {
+    return getActiveTransfers() >= static_cast<size_t>(MAX_CONNECTIONS);
+}
+
+bool EventLoop::watchFd(int fd, std::function<void()> onReadable) {
+#ifdef __linux__
+    post([this, fd, onReadable = std::move(onReadable)]() mutable {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            std::cerr << "Error: Cannot watch descriptor " << fd << ": " << std::strerror(errno) << std::endl;
+            return;
+        }
+        watchers_[fd] = std::move(onReadable);
+    });
+    return true;
+#else
+    (void)fd;
+    (void)onReadable;
+    return false;
+#endif
+}
+
+int EventLoop::nextTimeoutMs() {
+    Clock::time_point next = curlTimeout_;
+    if (!timers_.empty()) {
+        next = std::min(next, timers_.begin()->first);
+    }
+    if (next == Clock::time_point::max()) {
+        return -1;
+    }
+    // Round up so a timer is never polled for just before it is due
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(next - Clock::now());
+    return static_cast<int>(std::clamp<long long>(wait.count(), 0, 60 * 1000));
+}
+
+void EventLoop::run() {
+    threadId_ = std::this_thread::get_id();
+    int running = 0;
+
+#ifdef __linux__
+    epoll_event events[MAX_EVENTS];
+    while (running_) {
+        int count = epoll_wait(epollFd_, events, MAX_EVENTS, nextTimeoutMs());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; running_ && i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd_) {
+                uint64_t ignored;
+                while (read(wakeFd_, &ignored, sizeof(ignored)) > 0) {
+                }
+                continue;
+            }
+            auto watcher = watchers_.find(fd);
+            if (watcher != watchers_.end()) {
+                watcher->second();
+                continue;
+            }
+            int flags = 0;
+            if (events[i].events & EPOLLIN) {
+                flags |= CURL_CSELECT_IN;
+            }
+            if (events[i].events & EPOLLOUT) {
+                flags |= CURL_CSELECT_OUT;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                flags |= CURL_CSELECT_ERR;
+            }
+            curl_multi_socket_action(multi_, fd, flags, &running);
+        }
+        if (Clock::now() >= curlTimeout_) {
+            curlTimeout_ = Clock::time_point::max();
+            curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+        }
+
+        completeTransfers();
+        runTimers();
+        runPosted();
+    }
+#else
+    // Portable fallback: libcurl polls its own sockets and is woken for posted work
+    while (running_) {
+        int timeoutMs = nextTimeoutMs();
+        curl_multi_poll(multi_, nullptr, 0, timeoutMs < 0 ? 1000 : timeoutMs, nullptr);
+        curl_multi_perform(multi_, &running);
+
+        completeTransfers();
+        runTimers();
+        runPosted();
+    }
+#endif
+}
+
+void EventLoop::runPosted() {
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        posted.swap(posted_);
+    }
+    for (auto& function : posted) {
+        // Once stopped, the state posted work refers to may already be gone
+        if (!running_) {
+            break;
+        }
+        function();
+    }
+}
+
+void EventLoop::runTimers() {
+    Clock::time_point now = Clock::now();
+    while (running_ && !timers_.empty() && timers_.begin()->first <= now) {
+        std::function<void()> callback = std::move(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+        callback();
+    }
+}
+
+void EventLoop::completeTransfers() {
+    CURLMsg* msg;
+    int queued;
+    while (running_ && (msg = curl_multi_info_read(multi_, &queued))) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        // msg is invalidated by curl_multi_remove_handle, so read it first
+        CURL* handle = msg->easy_handle;
+        CURLcode result = msg->data.result;
+        auto found = transfers_.find(handle);
+        if (found == transfers_.end()) {
+            continue;
+        }
+        TransferCallback onDone = std::move(found->second);
+        transfers_.erase(found);
+        curl_multi_remove_handle(multi_, handle);
+        activeTransfers_.fetch_sub(1, std::memory_order_relaxed);
+        // May resume a coroutine that adds or abandons other transfers
+        onDone(handle, result);
+    }
+}
+
+int EventLoop::socketCallback(CURL*, curl_socket_t socket, int what, void* userp, void*) {
+#ifdef __linux__
+    auto* loop = static_cast<EventLoop*>(userp);
+    if (what == CURL_POLL_REMOVE) {
+        epoll_ctl(loop->epollFd_, EPOLL_CTL_DEL, socket, nullptr);
+        return 0;
+    }
+
+    epoll_event event{};
+    event.data.fd = socket;
+    if (what & CURL_POLL_IN) {
+        event.events |= EPOLLIN;
+    }
+    if (what & CURL_POLL_OUT) {
+        event.events |= EPOLLOUT;
+    }
+    // Descriptors are reused, so try an update first and register when it is unknown
+    if (epoll_ctl(loop->epollFd_, EPOLL_CTL_MOD, socket, &event) != 0 && errno == ENOENT) {
+        epoll_ctl(loop->epollFd_, EPOLL_CTL_ADD, socket, &event);
+    }
+#else
+    (void)socket;
+    (void)what;
+    (void)userp;
+#endif
+    return 0;
+}
+
+int EventLoop::timerCallback(CURLM*, long timeoutMs, void* userp) {
+    auto* loop = static_cast<EventLoop*>(userp);
+    loop->curlTimeout_ = timeoutMs < 0 ? Clock::time_point::max()
+                                       : Clock::now() + std::chrono::milliseconds(timeoutMs);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "ForecastStore.h"
+#include <algorithm>
+
+void ConditionTable::intern(uint16_t code, std::string_view description) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = descriptions_.find(code);
+    if (found == descriptions_.end()) {
+        descriptions_.emplace(code, std::string(description));
+    } else if (found->second != description) {
+        found->second.assign(description.data(), description.size());
+    }
+}
+
+std::string ConditionTable::describe(uint16_t code) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = descriptions_.find(code);
+    return found != descriptions_.end() ? found->second : "unknown";
+}
+
+ForecastStore::ForecastStore(std::chrono::seconds ttl) : ttl_(ttl) {
+}
+
+std::shared_ptr<const ForecastSeries> ForecastStore::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = entries_.find(key);
+    if (found == entries_.end()) {
+        return nullptr;
+    }
+    if (Clock::now() >= found->second.expiresAt) {
+        entries_.erase(found);
+        return nullptr;
+    }
+    return found->second.series;
+}
+
+void ForecastStore::put(const std::string& key, std::shared_ptr<const ForecastSeries> series) {
+    if (!series || !series->isValid || ttl_.count() <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = Entry{std::move(series), Clock::now() + ttl_};
+}
+
+void ForecastStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+ForecastSummary ForecastStore::summarize(const ForecastSeries& series, int64_t from, int64_t to) {
+    ForecastSummary summary;
+    size_t begin = static_cast<size_t>(std::lower_bound(series.time.begin(), series.time.end(), from) - series.time.begin());
+    size_t end = static_cast<size_t>(std::lower_bound(series.time.begin(), series.time.end(), to) - series.time.begin());
+    if (begin >= end) {
+        return summary;
+    }
+
+    // Each column is scanned on its own so every pass walks one contiguous array
+    const float* temperature = series.temperature.data();
+    float minTemperature = temperature[begin];
+    float maxTemperature = temperature[begin];
+    float temperatureSum = 0.0f;
+    for (size_t i = begin; i < end; ++i) {
+        minTemperature = std::min(minTemperature, temperature[i]);
+        maxTemperature = std::max(maxTemperature, temperature[i]);
+        temperatureSum += temperature[i];
+    }
+
+    const float* humidity = series.humidity.data();
+    float humiditySum = 0.0f;
+    for (size_t i = begin; i < end; ++i) {
+        humiditySum += humidity[i];
+    }
+
+    const float* windSpeed = series.windSpeed.data();
+    float maxWindSpeed = windSpeed[begin];
+    for (size_t i = begin; i < end; ++i) {
+        maxWindSpeed = std::max(maxWindSpeed, windSpeed[i]);
+    }
+
+    // A 5-day forecast has at most 40 entries, so a small linear tally is enough
+    std::vector<std::pair<uint16_t, size_t>> tally;
+    for (size_t i = begin; i < end; ++i) {
+        uint16_t code = series.condition[i];
+        auto found = std::find_if(tally.begin(), tally.end(), [code](const auto& entry) { return entry.first == code; });
+        if (found == tally.end()) {
+            tally.emplace_back(code, 1);
+        } else {
+            ++found->second;
+        }
+    }
+    auto dominant = std::max_element(tally.begin(), tally.end(), [](const auto& a, const auto& b) {
+        return a.second < b.second;
+    });
+
+    float count = static_cast<float>(end - begin);
+    summary.count = end - begin;
+    summary.minTemperature = minTemperature;
+    summary.maxTemperature = maxTemperature;
+    summary.avgTemperature = temperatureSum / count;
+    summary.avgHumidity = humiditySum / count;
+    summary.maxWindSpeed = maxWindSpeed;
+    summary.dominantCondition = dominant->first;
+    return summary;
+}
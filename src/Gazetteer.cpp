@@ -0,0 +1,512 @@
+#include "Gazetteer.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const char GAZETTEER_MAGIC[8] = {'W', 'B', 'G', 'A', 'Z', 'E', '0', '1'};
+// Four geohash characters: cells of roughly 39 x 20 km at the equator
+const int GEOHASH_BITS = 20;
+const double LATITUDE_CELL_DEGREES = 180.0 / (1 << (GEOHASH_BITS / 2));
+const double LONGITUDE_CELL_DEGREES = 360.0 / (1 << (GEOHASH_BITS / 2));
+const double EARTH_RADIUS_KM = 6371.0;
+const double KM_PER_DEGREE = EARTH_RADIUS_KM * 3.14159265358979323846 / 180.0;
+// GeoNames dumps have 19 columns; population is the 15th
+const size_t GEONAMES_COLUMNS = 15;
+const size_t SIMPLE_COLUMNS = 5;
+
+struct SourceCity {
+    uint32_t id;
+    std::string name;
+    std::string asciiName;
+    std::string country;
+    float latitude;
+    float longitude;
+    uint32_t population;
+};
+
+struct BuildNode {
+    std::map<uint8_t, size_t> children;
+    std::vector<uint32_t> cities;
+};
+
+uint32_t geohash(double latitude, double longitude) {
+    double latMin = -90.0, latMax = 90.0;
+    double lonMin = -180.0, lonMax = 180.0;
+    uint32_t hash = 0;
+    // Bits alternate between longitude and latitude, longitude first
+    for (int bit = 0; bit < GEOHASH_BITS; ++bit) {
+        hash <<= 1;
+        if (bit % 2 == 0) {
+            double mid = (lonMin + lonMax) / 2.0;
+            if (longitude >= mid) {
+                hash |= 1;
+                lonMin = mid;
+            } else {
+                lonMax = mid;
+            }
+        } else {
+            double mid = (latMin + latMax) / 2.0;
+            if (latitude >= mid) {
+                hash |= 1;
+                latMin = mid;
+            } else {
+                latMax = mid;
+            }
+        }
+    }
+    return hash;
+}
+
+double distanceKm(double lat1, double lon1, double lat2, double lon2) {
+    const double toRadians = 3.14159265358979323846 / 180.0;
+    double dLat = (lat2 - lat1) * toRadians;
+    double dLon = (lon2 - lon1) * toRadians;
+    double a = std::sin(dLat / 2) * std::sin(dLat / 2) +
+               std::cos(lat1 * toRadians) * std::cos(lat2 * toRadians) * std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+std::vector<std::string> splitTabs(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) {
+            return fields;
+        }
+        start = tab + 1;
+    }
+}
+
+bool parseSourceLine(const std::string& line, SourceCity& city) {
+    std::vector<std::string> fields = splitTabs(line);
+    try {
+        if (fields.size() >= GEONAMES_COLUMNS) {
+            city.id = static_cast<uint32_t>(std::stoul(fields[0]));
+            city.name = fields[1];
+            city.asciiName = fields[2];
+            city.latitude = std::stof(fields[4]);
+            city.longitude = std::stof(fields[5]);
+            city.country = fields[8];
+            city.population = fields[14].empty() ? 0 : static_cast<uint32_t>(std::stoul(fields[14]));
+        } else if (fields.size() >= SIMPLE_COLUMNS) {
+            city.id = static_cast<uint32_t>(std::stoul(fields[0]));
+            city.name = fields[1];
+            city.country = fields[2];
+            city.latitude = std::stof(fields[3]);
+            city.longitude = std::stof(fields[4]);
+            city.population = fields.size() > SIMPLE_COLUMNS && !fields[5].empty()
+                                  ? static_cast<uint32_t>(std::stoul(fields[5])) : 0;
+        } else {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !city.name.empty() && city.name.size() <= UINT16_MAX &&
+           std::fabs(city.latitude) <= 90.0f && std::fabs(city.longitude) <= 180.0f;
+}
+
+void emitNode(const std::vector<BuildNode>& nodes, size_t index, uint8_t label,
+              std::vector<GazetteerNode>& out, std::vector<uint32_t>& entries) {
+    size_t position = out.size();
+    out.push_back(GazetteerNode{});
+    out[position].label = label;
+    out[position].entryBegin = static_cast<uint32_t>(entries.size());
+    entries.insert(entries.end(), nodes[index].cities.begin(), nodes[index].cities.end());
+    out[position].exactEnd = static_cast<uint32_t>(entries.size());
+
+    size_t previousChild = 0;
+    for (const auto& child : nodes[index].children) {
+        size_t childPosition = out.size();
+        if (previousChild != 0) {
+            out[previousChild].nextSibling = static_cast<uint32_t>(childPosition);
+        }
+        emitNode(nodes, child.second, child.first, out, entries);
+        previousChild = childPosition;
+    }
+
+    out[position].hasChildren = nodes[index].children.empty() ? 0 : 1;
+    out[position].subtreeEnd = static_cast<uint32_t>(entries.size());
+}
+
+template <typename T>
+bool writeSection(std::FILE* file, const std::vector<T>& section) {
+    return section.empty() || std::fwrite(section.data(), sizeof(T), section.size(), file) == section.size();
+}
+
+} // namespace
+
+Gazetteer::Gazetteer()
+    : header_(nullptr), records_(nullptr), nodes_(nullptr), entries_(nullptr), cells_(nullptr), strings_(nullptr) {
+}
+
+Gazetteer::~Gazetteer() {
+}
+
+std::string Gazetteer::normalize(std::string_view name) {
+    std::string key;
+    key.reserve(name.size());
+    bool pendingSpace = false;
+    for (char c : name) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !key.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            key += ' ';
+            pendingSpace = false;
+        }
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+bool Gazetteer::compile(const std::string& tsvPath, const std::string& outputPath) {
+    std::ifstream input(tsvPath);
+    if (!input) {
+        std::cerr << "Error: Cannot read " << tsvPath << std::endl;
+        return false;
+    }
+
+    std::vector<SourceCity> cities;
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        SourceCity city;
+        if (parseSourceLine(line, city)) {
+            cities.push_back(std::move(city));
+        } else {
+            ++skipped;
+        }
+    }
+    if (cities.empty()) {
+        std::cerr << "Error: No cities found in " << tsvPath << std::endl;
+        return false;
+    }
+
+    std::vector<GazetteerRecord> records;
+    std::string strings;
+    std::vector<BuildNode> trie(1);
+    std::vector<GazetteerCell> cells;
+    records.reserve(cities.size());
+    cells.reserve(cities.size());
+
+    for (const SourceCity& source : cities) {
+        uint32_t index = static_cast<uint32_t>(records.size());
+        GazetteerRecord record{};
+        record.id = source.id;
+        record.nameOffset = static_cast<uint32_t>(strings.size());
+        record.nameLength = static_cast<uint16_t>(source.name.size());
+        record.population = source.population;
+        record.latitude = source.latitude;
+        record.longitude = source.longitude;
+        record.country[0] = source.country.size() > 0 ? static_cast<char>(std::toupper(static_cast<unsigned char>(source.country[0]))) : ' ';
+        record.country[1] = source.country.size() > 1 ? static_cast<char>(std::toupper(static_cast<unsigned char>(source.country[1]))) : ' ';
+        records.push_back(record);
+        strings += source.name;
+        cells.push_back(GazetteerCell{geohash(source.latitude, source.longitude), index});
+
+        // The ASCII spelling is indexed too, so "Zurich" finds "Zürich"
+        std::string keys[2] = {normalize(source.name), normalize(source.asciiName)};
+        for (size_t k = 0; k < 2; ++k) {
+            if (keys[k].empty() || (k == 1 && keys[1] == keys[0])) {
+                continue;
+            }
+            size_t node = 0;
+            for (char c : keys[k]) {
+                uint8_t label = static_cast<uint8_t>(c);
+                auto found = trie[node].children.find(label);
+                if (found == trie[node].children.end()) {
+                    trie.emplace_back();
+                    found = trie[node].children.emplace(label, trie.size() - 1).first;
+                }
+                node = found->second;
+            }
+            trie[node].cities.push_back(index);
+        }
+    }
+
+    // Entries for one name go most populous first, which is what resolve() picks
+    for (BuildNode& node : trie) {
+        std::sort(node.cities.begin(), node.cities.end(), [&records](uint32_t a, uint32_t b) {
+            if (records[a].population != records[b].population) {
+                return records[a].population > records[b].population;
+            }
+            return a < b;
+        });
+    }
+
+    std::vector<GazetteerNode> nodes;
+    std::vector<uint32_t> entries;
+    nodes.reserve(trie.size());
+    emitNode(trie, 0, 0, nodes, entries);
+
+    std::sort(cells.begin(), cells.end(), [](const GazetteerCell& a, const GazetteerCell& b) {
+        return a.cell != b.cell ? a.cell < b.cell : a.city < b.city;
+    });
+
+    GazetteerHeader header{};
+    std::memcpy(header.magic, GAZETTEER_MAGIC, sizeof(GAZETTEER_MAGIC));
+    header.cityCount = static_cast<uint32_t>(records.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.cellCount = static_cast<uint32_t>(cells.size());
+    header.stringBytes = static_cast<uint32_t>(strings.size());
+
+    // Written beside the target and renamed, so a running instance never maps a partial file
+    std::string tempPath = outputPath + ".tmp";
+    std::FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Cannot write " << tempPath << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   writeSection(file, records) && writeSection(file, nodes) &&
+                   writeSection(file, entries) && writeSection(file, cells) &&
+                   (strings.empty() || std::fwrite(strings.data(), 1, strings.size(), file) == strings.size());
+    written = std::fclose(file) == 0 && written;
+    if (!written || std::rename(tempPath.c_str(), outputPath.c_str()) != 0) {
+        std::cerr << "Error: Failed to write " << outputPath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::cout << "Compiled " << records.size() << " cities (" << nodes.size() << " trie nodes";
+    if (skipped > 0) {
+        std::cout << ", " << skipped << " malformed lines skipped";
+    }
+    std::cout << ") into " << outputPath << std::endl;
+    return true;
+}
+
+bool Gazetteer::open(const std::string& path) {
+    header_ = nullptr;
+    file_ = std::make_unique<MappedFile>(path);
+    const char* data = file_->data();
+    size_t size = file_->size();
+    if (!data || size < sizeof(GazetteerHeader) || std::memcmp(data, GAZETTEER_MAGIC, sizeof(GAZETTEER_MAGIC)) != 0) {
+        file_.reset();
+        return false;
+    }
+
+    const GazetteerHeader* header = reinterpret_cast<const GazetteerHeader*>(data);
+    uint64_t expected = sizeof(GazetteerHeader) +
+                        static_cast<uint64_t>(header->cityCount) * sizeof(GazetteerRecord) +
+                        static_cast<uint64_t>(header->nodeCount) * sizeof(GazetteerNode) +
+                        static_cast<uint64_t>(header->entryCount) * sizeof(uint32_t) +
+                        static_cast<uint64_t>(header->cellCount) * sizeof(GazetteerCell) +
+                        header->stringBytes;
+    if (expected != size || header->nodeCount == 0) {
+        file_.reset();
+        return false;
+    }
+
+    const char* cursor = data + sizeof(GazetteerHeader);
+    records_ = reinterpret_cast<const GazetteerRecord*>(cursor);
+    cursor += header->cityCount * sizeof(GazetteerRecord);
+    nodes_ = reinterpret_cast<const GazetteerNode*>(cursor);
+    cursor += header->nodeCount * sizeof(GazetteerNode);
+    entries_ = reinterpret_cast<const uint32_t*>(cursor);
+    cursor += header->entryCount * sizeof(uint32_t);
+    cells_ = reinterpret_cast<const GazetteerCell*>(cursor);
+    cursor += header->cellCount * sizeof(GazetteerCell);
+    strings_ = cursor;
+    header_ = header;
+
+    if (!validate()) {
+        header_ = nullptr;
+        file_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool Gazetteer::validate() const {
+    // Every index is checked once up front so lookups can trust the file
+    const GazetteerHeader& header = *header_;
+    for (uint32_t i = 0; i < header.cityCount; ++i) {
+        if (static_cast<uint64_t>(records_[i].nameOffset) + records_[i].nameLength > header.stringBytes) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.nodeCount; ++i) {
+        const GazetteerNode& node = nodes_[i];
+        // Siblings only point forward, so walking a chain always terminates
+        bool siblingValid = node.nextSibling == 0 || (node.nextSibling > i && node.nextSibling < header.nodeCount);
+        bool rangeValid = node.entryBegin <= node.exactEnd && node.exactEnd <= node.subtreeEnd &&
+                          node.subtreeEnd <= header.entryCount;
+        if (!siblingValid || !rangeValid || (node.hasChildren && i + 1 >= header.nodeCount)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (entries_[i] >= header.cityCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.cellCount; ++i) {
+        if (cells_[i].city >= header.cityCount || (i > 0 && cells_[i].cell < cells_[i - 1].cell)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+long Gazetteer::findNode(std::string_view key) const {
+    uint32_t node = 0;
+    for (char c : key) {
+        uint8_t label = static_cast<uint8_t>(c);
+        if (!nodes_[node].hasChildren) {
+            return -1;
+        }
+        // Children are sorted by label
+        uint32_t child = node + 1;
+        while (nodes_[child].label < label && nodes_[child].nextSibling != 0) {
+            child = nodes_[child].nextSibling;
+        }
+        if (nodes_[child].label != label) {
+            return -1;
+        }
+        node = child;
+    }
+    return static_cast<long>(node);
+}
+
+GazetteerCity Gazetteer::cityAt(uint32_t index) const {
+    const GazetteerRecord& record = records_[index];
+    GazetteerCity city;
+    city.id = static_cast<long>(record.id);
+    city.name.assign(strings_ + record.nameOffset, record.nameLength);
+    city.country.assign(record.country, record.country[0] == ' ' ? 0 : (record.country[1] == ' ' ? 1 : 2));
+    city.latitude = record.latitude;
+    city.longitude = record.longitude;
+    city.population = record.population;
+    return city;
+}
+
+bool Gazetteer::resolve(std::string_view name, GazetteerCity& city) const {
+    if (!isLoaded()) {
+        return false;
+    }
+
+    // An OpenWeatherMap-style ",CC" suffix restricts the match to one country
+    std::string country;
+    size_t comma = name.rfind(',');
+    if (comma != std::string_view::npos) {
+        std::string suffix = normalize(name.substr(comma + 1));
+        if (suffix.size() == 2 && std::isalpha(static_cast<unsigned char>(suffix[0])) &&
+            std::isalpha(static_cast<unsigned char>(suffix[1]))) {
+            country = {static_cast<char>(std::toupper(static_cast<unsigned char>(suffix[0]))),
+                       static_cast<char>(std::toupper(static_cast<unsigned char>(suffix[1])))};
+            name = name.substr(0, comma);
+        }
+    }
+
+    long node = findNode(normalize(name));
+    if (node < 0) {
+        return false;
+    }
+    for (uint32_t i = nodes_[node].entryBegin; i < nodes_[node].exactEnd; ++i) {
+        const GazetteerRecord& record = records_[entries_[i]];
+        if (country.empty() || (record.country[0] == country[0] && record.country[1] == country[1])) {
+            city = cityAt(entries_[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<GazetteerCity> Gazetteer::complete(std::string_view prefix, size_t limit) const {
+    std::vector<GazetteerCity> matches;
+    if (!isLoaded() || limit == 0) {
+        return matches;
+    }
+    long node = findNode(normalize(prefix));
+    if (node < 0) {
+        return matches;
+    }
+
+    // The whole subtree's entries are contiguous; a city may appear under two spellings
+    std::vector<uint32_t> candidates(entries_ + nodes_[node].entryBegin, entries_ + nodes_[node].subtreeEnd);
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    size_t count = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(count), candidates.end(),
+                      [this](uint32_t a, uint32_t b) {
+                          if (records_[a].population != records_[b].population) {
+                              return records_[a].population > records_[b].population;
+                          }
+                          return a < b;
+                      });
+
+    matches.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        matches.push_back(cityAt(candidates[i]));
+    }
+    return matches;
+}
+
+bool Gazetteer::nearest(double latitude, double longitude, double maxDistanceKm, GazetteerCity& city) const {
+    if (!isLoaded() || std::fabs(latitude) > 90.0 || std::fabs(longitude) > 180.0) {
+        return false;
+    }
+
+    // Scan every cell that can hold a point within range: a fixed number of rows,
+    // and more columns towards the poles where cells get narrower
+    int rows = static_cast<int>(std::ceil(maxDistanceKm / (LATITUDE_CELL_DEGREES * KM_PER_DEGREE)));
+    double columnKm = LONGITUDE_CELL_DEGREES * KM_PER_DEGREE *
+                      std::cos((std::min(89.0, std::fabs(latitude) + rows * LATITUDE_CELL_DEGREES)) * 3.14159265358979323846 / 180.0);
+    int maxColumns = 1 << (GEOHASH_BITS / 2 - 1);
+    int columns = std::min(maxColumns, static_cast<int>(std::ceil(maxDistanceKm / columnKm)));
+
+    std::vector<uint32_t> scanned;
+    double bestDistance = maxDistanceKm;
+    long best = -1;
+    for (int row = -rows; row <= rows; ++row) {
+        double cellLatitude = latitude + row * LATITUDE_CELL_DEGREES;
+        if (cellLatitude < -90.0 || cellLatitude > 90.0) {
+            continue;
+        }
+        for (int column = -columns; column <= columns; ++column) {
+            double cellLongitude = longitude + column * LONGITUDE_CELL_DEGREES;
+            cellLongitude -= 360.0 * std::floor((cellLongitude + 180.0) / 360.0);
+            uint32_t cell = geohash(cellLatitude, cellLongitude);
+            if (std::find(scanned.begin(), scanned.end(), cell) != scanned.end()) {
+                continue;
+            }
+            scanned.push_back(cell);
+
+            auto range = std::equal_range(cells_, cells_ + header_->cellCount, GazetteerCell{cell, 0},
+                                          [](const GazetteerCell& a, const GazetteerCell& b) { return a.cell < b.cell; });
+            for (auto it = range.first; it != range.second; ++it) {
+                const GazetteerRecord& record = records_[it->city];
+                double distance = distanceKm(latitude, longitude, record.latitude, record.longitude);
+                if (distance <= bestDistance) {
+                    bestDistance = distance;
+                    best = static_cast<long>(it->city);
+                }
+            }
+        }
+    }
+
+    if (best < 0) {
+        return false;
+    }
+    city = cityAt(static_cast<uint32_t>(best));
+    return true;
+}
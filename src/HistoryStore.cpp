@@ -0,0 +1,583 @@
+#include "HistoryStore.h"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <cmath>
+
+namespace {
+
+const uint32_t BLOCK_MAGIC = 0x31484257;  // "WBH1"
+const char* const FILE_EXTENSION = ".wbh";
+const size_t SERIES_COUNT = 3;
+// Leading-zero counts are stored in five bits
+const unsigned MAX_LEADING = 31;
+// Marks a series whose block has not yet set a leading/trailing window
+const unsigned NO_WINDOW = 33;
+
+// Bits are appended most significant first; n is at most 32
+void writeBits(std::vector<uint8_t>& payload, uint64_t& buffer, unsigned& count, uint64_t value, unsigned n) {
+    if (n == 0) {
+        return;
+    }
+    buffer = (buffer << n) | (value & ((uint64_t(1) << n) - 1));
+    count += n;
+    while (count >= 8) {
+        payload.push_back(static_cast<uint8_t>(buffer >> (count - 8)));
+        count -= 8;
+    }
+}
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data_(data), size_(size), position_(0), overrun_(false) {}
+
+    uint64_t read(unsigned n) {
+        uint64_t value = 0;
+        while (n > 0) {
+            size_t byte = position_ >> 3;
+            if (byte >= size_) {
+                overrun_ = true;
+                return 0;
+            }
+            unsigned available = 8 - static_cast<unsigned>(position_ & 7);
+            unsigned take = std::min(available, n);
+            uint64_t bits = (data_[byte] >> (available - take)) & ((1u << take) - 1);
+            value = (value << take) | bits;
+            position_ += take;
+            n -= take;
+        }
+        return value;
+    }
+
+    bool bit() { return read(1) != 0; }
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_;
+    bool overrun_;
+};
+
+// Reads size bits as a two's complement value
+int64_t signExtend(uint64_t value, unsigned size) {
+    uint64_t sign = uint64_t(1) << (size - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+// Whether a float is exactly the nearest float to some number of hundredths,
+// as API readings are; the scaled integer then stands for it losslessly
+bool toHundredths(uint32_t bits, int64_t& scaled) {
+    float value = std::bit_cast<float>(bits);
+    if (!std::isfinite(value) || std::fabs(value) > 1e7f) {
+        return false;
+    }
+    scaled = std::llround(static_cast<double>(value) * 100.0);
+    return std::bit_cast<uint32_t>(static_cast<float>(static_cast<double>(scaled) / 100.0)) == bits;
+}
+
+uint32_t fromHundredths(int64_t scaled) {
+    return std::bit_cast<uint32_t>(static_cast<float>(static_cast<double>(scaled) / 100.0));
+}
+
+bool fitsDeltaOfDelta(int64_t value) {
+    return value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max();
+}
+
+void include(HistoryRange& range, float value, bool first) {
+    range.min = first ? value : std::min(range.min, value);
+    range.max = first ? value : std::max(range.max, value);
+    range.sum += value;
+}
+
+// File names keep letters, digits and a few separators; everything else is percent-encoded
+std::string encodeFileName(const std::string& location) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string name;
+    for (char c : location) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte) || c == ',' || c == '-' || c == '_') {
+            name += c;
+        } else {
+            name += '%';
+            name += HEX[byte >> 4];
+            name += HEX[byte & 0x0F];
+        }
+    }
+    return name + FILE_EXTENSION;
+}
+
+bool decodeFileName(const std::string& name, std::string& location) {
+    size_t extension = std::strlen(FILE_EXTENSION);
+    if (name.size() <= extension || name.compare(name.size() - extension, extension, FILE_EXTENSION) != 0) {
+        return false;
+    }
+    location.clear();
+    for (size_t i = 0; i + extension < name.size(); ++i) {
+        if (name[i] == '%' && i + 2 + extension < name.size()) {
+            location += static_cast<char>(std::strtol(name.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            location += name[i];
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t first = text.find_first_not_of(' ');
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(' ') - first + 1);
+}
+
+bool matchesLocation(const std::string& location, const std::string& query) {
+    if (query.find(',') != std::string::npos) {
+        return location == query;
+    }
+    size_t comma = location.find(',');
+    return location.compare(0, comma, query) == 0 && comma == query.size();
+}
+
+} // namespace
+
+HistoryStore::HistoryStore(const std::string& directory)
+    : directory_(directory), writtenSamples_(0), writtenBytes_(0) {
+}
+
+HistoryStore::~HistoryStore() {
+    flush();
+}
+
+bool HistoryStore::open() {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        std::cerr << "Error: Cannot create history directory " << directory_ << ": " << error.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string HistoryStore::locationKey(std::string_view city, std::string_view country) {
+    std::string key;
+    key.reserve(city.size() + country.size() + 1);
+    for (char c : city) {
+        // The comma separates city from country
+        key += c == ',' ? ' ' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    key += ',';
+    for (char c : country) {
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+std::string HistoryStore::pathFor(const std::string& location) const {
+    return (std::filesystem::path(directory_) / encodeFileName(location)).string();
+}
+
+void HistoryStore::append(const WeatherData& data) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    append(data, std::chrono::duration_cast<std::chrono::seconds>(now).count());
+}
+
+void HistoryStore::append(const WeatherData& data, int64_t time) {
+    if (!data.isValid || data.isStale || data.city().empty()) {
+        return;
+    }
+    std::string location = locationKey(data.city(), data.country());
+    const float values[SERIES_COUNT] = {data.temperature, data.humidity, data.windSpeed};
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    OpenBlock& block = open_[location];
+    // Blocks stay in time order, so a clock that went back, or jumped too far
+    // for the timestamp encoding, starts a new one
+    if (block.count > 0 && (time < block.lastTime || !fitsDeltaOfDelta((time - block.lastTime) - block.lastDelta))) {
+        writeBlockLocked(location, block);
+    }
+    encode(block, time, values);
+    if (block.count >= BLOCK_SAMPLES) {
+        writeBlockLocked(location, block);
+    }
+}
+
+void HistoryStore::encode(OpenBlock& block, int64_t time, const float values[3]) {
+    if (block.count == 0) {
+        // The first timestamp lives in the header and the first values are stored whole
+        block.firstTime = time;
+        block.lastTime = time;
+        block.lastDelta = 0;
+        for (size_t i = 0; i < SERIES_COUNT; ++i) {
+            block.lastBits[i] = std::bit_cast<uint32_t>(values[i]);
+            block.leading[i] = NO_WINDOW;
+            block.trailing[i] = 0;
+            writeBits(block.payload, block.bitBuffer, block.bitCount, block.lastBits[i], 32);
+        }
+        block.count = 1;
+        return;
+    }
+
+    // Regular sampling makes the delta-of-delta zero or small: '0', or a prefix and
+    // 5, 9, 12 or 32 bits. Timestamps are seconds, so scheduler jitter of a few
+    // seconds fits the first bucket.
+    int64_t delta = time - block.lastTime;
+    int64_t deltaOfDelta = delta - block.lastDelta;
+    if (deltaOfDelta == 0) {
+        writeBits(block.payload, block.bitBuffer, block.bitCount, 0, 1);
+    } else if (deltaOfDelta >= -15 && deltaOfDelta <= 16) {
+        writeBits(block.payload, block.bitBuffer, block.bitCount, 0b10, 2);
+        writeBits(block.payload, block.bitBuffer, block.bitCount, static_cast<uint64_t>(deltaOfDelta + 15), 5);
+    } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+        writeBits(block.payload, block.bitBuffer, block.bitCount, 0b110, 3);
+        writeBits(block.payload, block.bitBuffer, block.bitCount, static_cast<uint64_t>(deltaOfDelta + 255), 9);
+    } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+        writeBits(block.payload, block.bitBuffer, block.bitCount, 0b1110, 4);
+        writeBits(block.payload, block.bitBuffer, block.bitCount, static_cast<uint64_t>(deltaOfDelta + 2047), 12);
+    } else {
+        writeBits(block.payload, block.bitBuffer, block.bitCount, 0b1111, 4);
+        writeBits(block.payload, block.bitBuffer, block.bitCount, static_cast<uint32_t>(deltaOfDelta), 32);
+    }
+    block.lastDelta = delta;
+    block.lastTime = time;
+
+    // Each value is '0' when unchanged. Readings the APIs report in hundredths
+    // are '10' and the zigzag difference of the two scaled integers, in 4, 8 or
+    // 16 bits, as the XOR of two such floats is mostly noise. Anything else is
+    // XORed Gorilla-style: '110' and the meaningful bits when they fit the
+    // previous window, else '111', the window and the bits.
+    for (size_t i = 0; i < SERIES_COUNT; ++i) {
+        uint32_t bits = std::bit_cast<uint32_t>(values[i]);
+        uint32_t previous = block.lastBits[i];
+        uint32_t xored = bits ^ previous;
+        block.lastBits[i] = bits;
+        if (xored == 0) {
+            writeBits(block.payload, block.bitBuffer, block.bitCount, 0, 1);
+            continue;
+        }
+        int64_t scaled = 0;
+        int64_t previousScaled = 0;
+        if (toHundredths(bits, scaled) && toHundredths(previous, previousScaled)) {
+            int64_t difference = scaled - previousScaled;
+            uint64_t zigzag = (static_cast<uint64_t>(difference) << 1) ^ static_cast<uint64_t>(difference >> 63);
+            if (zigzag < (1u << 16)) {
+                writeBits(block.payload, block.bitBuffer, block.bitCount, 0b10, 2);
+                if (zigzag < (1u << 4)) {
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, 0, 1);
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, zigzag, 4);
+                } else if (zigzag < (1u << 8)) {
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, 0b10, 2);
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, zigzag, 8);
+                } else {
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, 0b11, 2);
+                    writeBits(block.payload, block.bitBuffer, block.bitCount, zigzag, 16);
+                }
+                continue;
+            }
+        }
+        unsigned leading = std::min<unsigned>(std::countl_zero(xored), MAX_LEADING);
+        unsigned trailing = static_cast<unsigned>(std::countr_zero(xored));
+        if (block.leading[i] != NO_WINDOW && leading >= block.leading[i] && trailing >= block.trailing[i]) {
+            unsigned width = 32 - block.leading[i] - block.trailing[i];
+            writeBits(block.payload, block.bitBuffer, block.bitCount, 0b110, 3);
+            writeBits(block.payload, block.bitBuffer, block.bitCount, xored >> block.trailing[i], width);
+        } else {
+            unsigned width = 32 - leading - trailing;
+            writeBits(block.payload, block.bitBuffer, block.bitCount, 0b111, 3);
+            writeBits(block.payload, block.bitBuffer, block.bitCount, leading, 5);
+            writeBits(block.payload, block.bitBuffer, block.bitCount, width - 1, 5);
+            writeBits(block.payload, block.bitBuffer, block.bitCount, xored >> trailing, width);
+            block.leading[i] = leading;
+            block.trailing[i] = trailing;
+        }
+    }
+    ++block.count;
+}
+
+void HistoryStore::seal(const OpenBlock& block, HistoryBlockHeader& header, std::vector<uint8_t>& payload) {
+    payload = block.payload;
+    if (block.bitCount > 0) {
+        payload.push_back(static_cast<uint8_t>(block.bitBuffer << (8 - block.bitCount)));
+    }
+    header.magic = BLOCK_MAGIC;
+    header.count = block.count;
+    header.payloadBytes = static_cast<uint32_t>(payload.size());
+    header.reserved = 0;
+    header.firstTime = block.firstTime;
+    header.lastTime = block.lastTime;
+    header.checksum = checksum(payload);
+}
+
+void HistoryStore::decode(const HistoryBlockHeader& header, const std::vector<uint8_t>& payload,
+                          const std::function<void(const HistorySample&)>& visit) {
+    BitReader reader(payload.data(), payload.size());
+    uint32_t bits[SERIES_COUNT] = {};
+    unsigned leading[SERIES_COUNT] = {};
+    unsigned trailing[SERIES_COUNT] = {};
+    int64_t time = header.firstTime;
+    int64_t delta = 0;
+
+    for (uint32_t n = 0; n < header.count; ++n) {
+        if (n == 0) {
+            for (size_t i = 0; i < SERIES_COUNT; ++i) {
+                bits[i] = static_cast<uint32_t>(reader.read(32));
+            }
+        } else {
+            int64_t deltaOfDelta = 0;
+            if (!reader.bit()) {
+                deltaOfDelta = 0;
+            } else if (!reader.bit()) {
+                deltaOfDelta = static_cast<int64_t>(reader.read(5)) - 15;
+            } else if (!reader.bit()) {
+                deltaOfDelta = static_cast<int64_t>(reader.read(9)) - 255;
+            } else if (!reader.bit()) {
+                deltaOfDelta = static_cast<int64_t>(reader.read(12)) - 2047;
+            } else {
+                deltaOfDelta = signExtend(reader.read(32), 32);
+            }
+            delta += deltaOfDelta;
+            time += delta;
+
+            for (size_t i = 0; i < SERIES_COUNT; ++i) {
+                if (!reader.bit()) {
+                    continue;
+                }
+                if (!reader.bit()) {
+                    unsigned size = !reader.bit() ? 4 : !reader.bit() ? 8 : 16;
+                    uint64_t zigzag = reader.read(size);
+                    int64_t difference = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+                    int64_t previous = 0;
+                    toHundredths(bits[i], previous);
+                    bits[i] = fromHundredths(previous + difference);
+                    continue;
+                }
+                if (reader.bit()) {
+                    leading[i] = static_cast<unsigned>(reader.read(5));
+                    unsigned width = static_cast<unsigned>(reader.read(5)) + 1;
+                    trailing[i] = 32 - leading[i] - width;
+                }
+                unsigned width = 32 - leading[i] - trailing[i];
+                bits[i] ^= static_cast<uint32_t>(reader.read(width)) << trailing[i];
+            }
+        }
+        if (reader.overrun()) {
+            return;
+        }
+
+        HistorySample sample;
+        sample.time = time;
+        sample.temperature = std::bit_cast<float>(bits[0]);
+        sample.humidity = std::bit_cast<float>(bits[1]);
+        sample.windSpeed = std::bit_cast<float>(bits[2]);
+        visit(sample);
+    }
+}
+
+uint64_t HistoryStore::checksum(const std::vector<uint8_t>& payload) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (uint8_t byte : payload) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void HistoryStore::recoverLocked(const std::string& location) {
+    if (!recovered_.insert(location).second) {
+        return;
+    }
+    // A crash mid-write leaves a partial block at the end; later blocks must not follow it
+    std::string path = pathFor(location);
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return;
+    }
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    uint64_t valid = 0;
+    HistoryBlockHeader header;
+    while (std::fread(&header, sizeof(header), 1, file) == 1 && header.magic == BLOCK_MAGIC &&
+           valid + sizeof(header) + header.payloadBytes <= size) {
+        valid += sizeof(header) + header.payloadBytes;
+        std::fseek(file, static_cast<long>(valid), SEEK_SET);
+    }
+    std::fclose(file);
+    if (!error && valid < size) {
+        std::cerr << "Warning: Dropping a torn block at the end of " << path << std::endl;
+        std::filesystem::resize_file(path, valid, error);
+    }
+}
+
+void HistoryStore::writeBlockLocked(const std::string& location, OpenBlock& block) {
+    if (block.count == 0) {
+        return;
+    }
+    HistoryBlockHeader header;
+    std::vector<uint8_t> payload;
+    seal(block, header, payload);
+    block = OpenBlock();
+
+    recoverLocked(location);
+    std::string path = pathFor(location);
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        std::cerr << "Error: Failed to open history file " << path << std::endl;
+        return;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+    if (std::fclose(file) != 0 || !written) {
+        std::cerr << "Error: Failed to write history file " << path << std::endl;
+        return;
+    }
+    writtenSamples_ += header.count;
+    writtenBytes_ += sizeof(header) + payload.size();
+}
+
+void HistoryStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : open_) {
+        writeBlockLocked(entry.first, entry.second);
+    }
+    open_.clear();
+}
+
+bool HistoryStore::scan(const std::string& location, int64_t since, int64_t until,
+                        const std::function<void(const HistorySample&)>& visit, HistorySummary* blocks) {
+    std::string path = pathFor(location);
+    std::error_code error;
+    uint64_t size = 0;
+    bool pending = false;
+    HistoryBlockHeader openHeader;
+    std::vector<uint8_t> openPayload;
+    {
+        // The file up to its current size and the open block together are one consistent view
+        std::lock_guard<std::mutex> lock(mutex_);
+        size = std::filesystem::file_size(path, error);
+        if (error) {
+            size = 0;
+        }
+        auto found = open_.find(location);
+        if (found != open_.end() && found->second.count > 0) {
+            seal(found->second, openHeader, openPayload);
+            pending = true;
+        }
+    }
+    if (size == 0 && !pending) {
+        return false;
+    }
+
+    // Only one block is held at a time, however long the history
+    auto visitInRange = [&](const HistorySample& sample) {
+        if (sample.time >= since && sample.time < until) {
+            visit(sample);
+        }
+    };
+    std::FILE* file = size > 0 ? std::fopen(path.c_str(), "rb") : nullptr;
+    if (file) {
+        std::vector<uint8_t> payload;
+        uint64_t offset = 0;
+        HistoryBlockHeader header;
+        while (offset + sizeof(header) <= size && std::fread(&header, sizeof(header), 1, file) == 1) {
+            if (header.magic != BLOCK_MAGIC || offset + sizeof(header) + header.payloadBytes > size) {
+                break;
+            }
+            offset += sizeof(header) + header.payloadBytes;
+            if (header.lastTime < since || header.firstTime >= until) {
+                std::fseek(file, static_cast<long>(offset), SEEK_SET);
+                if (blocks) {
+                    ++blocks->blocksSkipped;
+                }
+                continue;
+            }
+            payload.resize(header.payloadBytes);
+            if (std::fread(payload.data(), 1, payload.size(), file) != payload.size() ||
+                checksum(payload) != header.checksum) {
+                break;
+            }
+            decode(header, payload, visitInRange);
+            if (blocks) {
+                ++blocks->blocksRead;
+            }
+        }
+        std::fclose(file);
+    }
+    if (pending && openHeader.lastTime >= since && openHeader.firstTime < until) {
+        decode(openHeader, openPayload, visitInRange);
+        if (blocks) {
+            ++blocks->blocksRead;
+        }
+    }
+    return true;
+}
+
+bool HistoryStore::summarize(const std::string& location, int64_t since, int64_t until, HistorySummary& summary) {
+    summary = HistorySummary();
+    return scan(location, since, until, [&summary](const HistorySample& sample) {
+        bool first = summary.count == 0;
+        summary.firstTime = first ? sample.time : std::min(summary.firstTime, sample.time);
+        summary.lastTime = std::max(summary.lastTime, sample.time);
+        include(summary.temperature, sample.temperature, first);
+        include(summary.humidity, sample.humidity, first);
+        include(summary.windSpeed, sample.windSpeed, first);
+        ++summary.count;
+    }, &summary);
+}
+
+std::vector<std::string> HistoryStore::findLocations(std::string_view query) {
+    // "Oslo, NO" and "oslo,no" name the same location
+    size_t comma = query.find(',');
+    std::string wanted = comma == std::string_view::npos
+        ? locationKey(trim(query), "")
+        : locationKey(trim(query.substr(0, comma)), trim(query.substr(comma + 1)));
+    if (comma == std::string_view::npos) {
+        wanted.pop_back();
+    }
+
+    std::vector<std::string> locations;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, error)) {
+        std::string location;
+        if (entry.is_regular_file() && decodeFileName(entry.path().filename().string(), location) &&
+            matchesLocation(location, wanted)) {
+            locations.push_back(location);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : open_) {
+            if (matchesLocation(entry.first, wanted)) {
+                locations.push_back(entry.first);
+            }
+        }
+    }
+    std::sort(locations.begin(), locations.end());
+    locations.erase(std::unique(locations.begin(), locations.end()), locations.end());
+    return locations;
+}
+
+HistoryStats HistoryStore::getStats() {
+    HistoryStats stats;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_, error)) {
+        std::string location;
+        if (entry.is_regular_file() && decodeFileName(entry.path().filename().string(), location)) {
+            ++stats.locations;
+            stats.diskBytes += entry.file_size(error);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : open_) {
+        stats.pending += entry.second.count;
+    }
+    stats.writtenSamples = writtenSamples_;
+    stats.writtenBytes = writtenBytes_;
+    return stats;
+}
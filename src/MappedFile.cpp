@@ -0,0 +1,44 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (file) {
+        buffer_.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data_ = static_cast<const char*>(mapped);
+            size_ = static_cast<size_t>(info.st_size);
+        }
+    }
+    close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
@@ -0,0 +1,272 @@
+#include "Metrics.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+const std::array<double, Histogram::BUCKET_COUNT - 1> Histogram::BOUNDS = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+void Histogram::observe(double seconds) {
+    if (seconds < 0) {
+        seconds = 0;
+    }
+    size_t index = static_cast<size_t>(std::lower_bound(BOUNDS.begin(), BOUNDS.end(), seconds) - BOUNDS.begin());
+    buckets_[index].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumMicros_.fetch_add(static_cast<uint64_t>(seconds * 1e6), std::memory_order_relaxed);
+}
+
+double Histogram::getSum() const {
+    return static_cast<double>(sumMicros_.load(std::memory_order_relaxed)) / 1e6;
+}
+
+double Histogram::quantile(double q) const {
+    uint64_t total = getCount();
+    if (total == 0) {
+        return 0.0;
+    }
+
+    // Linear interpolation inside the bucket holding the target rank
+    double rank = q * static_cast<double>(total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        uint64_t inBucket = getBucket(i);
+        if (inBucket > 0 && static_cast<double>(seen + inBucket) >= rank) {
+            double lower = i == 0 ? 0.0 : BOUNDS[i - 1];
+            if (i == BUCKET_COUNT - 1) {
+                return lower;
+            }
+            double fraction = (rank - static_cast<double>(seen)) / static_cast<double>(inBucket);
+            return lower + (BOUNDS[i] - lower) * std::clamp(fraction, 0.0, 1.0);
+        }
+        seen += inBucket;
+    }
+    return BOUNDS.back();
+}
+
+Metrics::Metrics() {
+}
+
+const char* Metrics::stageName(Stage stage) {
+    switch (stage) {
+        case Stage::DNS:
+            return "dns";
+        case Stage::CONNECT:
+            return "connect";
+        case Stage::TLS:
+            return "tls";
+        case Stage::TIME_TO_FIRST_BYTE:
+            return "ttfb";
+        case Stage::TRANSFER:
+            return "transfer";
+        case Stage::UPSTREAM:
+            return "upstream";
+        case Stage::PARSE:
+            return "parse";
+        case Stage::FORMAT:
+            return "format";
+        case Stage::COMMAND:
+            return "command";
+        default:
+            return "unknown";
+    }
+}
+
+const char* Metrics::eventName(UpstreamEvent event) {
+    switch (event) {
+        case UpstreamEvent::RETRY:
+            return "retry";
+        case UpstreamEvent::HEDGE:
+            return "hedge";
+        case UpstreamEvent::HEDGE_WON:
+            return "hedge_won";
+        case UpstreamEvent::BREAKER_REJECTED:
+            return "breaker_rejected";
+        case UpstreamEvent::STALE_SERVED:
+            return "stale_served";
+        case UpstreamEvent::THROTTLED:
+            return "throttled";
+        case UpstreamEvent::RATE_LIMITED:
+            return "rate_limited";
+        case UpstreamEvent::FAILOVER:
+            return "failover";
+        case UpstreamEvent::RACE:
+            return "race";
+        default:
+            return "unknown";
+    }
+}
+
+void Metrics::recordEvent(UpstreamEvent event) {
+    events_[static_cast<size_t>(event)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::observe(Stage stage, double seconds) {
+    histograms_[static_cast<size_t>(stage)].observe(seconds);
+}
+
+void Metrics::observe(Stage stage, std::chrono::steady_clock::duration elapsed) {
+    observe(stage, std::chrono::duration<double>(elapsed).count());
+}
+
+void Metrics::recordTransfer(CURL* handle, CURLcode result) {
+    ++requests_;
+    if (result != CURLE_OK && result < CURL_LAST) {
+        curlErrors_[result].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    long status = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+    if (status > 0 && status < static_cast<long>(MAX_HTTP_STATUS)) {
+        httpStatus_[static_cast<size_t>(status)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    long opened = 0;
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &opened);
+    connections_.fetch_add(static_cast<uint64_t>(std::max(opened, 0L)), std::memory_order_relaxed);
+    long version = 0;
+    curl_easy_getinfo(handle, CURLINFO_HTTP_VERSION, &version);
+    if (version == CURL_HTTP_VERSION_2_0) {
+        http2Requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // curl reports cumulative timestamps (microseconds) from the start of the transfer
+    curl_off_t nameLookup = 0, connect = 0, appConnect = 0, startTransfer = 0, total = 0;
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total);
+
+    if (total == 0) {
+        return;
+    }
+
+    auto seconds = [](curl_off_t micros) { return static_cast<double>(std::max<curl_off_t>(micros, 0)) / 1e6; };
+    observe(Stage::UPSTREAM, seconds(total));
+    // Reused connections report zero for the setup phases; only record real work
+    if (connect > 0) {
+        observe(Stage::DNS, seconds(nameLookup));
+        observe(Stage::CONNECT, seconds(connect - nameLookup));
+    }
+    if (appConnect > 0) {
+        observe(Stage::TLS, seconds(appConnect - connect));
+    }
+    curl_off_t requestSent = std::max(connect, appConnect);
+    if (startTransfer > 0) {
+        observe(Stage::TIME_TO_FIRST_BYTE, seconds(startTransfer - requestSent));
+        observe(Stage::TRANSFER, seconds(total - startTransfer));
+    }
+}
+
+std::string Metrics::formatSummary() const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "  Stage        Count     Avg ms     p50 ms     p99 ms\n";
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        const Histogram& histogram = histograms_[i];
+        uint64_t count = histogram.getCount();
+        double average = count > 0 ? histogram.getSum() / static_cast<double>(count) : 0.0;
+        out << "  " << std::left << std::setw(10) << stageName(static_cast<Stage>(i)) << std::right
+            << std::setw(8) << count
+            << std::setw(11) << average * 1e3
+            << std::setw(11) << histogram.quantile(0.50) * 1e3
+            << std::setw(11) << histogram.quantile(0.99) * 1e3 << "\n";
+    }
+
+    out << "\n  Requests: " << requests_.load() << " (" << connections_.load(std::memory_order_relaxed)
+        << " new connections, " << http2Requests_.load(std::memory_order_relaxed) << " over HTTP/2)\n";
+    bool anyStatus = false;
+    for (size_t status = 0; status < httpStatus_.size(); ++status) {
+        uint64_t count = httpStatus_[status].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << (anyStatus ? ", " : "  HTTP status: ") << status << "=" << count;
+            anyStatus = true;
+        }
+    }
+    if (anyStatus) {
+        out << "\n";
+    }
+    for (size_t code = 0; code < curlErrors_.size(); ++code) {
+        uint64_t count = curlErrors_[code].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << "  CURL error: " << curl_easy_strerror(static_cast<CURLcode>(code)) << " = " << count << "\n";
+        }
+    }
+    bool anyEvent = false;
+    for (size_t i = 0; i < events_.size(); ++i) {
+        uint64_t count = events_[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << (anyEvent ? ", " : "  Resilience: ") << eventName(static_cast<UpstreamEvent>(i)) << "=" << count;
+            anyEvent = true;
+        }
+    }
+    if (anyEvent) {
+        out << "\n";
+    }
+    return out.str();
+}
+
+std::string Metrics::formatPrometheus() const {
+    std::ostringstream out;
+
+    out << "# HELP weatherbot_stage_seconds Latency of each request stage.\n";
+    out << "# TYPE weatherbot_stage_seconds histogram\n";
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        const Histogram& histogram = histograms_[i];
+        const char* stage = stageName(static_cast<Stage>(i));
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < Histogram::BUCKET_COUNT; ++bucket) {
+            cumulative += histogram.getBucket(bucket);
+            out << "weatherbot_stage_seconds_bucket{stage=\"" << stage << "\",le=\"";
+            if (bucket < Histogram::BOUNDS.size()) {
+                out << Histogram::BOUNDS[bucket];
+            } else {
+                out << "+Inf";
+            }
+            out << "\"} " << cumulative << "\n";
+        }
+        out << "weatherbot_stage_seconds_sum{stage=\"" << stage << "\"} " << histogram.getSum() << "\n";
+        out << "weatherbot_stage_seconds_count{stage=\"" << stage << "\"} " << histogram.getCount() << "\n";
+    }
+
+    out << "# HELP weatherbot_upstream_requests_total Upstream HTTP transfers attempted.\n";
+    out << "# TYPE weatherbot_upstream_requests_total counter\n";
+    out << "weatherbot_upstream_requests_total " << requests_.load() << "\n";
+
+    out << "# HELP weatherbot_upstream_connections_total Connections opened by upstream transfers.\n";
+    out << "# TYPE weatherbot_upstream_connections_total counter\n";
+    out << "weatherbot_upstream_connections_total " << connections_.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP weatherbot_upstream_http2_requests_total Upstream transfers made over HTTP/2.\n";
+    out << "# TYPE weatherbot_upstream_http2_requests_total counter\n";
+    out << "weatherbot_upstream_http2_requests_total " << http2Requests_.load(std::memory_order_relaxed) << "\n";
+
+    out << "# HELP weatherbot_http_responses_total Upstream responses by HTTP status.\n";
+    out << "# TYPE weatherbot_http_responses_total counter\n";
+    for (size_t status = 0; status < httpStatus_.size(); ++status) {
+        uint64_t count = httpStatus_[status].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << "weatherbot_http_responses_total{status=\"" << status << "\"} " << count << "\n";
+        }
+    }
+
+    out << "# HELP weatherbot_curl_errors_total Failed transfers by CURLcode.\n";
+    out << "# TYPE weatherbot_curl_errors_total counter\n";
+    for (size_t code = 0; code < curlErrors_.size(); ++code) {
+        uint64_t count = curlErrors_[code].load(std::memory_order_relaxed);
+        if (count > 0) {
+            out << "weatherbot_curl_errors_total{code=\"" << code << "\"} " << count << "\n";
+        }
+    }
+
+    out << "# HELP weatherbot_upstream_events_total Retries, hedges, fast failures, throttling, provider failovers and stale results.\n";
+    out << "# TYPE weatherbot_upstream_events_total counter\n";
+    for (size_t i = 0; i < events_.size(); ++i) {
+        out << "weatherbot_upstream_events_total{event=\"" << eventName(static_cast<UpstreamEvent>(i)) << "\"} "
+            << events_[i].load(std::memory_order_relaxed) << "\n";
+    }
+    return out.str();
+}
@@ -3,19 +3,68 @@
 #include <iomanip>
 #include <sstream>
 #include <ctime>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
-NotificationManager::NotificationManager() {
+namespace {
+const std::chrono::milliseconds WRITER_INTERVAL(50);
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+// Cuts at a character boundary so a truncated message is still valid UTF-8
+size_t truncatedLength(std::string_view message, size_t limit) {
+    if (message.size() <= limit) {
+        return message.size();
+    }
+    size_t length = limit;
+    while (length > 0 && (static_cast<unsigned char>(message[length]) & 0xC0) == 0x80) {
+        --length;
+    }
+    return length;
+}
+}
+
+NotificationManager::NotificationManager(std::ostream& out, NotificationOutput output, size_t capacity)
+    : out_(out), output_(output) {
+    size_t slots = roundUpToPowerOfTwo(capacity == 0 ? 1 : capacity);
+    mask_ = slots - 1;
+    slots_ = std::make_unique<Slot[]>(slots);
+
+    if (output_ == NotificationOutput::BACKGROUND) {
+        writer_ = std::thread(&NotificationManager::writerLoop, this);
+    }
 }
 
 NotificationManager::~NotificationManager() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(writerMutex_);
+            stopping_ = true;
+        }
+        writerWakeup_.notify_one();
+        writer_.join();
+    }
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    drainLocked();
+    out_.flush();
 }
 
 void NotificationManager::printColored(const std::string& text, const std::string& color) {
 #ifdef _WIN32
+    if (&out_ != &std::cout) {
+        out_ << text;
+        return;
+    }
+    
     HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     int colorCode = 7; // Default white
     
@@ -26,10 +75,11 @@ void NotificationManager::printColored(const std::string& text, const std::strin
     else if (color == "cyan") colorCode = 11;
     
     SetConsoleTextAttribute(hConsole, colorCode);
-    std::cout << text;
+    out_ << text;
     SetConsoleTextAttribute(hConsole, 7); // Reset to default
 #else
-    std::cout << text;
+    (void)color;
+    out_ << text;
 #endif
 }
 
@@ -63,56 +113,154 @@ std::string NotificationManager::getNotificationColor(NotificationType type) {
     }
 }
 
-void NotificationManager::showNotification(const std::string& message, NotificationType type) {
-    Notification notif;
-    notif.message = message;
-    notif.type = type;
-    notif.timestamp = std::chrono::system_clock::now();
-    
-    notifications_.push_back(notif);
-    
-    // Display immediately
-    std::string symbol = getNotificationSymbol(type);
-    std::string color = getNotificationColor(type);
-    
-    printColored(symbol + " ", color);
-    std::cout << message << std::endl;
+void NotificationManager::showNotification(std::string_view message, NotificationType type) {
+    uint64_t position = head_.fetch_add(1, std::memory_order_acq_rel);
+    Slot& slot = slots_[position & mask_];
+    uint64_t writing = 2 * position + 1;
+
+    // Claim the slot; a producer lapped by more than the capacity just drops its entry
+    uint64_t expected = slot.sequence.load(std::memory_order_relaxed);
+    bool claimed = false;
+    while (expected < writing) {
+        if (expected & 1) {
+            std::this_thread::yield();
+            expected = slot.sequence.load(std::memory_order_relaxed);
+        } else if (slot.sequence.compare_exchange_weak(expected, writing, std::memory_order_acquire)) {
+            claimed = true;
+            break;
+        }
+    }
+
+    if (claimed) {
+        std::atomic_thread_fence(std::memory_order_release);
+        Notification& notification = slot.notification;
+        notification.timestamp = std::chrono::system_clock::now();
+        notification.type = type;
+        notification.length = static_cast<uint16_t>(truncatedLength(message, Notification::MAX_MESSAGE_BYTES));
+        message.copy(notification.text, notification.length);
+        slot.sequence.store(writing + 1, std::memory_order_release);
+    }
+
+    if (output_ == NotificationOutput::BACKGROUND) {
+        writerWakeup_.notify_one();
+    } else {
+        std::lock_guard<std::mutex> lock(outputMutex_);
+        drainLocked();
+    }
 }
 
-void NotificationManager::showWeatherAlert(const std::string& city, const std::string& condition) {
+bool NotificationManager::readSlot(uint64_t position, Notification& notification) const {
+    const Slot& slot = slots_[position & mask_];
+    uint64_t complete = 2 * position + 2;
+    while (true) {
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before > complete) {
+            return false;  // Overwritten by a newer notification
+        }
+        if (before == complete) {
+            notification = slot.notification;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+            continue;
+        }
+        // Claimed but not yet written; the producer is mid-copy
+        std::this_thread::yield();
+    }
+}
+
+void NotificationManager::printNotification(const Notification& notification) {
+    printColored(getNotificationSymbol(notification.type) + " ", getNotificationColor(notification.type));
+    out_ << notification.message() << '\n';
+}
+
+void NotificationManager::drainLocked() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t capacity = mask_ + 1;
+    if (head - written_ > capacity) {
+        out_ << "[!] " << (head - written_ - capacity) << " notifications dropped\n";
+        written_ = head - capacity;
+    }
+
+    Notification notification;
+    for (; written_ < head; ++written_) {
+        if (readSlot(written_, notification)) {
+            printNotification(notification);
+        }
+    }
+}
+
+void NotificationManager::sync() {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    drainLocked();
+}
+
+void NotificationManager::writerLoop() {
+    std::unique_lock<std::mutex> wakeLock(writerMutex_);
+    while (!stopping_) {
+        writerWakeup_.wait_for(wakeLock, WRITER_INTERVAL);
+        wakeLock.unlock();
+        {
+            // One write and one flush for everything posted since the last pass
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            if (written_ != head_.load(std::memory_order_acquire)) {
+                drainLocked();
+                out_.flush();
+            }
+        }
+        wakeLock.lock();
+    }
+}
+
+void NotificationManager::forEachNotification(const std::function<void(const Notification&)>& visit) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t capacity = mask_ + 1;
+    uint64_t start = std::max(historyStart_.load(std::memory_order_acquire), head > capacity ? head - capacity : 0);
+
+    Notification notification;
+    for (uint64_t position = start; position < head; ++position) {
+        if (readSlot(position, notification)) {
+            visit(notification);
+        }
+    }
+}
+
+void NotificationManager::showWeatherAlert(std::string_view city, std::string_view condition) {
     std::ostringstream alert;
     alert << "Weather Alert for " << city << ": " << condition;
     showNotification(alert.str(), NotificationType::WARNING);
 }
 
 void NotificationManager::displayNotifications() {
-    if (notifications_.empty()) {
-        std::cout << "No notifications." << std::endl;
-        return;
-    }
-    
-    std::cout << "\n═══════════════════════════════════════\n";
-    std::cout << "         NOTIFICATION HISTORY          \n";
-    std::cout << "═══════════════════════════════════════\n";
-    
-    for (const auto& notif : notifications_) {
+    std::lock_guard<std::mutex> lock(outputMutex_);
+    drainLocked();
+
+    bool empty = true;
+    forEachNotification([this, &empty](const Notification& notif) {
+        if (empty) {
+            out_ << "\n═══════════════════════════════════════\n";
+            out_ << "         NOTIFICATION HISTORY          \n";
+            out_ << "═══════════════════════════════════════\n";
+            empty = false;
+        }
+        
         auto time = std::chrono::system_clock::to_time_t(notif.timestamp);
         std::tm* timeinfo = std::localtime(&time);
         
-        std::cout << "[" << std::put_time(timeinfo, "%H:%M:%S") << "] ";
-        
-        std::string symbol = getNotificationSymbol(notif.type);
-        std::string color = getNotificationColor(notif.type);
-        
-        printColored(symbol + " ", color);
-        std::cout << notif.message << std::endl;
-    }
+        out_ << "[" << std::put_time(timeinfo, "%H:%M:%S") << "] ";
+        printNotification(notif);
+    });
     
-    std::cout << "═══════════════════════════════════════\n" << std::endl;
+    if (empty) {
+        out_ << "No notifications.\n";
+        return;
+    }
+    out_ << "═══════════════════════════════════════\n\n";
 }
 
 void NotificationManager::clearNotifications() {
-    notifications_.clear();
+    // Entries are left in place and simply hidden from the history
+    historyStart_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
     showNotification("All notifications cleared.", NotificationType::INFO);
 }
-
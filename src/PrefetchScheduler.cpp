@@ -0,0 +1,255 @@
+#include "PrefetchScheduler.h"
+#include <algorithm>
+
+PrefetchScheduler::PrefetchScheduler(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context,
+                                     const PrefetchConfig& config)
+    : config_(config),
+      weatherService_(std::make_unique<WeatherService>(apiKey, context)),
+      running_(true),
+      started_(false),
+      wheel_(std::max<size_t>(config.wheelSlots, 1)),
+      cursor_(0),
+      nextGeneration_(1),
+      revalidationQueued_(false),
+      tokens_(1.0),
+      lastRefill_(Clock::now()),
+      random_(std::random_device{}()) {
+    // Refreshes yield the shared upstream quota to interactive lookups
+    weatherService_->setPriority(RequestPriority::BACKGROUND);
+}
+
+PrefetchScheduler::~PrefetchScheduler() {
+    stop();
+}
+
+void PrefetchScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wakeup_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool PrefetchScheduler::watch(const std::string& city) {
+    std::string key = WeatherCache::cityKey(city);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || watched_.count(key) > 0) {
+            return false;
+        }
+
+        WatchedLocation location;
+        location.city = city;
+        location.generation = nextGeneration_++;
+        watched_.emplace(key, location);
+        scheduleLocked(key, location.generation, Clock::duration::zero());
+
+        startLocked();
+    }
+    wakeup_.notify_all();
+    return true;
+}
+
+void PrefetchScheduler::startLocked() {
+    // The thread is only started once there is something to refresh
+    if (!started_) {
+        started_ = true;
+        thread_ = std::thread(&PrefetchScheduler::run, this);
+    }
+}
+
+void PrefetchScheduler::revalidate(const WeatherQuery& query) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || !pendingRevalidations_.insert(WeatherService::cacheKey(query)).second) {
+            return;
+        }
+        revalidations_.push_back(query);
+        revalidationQueued_ = true;
+        startLocked();
+    }
+    wakeup_.notify_all();
+}
+
+bool PrefetchScheduler::unwatch(const std::string& city) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Pending wheel entries are dropped lazily when their generation no longer matches
+    return watched_.erase(WeatherCache::cityKey(city)) > 0;
+}
+
+std::vector<std::string> PrefetchScheduler::getWatched() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> cities;
+    cities.reserve(watched_.size());
+    for (const auto& entry : watched_) {
+        cities.push_back(entry.second.city);
+    }
+    std::sort(cities.begin(), cities.end());
+    return cities;
+}
+
+bool PrefetchScheduler::lookup(const std::string& city, WeatherData& data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = watched_.find(WeatherCache::cityKey(city));
+    if (found == watched_.end() || !found->second.latest.isValid ||
+        Clock::now() - found->second.refreshedAt >= weatherService_->getCache().getConfig().ttl) {
+        return false;
+    }
+    data = found->second.latest;
+    return true;
+}
+
+PrefetchScheduler::Clock::duration PrefetchScheduler::jittered(Clock::duration interval) {
+    double spread = std::max(config_.jitterFraction, 0.0);
+    std::uniform_real_distribution<double> distribution(1.0 - spread, 1.0 + spread);
+    return std::chrono::duration_cast<Clock::duration>(interval * distribution(random_));
+}
+
+void PrefetchScheduler::scheduleLocked(const std::string& key, uint64_t generation, Clock::duration delay) {
+    size_t slots = wheel_.size();
+    auto tick = std::chrono::duration_cast<Clock::duration>(config_.tick);
+    size_t ticks = static_cast<size_t>(std::max<Clock::rep>(1, (delay + tick - Clock::duration(1)) / tick));
+    wheel_[(cursor_ + ticks) % slots].push_back(WheelEntry{key, generation, (ticks - 1) / slots});
+}
+
+bool PrefetchScheduler::takeTokenLocked() {
+    // Token bucket refilled continuously at requestsPerMinute, bursting up to 10% of a minute
+    double capacity = std::max(1.0, config_.requestsPerMinute / 10.0);
+    Clock::time_point now = Clock::now();
+    double elapsedMinutes = std::chrono::duration<double, std::ratio<60>>(now - lastRefill_).count();
+    tokens_ = std::min(capacity, tokens_ + elapsedMinutes * config_.requestsPerMinute);
+    lastRefill_ = now;
+
+    if (tokens_ < 1.0) {
+        return false;
+    }
+    tokens_ -= 1.0;
+    return true;
+}
+
+void PrefetchScheduler::run() {
+    Clock::time_point nextTick = Clock::now() + config_.tick;
+    std::vector<WheelEntry> due;
+    std::vector<WeatherQuery> stale;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wakeup_.wait_until(lock, nextTick, [this] { return !running_ || revalidationQueued_; });
+            if (!running_) {
+                return;
+            }
+
+            // Someone was just served a stale result, so these go ahead of the wheel;
+            // whatever the budget does not cover now waits for the next tick
+            revalidationQueued_ = false;
+            while (!revalidations_.empty() && takeTokenLocked()) {
+                stale.push_back(std::move(revalidations_.front()));
+                revalidations_.pop_front();
+            }
+        }
+
+        bool refreshed = false;
+        for (const WeatherQuery& query : stale) {
+            WeatherData data = weatherService_->refresh(query);
+            if (data.isValid) {
+                weatherService_->getContext()->alerts->update(data);
+                refreshed = true;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            pendingRevalidations_.erase(WeatherService::cacheKey(query));
+        }
+        stale.clear();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (Clock::now() < nextTick) {
+                if (refreshed) {
+                    lock.unlock();
+                    raiseAlerts();
+                }
+                continue;
+            }
+            nextTick += config_.tick;
+
+            cursor_ = (cursor_ + 1) % wheel_.size();
+            // Detach the slot first: rescheduling below may append to it again
+            std::vector<WheelEntry> slot;
+            slot.swap(wheel_[cursor_]);
+            for (WheelEntry& entry : slot) {
+                if (entry.rounds > 0) {
+                    --entry.rounds;
+                    wheel_[cursor_].push_back(std::move(entry));
+                    continue;
+                }
+                auto found = watched_.find(entry.key);
+                if (found == watched_.end() || found->second.generation != entry.generation) {
+                    continue;
+                }
+                if (takeTokenLocked()) {
+                    due.push_back(std::move(entry));
+                } else {
+                    // Out of budget: try again in a few seconds rather than bursting later
+                    scheduleLocked(entry.key, entry.generation, jittered(std::chrono::seconds(3)));
+                }
+            }
+        }
+
+        for (const WheelEntry& entry : due) {
+            refreshed = refresh(entry.key, entry.generation) || refreshed;
+        }
+        due.clear();
+
+        // One batched rule evaluation per cycle covers every location refreshed in it
+        if (refreshed) {
+            raiseAlerts();
+        }
+    }
+}
+
+void PrefetchScheduler::raiseAlerts() {
+    std::vector<AlertEvent> raised;
+    const std::shared_ptr<WeatherServiceContext>& context = weatherService_->getContext();
+    context->alerts->evaluate(raised);
+    context->dispatcher->publish(std::move(raised));
+}
+
+bool PrefetchScheduler::refresh(const std::string& key, uint64_t generation) {
+    std::string city;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = watched_.find(key);
+        if (found == watched_.end() || found->second.generation != generation) {
+            return false;
+        }
+        city = found->second.city;
+    }
+
+    WeatherData data = weatherService_->refresh(WeatherQuery::byCity(city));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = watched_.find(key);
+    if (found == watched_.end() || found->second.generation != generation) {
+        return false;
+    }
+    WatchedLocation& location = found->second;
+
+    if (!data.isValid) {
+        scheduleLocked(key, generation, jittered(config_.retryDelay));
+        return false;
+    }
+
+    // The alert engine keeps per-rule state, so a steady storm raises one
+    // alert rather than one per refresh
+    weatherService_->getContext()->alerts->update(data);
+    location.latest = data;
+    location.refreshedAt = Clock::now();
+
+    // Follows the cache TTL when it is reconfigured
+    auto interval = std::chrono::duration_cast<Clock::duration>(weatherService_->getCache().getConfig().ttl * config_.refreshFraction);
+    scheduleLocked(key, generation, jittered(interval));
+    return true;
+}
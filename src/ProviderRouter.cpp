@@ -0,0 +1,119 @@
+#include "ProviderRouter.h"
+#include <algorithm>
+
+ProviderRouter::ProviderRouter(const ProviderRoutingConfig& config) : config_(config), routed_(0) {
+    config_.latencyWeight = std::clamp(config_.latencyWeight, 0.01, 1.0);
+}
+
+void ProviderRouter::add(std::shared_ptr<WeatherProvider> provider, std::shared_ptr<CircuitBreaker> breaker) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot slot;
+    slot.provider = std::move(provider);
+    slot.breaker = breaker ? std::move(breaker) : std::make_shared<CircuitBreaker>();
+    slots_.push_back(std::move(slot));
+}
+
+long ProviderRouter::find(std::string_view name) const {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].provider->matches(name)) {
+            return static_cast<long>(i);
+        }
+    }
+    return -1;
+}
+
+std::vector<size_t> ProviderRouter::route(const WeatherQuery& query) {
+    std::vector<size_t> order;
+    if (!query.provider.empty()) {
+        long index = find(query.provider);
+        if (index >= 0 && slots_[index].provider->supports(query)) {
+            order.push_back(static_cast<size_t>(index));
+        }
+        return order;
+    }
+
+    // Breaker state is read outside the router's lock; the breakers have their own
+    std::vector<bool> open(slots_.size(), false);
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].provider->supports(query)) {
+            order.push_back(i);
+            open[i] = slots_[i].breaker->getState() == BreakerState::OPEN;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Unmeasured providers count as fastest, so each is tried early and gets a sample
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (open[a] != open[b]) {
+            return !open[a];
+        }
+        double latencyA = slots_[a].samples > 0 ? slots_[a].latencyMs : 0.0;
+        double latencyB = slots_[b].samples > 0 ? slots_[b].latencyMs : 0.0;
+        return latencyA < latencyB;
+    });
+    ++routed_;
+    if (config_.exploreEvery > 0 && routed_ % config_.exploreEvery == 0 && order.size() > 1 && !open[order[1]]) {
+        std::swap(order[0], order[1]);
+    }
+    return order;
+}
+
+void ProviderRouter::sampleLocked(Slot& slot, Clock::duration latency) {
+    double ms = std::chrono::duration<double, std::milli>(latency).count();
+    slot.latencyMs = slot.samples == 0 ? ms : slot.latencyMs + config_.latencyWeight * (ms - slot.latencyMs);
+    ++slot.samples;
+}
+
+void ProviderRouter::recordAnswer(size_t index, Clock::duration latency, bool valid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot& slot = slots_[index];
+    sampleLocked(slot, latency);
+    if (valid) {
+        ++slot.answered;
+    } else {
+        ++slot.failed;
+    }
+}
+
+void ProviderRouter::recordFailure(size_t index, Clock::duration elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot& slot = slots_[index];
+    // The time spent failing is what a caller routed here paid, so it counts as latency
+    sampleLocked(slot, elapsed);
+    ++slot.failed;
+}
+
+void ProviderRouter::recordAbandoned(size_t index, Clock::duration elapsed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Slot& slot = slots_[index];
+    // Only a lower bound, so it can raise the estimate but never lower it
+    if (slot.samples == 0 || std::chrono::duration<double, std::milli>(elapsed).count() > slot.latencyMs) {
+        sampleLocked(slot, elapsed);
+    }
+}
+
+void ProviderRouter::recordRaceWin(size_t index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++slots_[index].raceWins;
+}
+
+std::vector<ProviderStats> ProviderRouter::getStats() const {
+    std::vector<ProviderStats> stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Slot& slot : slots_) {
+            ProviderStats entry;
+            entry.name = slot.provider->name();
+            entry.latencyMs = slot.latencyMs;
+            entry.samples = slot.samples;
+            entry.answered = slot.answered;
+            entry.failed = slot.failed;
+            entry.raceWins = slot.raceWins;
+            stats.push_back(std::move(entry));
+        }
+    }
+    for (size_t i = 0; i < stats.size(); ++i) {
+        stats[i].breaker = slots_[i].breaker->getState();
+    }
+    return stats;
+}
@@ -0,0 +1,301 @@
+#include "RateLimiter.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Share of the configured rate won back by each successful request after a 429
+const double RECOVERY_STEP = 0.05;
+// Pause after a 429 that did not say how long to wait
+const std::chrono::seconds DEFAULT_RETRY_AFTER{1};
+
+int64_t currentDay() {
+    return std::chrono::floor<std::chrono::days>(std::chrono::system_clock::now()).time_since_epoch().count();
+}
+
+// Steady-clock time of the next midnight UTC, when the daily quota starts over
+RateLimiter::Clock::time_point nextMidnight(RateLimiter::Clock::time_point now) {
+    auto wall = std::chrono::system_clock::now();
+    auto midnight = std::chrono::floor<std::chrono::days>(wall) + std::chrono::days(1);
+    return now + std::chrono::duration_cast<RateLimiter::Clock::duration>(midnight - wall);
+}
+}
+
+RateLimiter::RateLimiter(const RateLimitConfig& config)
+    : enabled_(false),
+      tokens_(0.0),
+      rate_(0.0),
+      lastRefill_(Clock::now()),
+      pausedUntil_(Clock::time_point::min()),
+      day_(currentDay()),
+      usedToday_(0),
+      granted_(0),
+      expired_(0),
+      throttled_(0),
+      timerArmed_(false) {
+    applyLocked(config);
+    tokens_ = config_.burst;
+}
+
+void RateLimiter::applyLocked(const RateLimitConfig& config) {
+    config_ = config;
+    config_.burst = std::max(config_.burst, 1.0);
+    config_.interactiveReserve = std::clamp(config_.interactiveReserve, 0.0, config_.burst - 1.0);
+    config_.minRateFraction = std::clamp(config_.minRateFraction, 0.01, 1.0);
+    enabled_.store(config_.requestsPerMinute > 0.0, std::memory_order_relaxed);
+    rate_ = config_.requestsPerMinute / 60.0;
+}
+
+void RateLimiter::reconfigure(const RateLimitConfig& config, EventLoop& loop) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Tokens earned so far accrue at the old rate
+        refillLocked(Clock::now());
+        applyLocked(config);
+        tokens_ = std::min(tokens_, config_.burst);
+    }
+    // A higher rate may serve waiters sooner than the armed timer
+    loop.post([this, &loop] { dispatch(loop); });
+}
+
+RateLimitConfig RateLimiter::getConfig() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+}
+
+const char* RateLimiter::priorityName(RequestPriority priority) {
+    switch (priority) {
+        case RequestPriority::INTERACTIVE:
+            return "interactive";
+        case RequestPriority::BACKGROUND:
+            return "background";
+        case RequestPriority::BATCH:
+            return "batch";
+        default:
+            return "unknown";
+    }
+}
+
+void RateLimiter::refillLocked(Clock::time_point now) {
+    if (now > lastRefill_) {
+        // Nothing accrues while paused, so the bucket is not full the moment a pause ends
+        Clock::time_point from = std::max(lastRefill_, std::min(pausedUntil_, now));
+        tokens_ = std::min(config_.burst, tokens_ + rate_ * std::chrono::duration<double>(now - from).count());
+        lastRefill_ = now;
+    }
+    int64_t today = currentDay();
+    if (today != day_) {
+        day_ = today;
+        usedToday_ = 0;
+    }
+}
+
+double RateLimiter::reserveFor(RequestPriority priority) const {
+    return priority == RequestPriority::INTERACTIVE ? 0.0 : config_.interactiveReserve;
+}
+
+bool RateLimiter::queuedAheadLocked(RequestPriority priority) const {
+    for (size_t i = 0; i <= static_cast<size_t>(priority); ++i) {
+        if (!queues_[i].empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RateLimiter::availableLocked(RequestPriority priority, Clock::time_point now) const {
+    if (now < pausedUntil_) {
+        return false;
+    }
+    if (config_.requestsPerDay > 0 && usedToday_ >= config_.requestsPerDay) {
+        return false;
+    }
+    return !isEnabled() || tokens_ >= 1.0 + reserveFor(priority);
+}
+
+RateLimiter::Clock::time_point RateLimiter::nextAvailableLocked(RequestPriority priority, Clock::time_point now) const {
+    Clock::time_point resume = std::max(now, pausedUntil_);
+    Clock::time_point at = resume;
+    if (config_.requestsPerDay > 0 && usedToday_ >= config_.requestsPerDay) {
+        at = std::max(at, nextMidnight(now));
+    }
+    double missing = 1.0 + reserveFor(priority) - tokens_;
+    if (isEnabled() && missing > 0.0) {
+        auto refill = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(missing / rate_));
+        at = std::max(at, resume + refill);
+    }
+    return at;
+}
+
+void RateLimiter::takeLocked() {
+    if (isEnabled()) {
+        tokens_ -= 1.0;
+    }
+    ++usedToday_;
+    ++granted_;
+}
+
+bool RateLimiter::tryAcquire(RequestPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    refillLocked(now);
+    if (queuedAheadLocked(priority) || !availableLocked(priority, now)) {
+        return false;
+    }
+    takeLocked();
+    return true;
+}
+
+void RateLimiter::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (isEnabled()) {
+        tokens_ = std::min(config_.burst, tokens_ + 1.0);
+    }
+    usedToday_ = usedToday_ > 0 ? usedToday_ - 1 : 0;
+    granted_ = granted_ > 0 ? granted_ - 1 : 0;
+}
+
+RateLimiter::Clock::duration RateLimiter::nextAvailableIn(RequestPriority priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    refillLocked(now);
+    return nextAvailableLocked(priority, now) - now;
+}
+
+RateLimiter::Clock::time_point RateLimiter::queueDeadline(RequestPriority priority, Clock::time_point now) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queueDeadlineLocked(priority, now);
+}
+
+RateLimiter::Clock::time_point RateLimiter::queueDeadlineLocked(RequestPriority priority, Clock::time_point now) const {
+    std::chrono::milliseconds limit = config_.maxQueueDelay[static_cast<size_t>(priority)];
+    return limit.count() > 0 ? now + limit : Clock::time_point::max();
+}
+
+Task<bool> RateLimiter::acquire(EventLoop& loop, RequestPriority priority, Clock::time_point until,
+                                EventLoop::CancelToken* cancel) {
+    if (cancel && cancel->isCancelled()) {
+        co_return false;
+    }
+    if (tryAcquire(priority)) {
+        co_return true;
+    }
+
+    EventLoop::Wakeup wakeup(loop);
+    Waiter waiter{&wakeup};
+    std::deque<Waiter*>& queue = queues_[static_cast<size_t>(priority)];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        until = std::min(until, queueDeadlineLocked(priority, now));
+        queue.push_back(&waiter);
+        armLocked(loop, now);
+    }
+
+    // Resumed by dispatch() with a token, or by the deadline or a cancel without one
+    EventLoop::Wakeup* watched = cancel ? cancel->watch(&wakeup) : nullptr;
+    co_await wakeup.waitUntil(until);
+    if (cancel) {
+        cancel->watch(watched);
+    }
+    if (!waiter.granted) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue.erase(std::find(queue.begin(), queue.end(), &waiter));
+        ++expired_;
+    }
+    co_return waiter.granted;
+}
+
+void RateLimiter::dispatch(EventLoop& loop) {
+    std::vector<Waiter*> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        refillLocked(now);
+        for (size_t i = 0; i < PRIORITY_COUNT; ++i) {
+            std::deque<Waiter*>& queue = queues_[i];
+            while (!queue.empty() && availableLocked(static_cast<RequestPriority>(i), now)) {
+                takeLocked();
+                queue.front()->granted = true;
+                ready.push_back(queue.front());
+                queue.pop_front();
+            }
+            // Lower priorities only get tokens once everything above them is served
+            if (!queue.empty()) {
+                break;
+            }
+        }
+        armLocked(loop, now);
+    }
+
+    // Resumed outside the lock: a granted request may come straight back for another token
+    for (Waiter* waiter : ready) {
+        waiter->wakeup->notify();
+    }
+}
+
+void RateLimiter::armLocked(EventLoop& loop, Clock::time_point now) {
+    Clock::time_point at = Clock::time_point::max();
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i) {
+        if (!queues_[i].empty()) {
+            at = nextAvailableLocked(static_cast<RequestPriority>(i), now);
+            break;
+        }
+    }
+    if (at == Clock::time_point::max() || (timerArmed_ && timerAt_ <= at)) {
+        return;
+    }
+    if (timerArmed_) {
+        loop.cancelTimer(timer_);
+    }
+    timerArmed_ = true;
+    timerAt_ = at;
+    timer_ = loop.addTimer(at, [this, &loop] {
+        timerArmed_ = false;
+        dispatch(loop);
+    });
+}
+
+void RateLimiter::onThrottled(std::chrono::seconds retryAfter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    refillLocked(now);
+    ++throttled_;
+    // Requests that were already in flight get their 429s together; they count as one signal
+    bool backingOff = now < pausedUntil_;
+    pausedUntil_ = std::max(pausedUntil_, now + (retryAfter.count() > 0 ? retryAfter : DEFAULT_RETRY_AFTER));
+    // Whatever burst was left would only earn more 429s
+    tokens_ = std::min(tokens_, 0.0);
+    if (isEnabled() && !backingOff) {
+        double configured = config_.requestsPerMinute / 60.0;
+        rate_ = std::max(configured * config_.minRateFraction, rate_ * 0.5);
+    }
+}
+
+void RateLimiter::onSuccess() {
+    if (!isEnabled()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    double configured = config_.requestsPerMinute / 60.0;
+    rate_ = std::min(configured, rate_ + configured * RECOVERY_STEP);
+}
+
+RateLimiterStats RateLimiter::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    refillLocked(now);
+
+    RateLimiterStats stats;
+    stats.enabled = isEnabled();
+    stats.tokens = tokens_;
+    stats.requestsPerMinute = rate_ * 60.0;
+    stats.paused = now < pausedUntil_;
+    stats.usedToday = usedToday_;
+    stats.granted = granted_;
+    stats.expired = expired_;
+    stats.throttled = throttled_;
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i) {
+        stats.queued[i] = queues_[i].size();
+    }
+    return stats;
+}
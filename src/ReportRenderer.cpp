@@ -0,0 +1,303 @@
+#include "ReportRenderer.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+namespace {
+// Columns between the box's side borders
+const size_t BOX_INNER_WIDTH = 40;
+const char* const BOX_TITLE = "WEATHER FORECAST REPORT";
+const char* const ERROR_TEXT = "Error: Unable to retrieve weather data. Please check the city name or your API key.";
+
+// Inclusive code point ranges, sorted
+using CodePointRange = std::pair<char32_t, char32_t>;
+
+const CodePointRange ZERO_WIDTH[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2},
+    {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x064B, 0x065F}, {0x0670, 0x0670},
+    {0x06D6, 0x06DC}, {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0E31, 0x0E31},
+    {0x0E34, 0x0E3A}, {0x0E47, 0x0E4E}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F},
+    {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0xE0100, 0xE01EF},
+};
+
+// East Asian Wide and Fullwidth, and emoji shown in emoji presentation by default
+const CodePointRange DOUBLE_WIDTH[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+    {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+    {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+    {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+    {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xA960, 0xA97F}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E},
+    {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB},
+    {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+template <size_t N>
+bool inRanges(const CodePointRange (&ranges)[N], char32_t c) {
+    const CodePointRange* it = std::upper_bound(ranges, ranges + N, c, [](char32_t value, const CodePointRange& range) {
+        return value < range.first;
+    });
+    return it != ranges && c <= (it - 1)->second;
+}
+
+// Columns of the code point starting at text[i], which is advanced past it. A
+// byte that does not start a well-formed sequence is taken alone as one column.
+size_t nextWidth(std::string_view text, size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    if (lead < 0x80) {
+        ++i;
+        return lead >= 0x20 && lead != 0x7F ? 1 : 0;
+    }
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC2 ? 2 : 0;
+    char32_t c = lead & (length == 4 ? 0x07 : length == 3 ? 0x0F : 0x1F);
+    bool valid = length > 0 && lead < 0xF5 && i + length <= text.size();
+    for (size_t k = 1; valid && k < length; ++k) {
+        unsigned char byte = static_cast<unsigned char>(text[i + k]);
+        valid = (byte & 0xC0) == 0x80;
+        c = (c << 6) | (byte & 0x3F);
+    }
+    // Overlong forms and surrogates are malformed too
+    valid = valid && !(length == 3 && (c < 0x800 || (c >= 0xD800 && c <= 0xDFFF))) &&
+            !(length == 4 && (c < 0x10000 || c > 0x10FFFF));
+    if (!valid) {
+        ++i;
+        return 1;
+    }
+    i += length;
+    if (c < 0xA0 || inRanges(ZERO_WIDTH, c)) {
+        return 0;
+    }
+    return inRanges(DOUBLE_WIDTH, c) ? 2 : 1;
+}
+
+// Whole units, as the report has always shown them; anything that does not fit
+// an integer is printed as the float it is
+void appendWhole(std::string& out, float value) {
+    if (std::fabs(value) < 1e15f) {
+        ReportRenderer::appendNumber(out, static_cast<int64_t>(value));
+    } else {
+        ReportRenderer::appendNumber(out, value);
+    }
+}
+
+struct BoxFrame {
+    std::string top;     // Top border, title and separator
+    std::string bottom;
+};
+
+const BoxFrame& boxFrame() {
+    static const BoxFrame frame = [] {
+        BoxFrame built;
+        std::string border;
+        for (size_t i = 0; i < BOX_INNER_WIDTH; ++i) {
+            border += "═";
+        }
+        size_t title = ReportRenderer::displayWidth(BOX_TITLE);
+        size_t left = (BOX_INNER_WIDTH - title) / 2;
+        built.top = "\n╔" + border + "╗\n║" + std::string(left, ' ') + BOX_TITLE +
+                    std::string(BOX_INNER_WIDTH - title - left, ' ') + "║\n╠" + border + "╣\n";
+        built.bottom = "╚" + border + "╝\n";
+        return built;
+    }();
+    return frame;
+}
+
+// Starts a box row; the value is then appended directly to out
+size_t openRow(std::string& out, std::string_view label) {
+    out += "║ ";
+    out += label;
+    return out.size();
+}
+
+// Pads the value appended since start to the row's width, or cuts it short
+// with an ellipsis, and closes the row. One space is always kept before the border.
+void closeRow(std::string& out, std::string_view label, size_t start) {
+    size_t columns = BOX_INNER_WIDTH - 2 - label.size();
+    size_t width = ReportRenderer::displayWidth(std::string_view(out).substr(start));
+    if (width > columns) {
+        std::string_view value = std::string_view(out).substr(start);
+        out.resize(start + ReportRenderer::fitWidth(value, columns - 1));
+        out += "…";
+        width = ReportRenderer::displayWidth(std::string_view(out).substr(start));
+    }
+    out.append(columns - width + 1, ' ');
+    out += "║\n";
+}
+
+void renderBox(const WeatherData& data, std::string& out) {
+    const BoxFrame& frame = boxFrame();
+    out += frame.top;
+
+    size_t start = openRow(out, "Location: ");
+    out += data.city();
+    out += ", ";
+    out += data.country();
+    closeRow(out, "Location: ", start);
+
+    start = openRow(out, "Condition: ");
+    out += data.description();
+    closeRow(out, "Condition: ", start);
+
+    start = openRow(out, "Temperature: ");
+    appendWhole(out, data.temperature);
+    out += "°C";
+    closeRow(out, "Temperature: ", start);
+
+    start = openRow(out, "Feels Like: ");
+    appendWhole(out, data.feelsLike);
+    out += "°C";
+    closeRow(out, "Feels Like: ", start);
+
+    start = openRow(out, "Humidity: ");
+    appendWhole(out, data.humidity);
+    out += '%';
+    closeRow(out, "Humidity: ", start);
+
+    start = openRow(out, "Wind Speed: ");
+    appendWhole(out, data.windSpeed);
+    out += " m/s";
+    closeRow(out, "Wind Speed: ", start);
+
+    out += frame.bottom;
+}
+
+void renderCompact(const WeatherData& data, std::string& out) {
+    out += data.city();
+    out += ", ";
+    out += data.country();
+    out += ": ";
+    out += data.description();
+    out += ", ";
+    appendWhole(out, data.temperature);
+    out += "°C (feels like ";
+    appendWhole(out, data.feelsLike);
+    out += "°C), humidity ";
+    appendWhole(out, data.humidity);
+    out += "%, wind ";
+    appendWhole(out, data.windSpeed);
+    out += data.isStale ? " m/s (stale)\n" : " m/s\n";
+}
+
+void renderJson(const WeatherData& data, std::string& out) {
+    out += "{\"ok\":true,\"city\":";
+    ReportRenderer::appendJsonString(out, data.city());
+    out += ",\"country\":";
+    ReportRenderer::appendJsonString(out, data.country());
+    out += ",\"id\":";
+    ReportRenderer::appendNumber(out, data.cityId);
+    out += ",\"temperature\":";
+    ReportRenderer::appendNumber(out, data.temperature);
+    out += ",\"feels_like\":";
+    ReportRenderer::appendNumber(out, data.feelsLike);
+    out += ",\"humidity\":";
+    ReportRenderer::appendNumber(out, data.humidity);
+    out += ",\"wind_speed\":";
+    ReportRenderer::appendNumber(out, data.windSpeed);
+    out += ",\"description\":";
+    ReportRenderer::appendJsonString(out, data.description());
+    out += data.isStale ? ",\"stale\":true}\n" : ",\"stale\":false}\n";
+}
+}
+
+template <ReportStyle Style>
+void ReportRenderer::render(const WeatherData& data, std::string& out) {
+    if constexpr (Style == ReportStyle::BOX) {
+        if (!data.isValid) {
+            out += ERROR_TEXT;
+            return;
+        }
+        renderBox(data, out);
+    } else if constexpr (Style == ReportStyle::COMPACT) {
+        if (!data.isValid) {
+            out += ERROR_TEXT;
+            out += '\n';
+            return;
+        }
+        renderCompact(data, out);
+    } else {
+        if (!data.isValid) {
+            out += "{\"ok\":false,\"error\":\"lookup failed\"}\n";
+            return;
+        }
+        renderJson(data, out);
+    }
+}
+
+template void ReportRenderer::render<ReportStyle::BOX>(const WeatherData&, std::string&);
+template void ReportRenderer::render<ReportStyle::COMPACT>(const WeatherData&, std::string&);
+template void ReportRenderer::render<ReportStyle::JSON>(const WeatherData&, std::string&);
+
+void ReportRenderer::render(ReportStyle style, const WeatherData& data, std::string& out) {
+    switch (style) {
+        case ReportStyle::BOX:
+            render<ReportStyle::BOX>(data, out);
+            break;
+        case ReportStyle::COMPACT:
+            render<ReportStyle::COMPACT>(data, out);
+            break;
+        case ReportStyle::JSON:
+            render<ReportStyle::JSON>(data, out);
+            break;
+    }
+}
+
+size_t ReportRenderer::displayWidth(std::string_view text) {
+    size_t width = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        width += nextWidth(text, i);
+    }
+    return width;
+}
+
+size_t ReportRenderer::fitWidth(std::string_view text, size_t columns) {
+    size_t width = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t next = i;
+        size_t columnsNext = nextWidth(text, next);
+        if (width + columnsNext > columns) {
+            break;
+        }
+        width += columnsNext;
+        i = next;
+    }
+    return i;
+}
+
+void ReportRenderer::appendNumber(std::string& out, float value) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void ReportRenderer::appendNumber(std::string& out, int64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+void ReportRenderer::appendJsonString(std::string& out, std::string_view text) {
+    static const char* const HEX = "0123456789abcdef";
+    out += '"';
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (byte < 0x20) {
+            out += "\\u00";
+            out += HEX[byte >> 4];
+            out += HEX[byte & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
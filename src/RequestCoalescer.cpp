@@ -0,0 +1,52 @@
+#include "RequestCoalescer.h"
+#include <exception>
+
+RequestCoalescer::RequestCoalescer() {
+}
+
+RequestCoalescer::~RequestCoalescer() {
+}
+
+Task<WeatherData> RequestCoalescer::run(std::string key, std::function<Task<WeatherData>()> fetch) {
+    struct JoinFlight {
+        Flight& flight;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { flight.waiters.push_back(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    auto found = inFlight_.find(key);
+    if (found != inFlight_.end()) {
+        std::shared_ptr<Flight> flight = found->second;
+        ++coalesced_;
+        co_await JoinFlight{*flight};
+        co_return flight->result;
+    }
+
+    auto flight = std::make_shared<Flight>();
+    inFlight_.emplace(key, flight);
+    ++leaders_;
+
+    std::exception_ptr error;
+    try {
+        Task<WeatherData> fetching = fetch();
+        flight->result = co_await fetching;
+    } catch (...) {
+        // Followers see an invalid result; the leader rethrows below
+        error = std::current_exception();
+    }
+
+    // Unregister before publishing so later callers start a fresh lookup
+    // (normally answered by the cache the leader just filled)
+    inFlight_.erase(key);
+    std::vector<std::coroutine_handle<>> waiters;
+    waiters.swap(flight->waiters);
+    for (std::coroutine_handle<> waiter : waiters) {
+        waiter.resume();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    co_return flight->result;
+}
@@ -0,0 +1,297 @@
+#include "SnapshotStore.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+namespace {
+
+const char RECORDS_MAGIC[8] = {'W', 'B', 'S', 'N', 'A', 'P', '0', '1'};
+const char STRINGS_MAGIC[8] = {'W', 'B', 'S', 'T', 'R', 'S', '0', '1'};
+const size_t RECORDS_HEADER_SIZE = 16;
+const size_t STRINGS_HEADER_SIZE = sizeof(STRINGS_MAGIC);
+// Superseded records tolerated before the files are rewritten
+const size_t COMPACTION_SLACK = 1024;
+
+bool readTableString(const MappedFile& strings, uint32_t offset, std::string_view& out) {
+    if (static_cast<size_t>(offset) + sizeof(uint32_t) > strings.size()) {
+        return false;
+    }
+    uint32_t length;
+    std::memcpy(&length, strings.data() + offset, sizeof(length));
+    size_t start = static_cast<size_t>(offset) + sizeof(length);
+    if (start + length > strings.size()) {
+        return false;
+    }
+    out = std::string_view(strings.data() + start, length);
+    return true;
+}
+
+bool readTableString(const MappedFile& strings, uint32_t offset, std::string& out) {
+    std::string_view view;
+    if (!readTableString(strings, offset, view)) {
+        return false;
+    }
+    out.assign(view);
+    return true;
+}
+
+bool readTableSymbol(const MappedFile& strings, uint32_t offset, Symbol& out) {
+    std::string_view view;
+    if (!readTableString(strings, offset, view)) {
+        return false;
+    }
+    out = SymbolTable::global().intern(view);
+    return true;
+}
+
+} // namespace
+
+SnapshotStore::SnapshotStore(const std::string& path, std::chrono::seconds ttl)
+    : path_(path), stringsPath_(path + ".strings"), ttl_(ttl),
+      records_(nullptr), strings_(nullptr), stringsSize_(0), recordCount_(0) {
+}
+
+SnapshotStore::~SnapshotStore() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeFiles();
+}
+
+int64_t SnapshotStore::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+}
+
+bool SnapshotStore::isExpired(int64_t fetchedAtMs, int64_t now) const {
+    return now - fetchedAtMs >= std::chrono::duration_cast<std::chrono::milliseconds>(ttl_).count();
+}
+
+uint64_t SnapshotStore::checksum(const SnapshotRecord& record) {
+    // FNV-1a over everything but the checksum itself; catches torn tail writes
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < offsetof(SnapshotRecord, checksum); ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t SnapshotStore::loadInto(WeatherCache& cache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeFiles();
+    live_.clear();
+    stringOffsets_.clear();
+    recordCount_ = 0;
+
+    bool rewrite = true;
+    {
+        MappedFile records(path_);
+        MappedFile strings(stringsPath_);
+
+        bool valid = records.size() >= RECORDS_HEADER_SIZE && strings.size() >= STRINGS_HEADER_SIZE &&
+                     std::memcmp(records.data(), RECORDS_MAGIC, sizeof(RECORDS_MAGIC)) == 0 &&
+                     std::memcmp(strings.data(), STRINGS_MAGIC, sizeof(STRINGS_MAGIC)) == 0;
+        if (valid) {
+            uint32_t recordSize;
+            std::memcpy(&recordSize, records.data() + sizeof(RECORDS_MAGIC), sizeof(recordSize));
+            valid = recordSize == sizeof(SnapshotRecord);
+        }
+
+        if (valid) {
+            size_t body = records.size() - RECORDS_HEADER_SIZE;
+            size_t count = body / sizeof(SnapshotRecord);
+            // A partial trailing record means the last write was torn; rewrite the files
+            rewrite = body % sizeof(SnapshotRecord) != 0;
+
+            std::string key;
+            for (size_t i = 0; i < count; ++i) {
+                SnapshotRecord record;
+                std::memcpy(&record, records.data() + RECORDS_HEADER_SIZE + i * sizeof(SnapshotRecord), sizeof(record));
+                LiveEntry entry;
+                entry.fetchedAtMs = record.fetchedAtMs;
+                entry.data.temperature = record.temperature;
+                entry.data.feelsLike = record.feelsLike;
+                entry.data.humidity = record.humidity;
+                entry.data.windSpeed = record.windSpeed;
+                entry.data.isValid = true;
+
+                if (record.checksum != checksum(record) ||
+                    !readTableString(strings, record.keyOffset, key) ||
+                    !readTableSymbol(strings, record.cityOffset, entry.data.citySymbol) ||
+                    !readTableSymbol(strings, record.countryOffset, entry.data.countrySymbol) ||
+                    !readTableSymbol(strings, record.descriptionOffset, entry.data.descriptionSymbol) ||
+                    !readTableSymbol(strings, record.iconOffset, entry.data.iconSymbol)) {
+                    rewrite = true;
+                    continue;
+                }
+
+                ++recordCount_;
+                auto found = live_.find(key);
+                if (found == live_.end() || found->second.fetchedAtMs <= entry.fetchedAtMs) {
+                    live_[key] = std::move(entry);
+                }
+            }
+
+            // Rebuild the string table index so appends keep deduplicating
+            size_t offset = STRINGS_HEADER_SIZE;
+            std::string value;
+            while (readTableString(strings, static_cast<uint32_t>(offset), value)) {
+                stringOffsets_.emplace(value, static_cast<uint32_t>(offset));
+                offset += sizeof(uint32_t) + value.size();
+            }
+            stringsSize_ = static_cast<uint32_t>(offset);
+            rewrite = rewrite || offset != strings.size();
+        }
+    }
+
+    // Expired entries are simply skipped; they disappear at the next compaction
+    int64_t now = nowMs();
+    size_t loaded = 0;
+    for (const auto& entry : live_) {
+        if (!isExpired(entry.second.fetchedAtMs, now)) {
+            Clock::time_point fetchedAt{std::chrono::milliseconds(entry.second.fetchedAtMs)};
+            cache.put(entry.first, entry.second.data, fetchedAt);
+            ++loaded;
+        }
+    }
+
+    if (rewrite || recordCount_ > 2 * live_.size() + COMPACTION_SLACK) {
+        compactLocked();
+    } else if (!openForAppend()) {
+        closeFiles();
+    }
+
+    return loaded;
+}
+
+bool SnapshotStore::openForAppend() {
+    records_ = std::fopen(path_.c_str(), "ab");
+    strings_ = std::fopen(stringsPath_.c_str(), "ab");
+    if (!records_ || !strings_) {
+        std::cerr << "Error: Failed to open snapshot file " << path_ << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void SnapshotStore::closeFiles() {
+    if (records_) {
+        std::fclose(records_);
+        records_ = nullptr;
+    }
+    if (strings_) {
+        std::fclose(strings_);
+        strings_ = nullptr;
+    }
+}
+
+uint32_t SnapshotStore::internString(std::string_view text) {
+    std::string value(text);
+    auto found = stringOffsets_.find(value);
+    if (found != stringOffsets_.end()) {
+        return found->second;
+    }
+
+    uint32_t offset = stringsSize_;
+    uint32_t length = static_cast<uint32_t>(value.size());
+    std::fwrite(&length, sizeof(length), 1, strings_);
+    std::fwrite(value.data(), 1, value.size(), strings_);
+    stringsSize_ += static_cast<uint32_t>(sizeof(length) + value.size());
+    stringOffsets_.emplace(value, offset);
+    return offset;
+}
+
+void SnapshotStore::writeRecordLocked(const std::string& key, const LiveEntry& entry) {
+    SnapshotRecord record{};
+    record.keyOffset = internString(key);
+    record.cityOffset = internString(entry.data.city());
+    record.countryOffset = internString(entry.data.country());
+    record.descriptionOffset = internString(entry.data.description());
+    record.iconOffset = internString(entry.data.icon());
+    record.fetchedAtMs = entry.fetchedAtMs;
+    record.temperature = entry.data.temperature;
+    record.feelsLike = entry.data.feelsLike;
+    record.humidity = entry.data.humidity;
+    record.windSpeed = entry.data.windSpeed;
+    record.checksum = checksum(record);
+
+    // Strings go out first so a record never points past the string table
+    std::fflush(strings_);
+    std::fwrite(&record, sizeof(record), 1, records_);
+    std::fflush(records_);
+    ++recordCount_;
+}
+
+void SnapshotStore::append(const std::string& key, const WeatherData& data) {
+    if (!data.isValid) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!records_ || !strings_) {
+        return;
+    }
+
+    LiveEntry& entry = live_[key];
+    entry.data = data;
+    entry.fetchedAtMs = nowMs();
+    writeRecordLocked(key, entry);
+
+    if (recordCount_ > 2 * live_.size() + COMPACTION_SLACK) {
+        compactLocked();
+    }
+}
+
+void SnapshotStore::compact() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compactLocked();
+}
+
+void SnapshotStore::compactLocked() {
+    closeFiles();
+
+    std::string recordsTemp = path_ + ".tmp";
+    std::string stringsTemp = stringsPath_ + ".tmp";
+    records_ = std::fopen(recordsTemp.c_str(), "wb");
+    strings_ = std::fopen(stringsTemp.c_str(), "wb");
+    if (!records_ || !strings_) {
+        std::cerr << "Error: Failed to compact snapshot file " << path_ << std::endl;
+        closeFiles();
+        return;
+    }
+
+    uint32_t recordSize = sizeof(SnapshotRecord);
+    uint32_t reserved = 0;
+    std::fwrite(RECORDS_MAGIC, 1, sizeof(RECORDS_MAGIC), records_);
+    std::fwrite(&recordSize, sizeof(recordSize), 1, records_);
+    std::fwrite(&reserved, sizeof(reserved), 1, records_);
+    std::fwrite(STRINGS_MAGIC, 1, sizeof(STRINGS_MAGIC), strings_);
+
+    stringOffsets_.clear();
+    stringsSize_ = static_cast<uint32_t>(STRINGS_HEADER_SIZE);
+    recordCount_ = 0;
+
+    int64_t now = nowMs();
+    for (auto it = live_.begin(); it != live_.end();) {
+        if (isExpired(it->second.fetchedAtMs, now)) {
+            it = live_.erase(it);
+            continue;
+        }
+        writeRecordLocked(it->first, it->second);
+        ++it;
+    }
+    closeFiles();
+
+    std::remove(path_.c_str());
+    std::remove(stringsPath_.c_str());
+    if (std::rename(stringsTemp.c_str(), stringsPath_.c_str()) != 0 ||
+        std::rename(recordsTemp.c_str(), path_.c_str()) != 0) {
+        std::cerr << "Error: Failed to replace snapshot file " << path_ << std::endl;
+        return;
+    }
+
+    if (!openForAppend()) {
+        closeFiles();
+    }
+}
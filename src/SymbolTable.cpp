@@ -0,0 +1,69 @@
+#include "SymbolTable.h"
+#include <iostream>
+#include <cstring>
+#include <mutex>
+
+SymbolTable::SymbolTable() : count_(1) {
+    for (auto& chunk : chunks_) {
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    // Slot 0 holds the empty string
+    chunks_[0].store(new std::string_view[CHUNK_SIZE](), std::memory_order_release);
+}
+
+SymbolTable::~SymbolTable() {
+    for (auto& chunk : chunks_) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+SymbolTable& SymbolTable::global() {
+    // Never destroyed, so results still held by other threads during shutdown stay readable
+    static SymbolTable* table = new SymbolTable();
+    return *table;
+}
+
+Symbol SymbolTable::intern(std::string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto found = index_.find(text);
+        if (found != index_.end()) {
+            return found->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto found = index_.find(text);
+    if (found != index_.end()) {
+        return found->second;
+    }
+
+    size_t id = count_.load(std::memory_order_relaxed);
+    if (id >= MAX_CHUNKS * CHUNK_SIZE) {
+        static std::once_flag warned;
+        std::call_once(warned, [] { std::cerr << "Warning: Symbol table is full; new strings are dropped" << std::endl; });
+        return 0;
+    }
+    std::atomic<std::string_view*>& chunk = chunks_[id >> CHUNK_BITS];
+    if (!chunk.load(std::memory_order_relaxed)) {
+        chunk.store(new std::string_view[CHUNK_SIZE](), std::memory_order_release);
+    }
+
+    char* copy = static_cast<char*>(text_.allocate(text.size(), 1));
+    std::memcpy(copy, text.data(), text.size());
+    std::string_view stored(copy, text.size());
+    chunk.load(std::memory_order_relaxed)[id & (CHUNK_SIZE - 1)] = stored;
+    index_.emplace(stored, static_cast<Symbol>(id));
+    count_.store(id + 1, std::memory_order_release);
+    return static_cast<Symbol>(id);
+}
+
+std::string_view SymbolTable::lookup(Symbol symbol) const {
+    if (symbol >= count_.load(std::memory_order_acquire)) {
+        return {};
+    }
+    return chunks_[symbol >> CHUNK_BITS].load(std::memory_order_acquire)[symbol & (CHUNK_SIZE - 1)];
+}
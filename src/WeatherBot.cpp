@@ -1,115 +1,696 @@
 #include "WeatherBot.h"
 #include <iostream>
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <ctime>
 
-WeatherBot::WeatherBot(const std::string& apiKey) 
-    : weatherService_(std::make_unique<WeatherService>(apiKey)),
-      notificationManager_(std::make_unique<NotificationManager>()),
-      running_(true) {
+namespace {
+const size_t FIND_RESULT_LIMIT = 10;
+// Server workers build a WeatherBot per command, so the buffer reports are
+// rendered into belongs to the thread and keeps its capacity between commands
+thread_local std::string reportBuffer;
+
+// std::isdigit is undefined for negative char values, so widen through unsigned char
+bool isDigit(char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
 }
 
-WeatherBot::~WeatherBot() {
+bool isCityId(std::string_view entry) {
+    return entry.size() < 12 && std::all_of(entry.begin(), entry.end(), isDigit);
 }
 
-std::string WeatherBot::trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (first == std::string::npos) return "";
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, (last - first + 1));
+bool parseNumber(std::string_view text, double& value) {
+    if (!text.empty() && text.front() == '+') {
+        text.remove_prefix(1);
+    }
+    return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+}
+
+std::string_view firstWord(std::string_view text) {
+    std::string_view word;
+    CommandTokenizer(text).next(word);
+    return word;
+}
 }
 
-std::vector<std::string> WeatherBot::splitCommand(const std::string& command) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(command);
-    std::string token;
+WeatherBot::WeatherBot(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context) 
+    : ownedWeatherService_(std::make_unique<WeatherService>(apiKey, std::move(context))),
+      ownedNotificationManager_(std::make_unique<NotificationManager>(std::cout, NotificationOutput::BACKGROUND)),
+      weatherService_(ownedWeatherService_.get()),
+      notificationManager_(ownedNotificationManager_.get()),
+      out_(std::cout),
+      userId_("local"),
+      running_(true) {
+    ownedScheduler_ = std::make_unique<PrefetchScheduler>(apiKey, weatherService_->getContext());
+    scheduler_ = ownedScheduler_.get();
     
-    while (iss >> token) {
-        tokens.push_back(token);
+    // The console hears every alert background refreshes raise, plus the user's own
+    AlertDispatcher& dispatcher = *weatherService_->getContext()->dispatcher;
+    ownedAlertSink_ = std::make_shared<ConsoleAlertSink>(*notificationManager_);
+    dispatcher.addSubscriber(userId_, ownedAlertSink_);
+    dispatcher.subscribeAll(userId_);
+    // Stale results are refreshed in the background rather than on the user's time
+    PrefetchScheduler* scheduler = scheduler_;
+    weatherService_->setRevalidator([scheduler](const WeatherQuery& query) {
+        scheduler->revalidate(query);
+    });
+}
+
+WeatherBot::WeatherBot(WeatherService& weatherService, NotificationManager& notificationManager, std::ostream& out,
+                       PrefetchScheduler* scheduler, const std::string& userId)
+    : weatherService_(&weatherService),
+      notificationManager_(&notificationManager),
+      scheduler_(scheduler),
+      out_(out),
+      userId_(userId),
+      running_(true) {
+}
+
+WeatherBot::~WeatherBot() {
+    if (ownedAlertSink_) {
+        // The sink shows alerts through the notification manager this bot owns
+        weatherService_->getContext()->dispatcher->removeSink(ownedAlertSink_.get());
     }
-    
-    return tokens;
 }
 
 void WeatherBot::showWelcome() {
-    std::cout << "\n";
-    std::cout << "╔═══════════════════════════════════════════════════════╗\n";
-    std::cout << "║                                                       ║\n";
-    std::cout << "║          🌤️  WEATHER FORECAST CHATBOT 🌤️            ║\n";
-    std::cout << "║                                                       ║\n";
-    std::cout << "║     Get instant weather information for any city!    ║\n";
-    std::cout << "║                                                       ║\n";
-    std::cout << "╚═══════════════════════════════════════════════════════╝\n";
-    std::cout << "\n";
+    out_ << "\n";
+    out_ << "╔═══════════════════════════════════════════════════════╗\n";
+    out_ << "║                                                       ║\n";
+    out_ << "║          🌤️  WEATHER FORECAST CHATBOT 🌤️            ║\n";
+    out_ << "║                                                       ║\n";
+    out_ << "║     Get instant weather information for any city!    ║\n";
+    out_ << "║                                                       ║\n";
+    out_ << "╚═══════════════════════════════════════════════════════╝\n";
+    out_ << "\n";
     notificationManager_->showNotification("Welcome! Type 'help' to see available commands.", NotificationType::INFO);
 }
 
 void WeatherBot::showHelp() {
-    std::cout << "\n═══════════════════════════════════════════════════════\n";
-    std::cout << "                    COMMAND HELP                        \n";
-    std::cout << "═══════════════════════════════════════════════════════\n";
-    std::cout << "  Commands:\n";
-    std::cout << "    weather <city>          - Get weather for a city\n";
-    std::cout << "    location <lat> <lon>    - Get weather by coordinates\n";
-    std::cout << "    help                    - Show this help message\n";
-    std::cout << "    notifications           - View notification history\n";
-    std::cout << "    clear                   - Clear notifications\n";
-    std::cout << "    exit / quit             - Exit the application\n";
-    std::cout << "\n  Examples:\n";
-    std::cout << "    weather London\n";
-    std::cout << "    weather New York\n";
-    std::cout << "    location 51.5074 -0.1278\n";
-    std::cout << "═══════════════════════════════════════════════════════\n\n";
-}
-
-void WeatherBot::handleWeatherQuery(const std::string& city) {
+    notificationManager_->sync();
+    out_ << "\n═══════════════════════════════════════════════════════\n";
+    out_ << "                    COMMAND HELP                        \n";
+    out_ << "═══════════════════════════════════════════════════════\n";
+    out_ << "  Commands:\n";
+    out_ << "    weather <city>          - Get weather for a city\n";
+    out_ << "    weather <c1>; <c2>; ... - Get weather for several cities at once\n";
+    out_ << "    weather <id>; <id>; ... - Get weather by OpenWeatherMap city ID\n";
+    out_ << "    forecast <city> [hours] - Forecast with min/max/avg (default 24h)\n";
+    out_ << "    location <lat> <lon>    - Get weather by coordinates\n";
+    out_ << "    history <city> [range]  - Aggregates of logged observations (e.g. 24h, 7d, 2w)\n";
+    out_ << "    weather|location ... @<provider>\n";
+    out_ << "                            - Ask one weather provider only (e.g. @open-meteo)\n";
+    out_ << "    find <prefix>           - Search known cities (needs a gazetteer)\n";
+    out_ << "    watch [city]            - Keep a city fresh and get its alerts / list watched\n";
+    out_ << "    unwatch <city>          - Stop watching a city and its alerts\n";
+    out_ << "    alert [list]            - Show alert rules\n";
+    out_ << "    alert add <metric> <above|below> <value> [city]\n";
+    out_ << "                            - Add your own alert (temp, wind, humidity, or *-rate)\n";
+    out_ << "    alert remove <id>       - Remove one of your alert rules\n";
+    out_ << "    help                    - Show this help message\n";
+    out_ << "    notifications           - View notification history\n";
+    out_ << "    cache [clear]           - Show or reset response cache\n";
+    out_ << "    stats [prometheus]      - Show latency and error metrics\n";
+    out_ << "    config [reload]         - Show or reload runtime settings\n";
+    out_ << "    clear                   - Clear notifications\n";
+    out_ << "    exit / quit             - Exit the application\n";
+    out_ << "\n  Examples:\n";
+    out_ << "    weather London\n";
+    out_ << "    weather New York\n";
+    out_ << "    weather London; Paris; Tokyo\n";
+    out_ << "    forecast Paris 48\n";
+    out_ << "    location 51.5074 -0.1278\n";
+    out_ << "    weather London @open-meteo\n";
+    out_ << "    history Oslo 7d\n";
+    out_ << "═══════════════════════════════════════════════════════\n\n";
+}
+
+void WeatherBot::reportWeather(const WeatherData& data) {
+    notificationManager_->sync();
+    reportBuffer.clear();
+    weatherService_->formatWeatherReport(data, reportBuffer);
+    out_.write(reportBuffer.data(), static_cast<std::streamsize>(reportBuffer.size()));
+    if (data.isStale) {
+        notificationManager_->showNotification("Showing the last known weather; the live service is slow or unavailable.",
+                                               NotificationType::WARNING);
+    } else {
+        notificationManager_->showNotification("Weather data retrieved successfully!", NotificationType::SUCCESS);
+    }
+    
+    // Show the alerts currently active for this location, including the user's own rules
+    AlertEngine& alerts = *weatherService_->getContext()->alerts;
+    alerts.update(data);
+    std::string city(data.city());
+    for (const auto& condition : alerts.evaluateLocation(city, userId_)) {
+        notificationManager_->showWeatherAlert(city, condition);
+    }
+}
+
+bool WeatherBot::resolveProvider(std::string_view name, std::string& provider) {
+    provider.clear();
+    if (name.empty()) {
+        return true;
+    }
+    const ProviderRouter& router = *weatherService_->getContext()->providers;
+    long index = router.find(name);
+    if (index < 0) {
+        std::string known;
+        for (size_t i = 0; i < router.size(); ++i) {
+            known += (i > 0 ? ", " : "") + std::string(router.provider(i).name());
+        }
+        notificationManager_->showNotification("Unknown weather provider: " + std::string(name) + ". Configured providers: " + known,
+                                               NotificationType::WARNING);
+        return false;
+    }
+    provider = router.provider(static_cast<size_t>(index)).name();
+    return true;
+}
+
+void WeatherBot::handleWeatherList(std::string_view list, const std::string& provider) {
+    std::vector<std::string> cities;
+    std::vector<long> cityIds;
+    while (!list.empty()) {
+        size_t separator = list.find(';');
+        std::string_view entry = CommandParser::trim(list.substr(0, separator));
+        list = separator == std::string_view::npos ? std::string_view() : list.substr(separator + 1);
+        if (entry.empty()) {
+            continue;
+        }
+        // Numeric entries are OpenWeatherMap city IDs, fetched together via the group endpoint
+        long cityId = 0;
+        if (isCityId(entry)) {
+            std::from_chars(entry.data(), entry.data() + entry.size(), cityId);
+            cityIds.push_back(cityId);
+        } else {
+            cities.push_back(CommandParser::joinWords(entry));
+        }
+    }
+    
+    if (!cityIds.empty()) {
+        // The group endpoint only exists on OpenWeatherMap
+        if (!provider.empty() && !OpenWeatherMapProvider().matches(provider)) {
+            notificationManager_->showNotification("City IDs are looked up through openweathermap; ignoring @" + provider + " for them.",
+                                                   NotificationType::WARNING);
+        }
+        handleCityIdQuery(cityIds);
+    }
+    if (!cities.empty()) {
+        handleBatchWeatherQuery(cities, provider);
+    }
+}
+
+Task<void> WeatherBot::handleWeatherQuery(std::string city, std::string provider) {
     if (city.empty()) {
         notificationManager_->showNotification("Please provide a city name. Usage: weather <city>", NotificationType::WARNING);
+        co_return;
+    }
+    
+    // Watched cities are kept fresh in the background and answered from memory,
+    // unless the command asked for a particular provider
+    WeatherData data;
+    if (!provider.empty() || !scheduler_ || !scheduler_->lookup(city, data)) {
+        notificationManager_->showNotification("Fetching weather data for " + city + "...", NotificationType::INFO);
+        WeatherQuery query = WeatherQuery::byCity(city);
+        query.provider = std::move(provider);
+        Task<WeatherData> lookup = weatherService_->getWeatherAsync(std::move(query));
+        data = co_await lookup;
+    }
+    
+    if (data.isValid) {
+        reportWeather(data);
+    } else {
+        reportLookupFailure(city);
+    }
+}
+
+void WeatherBot::reportLookupFailure(const std::string& city) {
+    const Gazetteer* gazetteer = weatherService_->getContext()->gazetteer.get();
+    GazetteerCity known;
+    if (gazetteer && gazetteer->isLoaded() && !gazetteer->resolve(city, known)) {
+        notificationManager_->showNotification("Unknown city: " + city + ". Use 'find <prefix>' to search known cities.", NotificationType::ERROR);
+    } else {
+        notificationManager_->showNotification("Failed to retrieve weather data for " + city + ". Please check the city name and try again.", NotificationType::ERROR);
+    }
+}
+
+void WeatherBot::handleBatchWeatherQuery(const std::vector<std::string>& cities, const std::string& provider) {
+    if (cities.empty()) {
+        notificationManager_->showNotification("Please provide a city name. Usage: weather <city>", NotificationType::WARNING);
+        return;
+    }
+    
+    std::vector<WeatherQuery> queries;
+    queries.reserve(cities.size());
+    for (const auto& city : cities) {
+        queries.push_back(WeatherQuery::byCity(city));
+        queries.back().provider = provider;
+    }
+    
+    notificationManager_->showNotification("Fetching weather data for " + std::to_string(cities.size()) + " cities...", NotificationType::INFO);
+    
+    // Reports are printed as each lookup completes rather than in input order
+    weatherService_->getWeatherBatch(queries, [this, &cities](size_t index, const WeatherData& data) {
+        if (data.isValid) {
+            reportWeather(data);
+        } else {
+            reportLookupFailure(cities[index]);
+        }
+    });
+}
+
+void WeatherBot::handleCityIdQuery(const std::vector<long>& cityIds) {
+    notificationManager_->showNotification("Fetching weather data for " + std::to_string(cityIds.size()) + " city IDs...", NotificationType::INFO);
+    
+    std::vector<WeatherData> results = weatherService_->getWeatherByIds(cityIds);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].isValid) {
+            reportWeather(results[i]);
+        } else {
+            notificationManager_->showNotification("Failed to retrieve weather data for city ID " + std::to_string(cityIds[i]) + ".", NotificationType::ERROR);
+        }
+    }
+}
+
+void WeatherBot::handleForecastQuery(const std::string& city, int hours) {
+    if (city.empty()) {
+        notificationManager_->showNotification("Please provide a city name. Usage: forecast <city> [hours]", NotificationType::WARNING);
+        return;
+    }
+    
+    // The 5-day forecast comes in 3-hour steps
+    hours = std::max(3, std::min(hours, 120));
+    notificationManager_->showNotification("Fetching forecast for " + city + "...", NotificationType::INFO);
+    
+    std::shared_ptr<const ForecastSeries> series = weatherService_->getForecast(city);
+    if (!series) {
+        notificationManager_->showNotification("Failed to retrieve forecast data. Please check the city name and try again.", NotificationType::ERROR);
+        return;
+    }
+    
+    notificationManager_->sync();
+    out_ << weatherService_->formatForecast(*series, hours);
+}
+
+void WeatherBot::handleHistoryCommand(std::string_view args) {
+    HistoryStore* history = weatherService_->getContext()->history.get();
+    if (!history) {
+        notificationManager_->showNotification("The observation log is off; start without --no-history to keep one.", NotificationType::WARNING);
+        return;
+    }
+    
+    if (args.empty()) {
+        HistoryStats stats = history->getStats();
+        notificationManager_->sync();
+        out_ << "History: " << stats.locations << " locations, " << stats.diskBytes / 1024 << " KiB in "
+             << history->getDirectory() << ", " << stats.pending << " samples not yet written";
+        if (stats.writtenSamples > 0) {
+            out_ << "; " << std::fixed << std::setprecision(1)
+                 << 8.0 * static_cast<double>(stats.writtenBytes) / static_cast<double>(stats.writtenSamples)
+                 << " bits per sample written this run";
+        }
+        out_ << "\n";
+        return;
+    }
+    
+    // An optional trailing "<n>h", "<n>d" or "<n>w" is the window; the default is a day
+    int64_t seconds = 24 * 3600;
+    std::string_view label = "24h";
+    std::string_view location = args;
+    size_t split = args.find_last_of(" \t");
+    std::string_view last = split == std::string_view::npos ? args : args.substr(split + 1);
+    if (last.size() >= 2 && last.size() < 8 && std::all_of(last.begin(), last.end() - 1, isDigit) &&
+        (last.back() == 'h' || last.back() == 'd' || last.back() == 'w')) {
+        int64_t count = 0;
+        std::from_chars(last.data(), last.data() + last.size() - 1, count);
+        seconds = count * (last.back() == 'h' ? 3600 : last.back() == 'd' ? 86400 : 7 * 86400);
+        label = last;
+        location = split == std::string_view::npos ? std::string_view() : CommandParser::trim(args.substr(0, split));
+    }
+    if (location.empty()) {
+        notificationManager_->showNotification("Please provide a city name. Usage: history <city> [24h|7d|2w]", NotificationType::WARNING);
         return;
     }
     
-    notificationManager_->showNotification("Fetching weather data for " + city + "...", NotificationType::INFO);
+    std::string name = CommandParser::joinWords(location);
+    std::vector<std::string> matches = history->findLocations(name);
+    if (matches.empty()) {
+        notificationManager_->showNotification("No observations logged for " + name + " yet.", NotificationType::INFO);
+        return;
+    }
+    if (matches.size() > 1) {
+        std::string choices;
+        for (const auto& match : matches) {
+            choices += (choices.empty() ? "" : "; ") + match;
+        }
+        notificationManager_->showNotification("Several places are called " + name + ": " + choices + ". Add the country, e.g. 'history " + matches[0] + "'.",
+                                               NotificationType::WARNING);
+        return;
+    }
     
-    WeatherData data = weatherService_->getWeatherByCity(city);
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    HistorySummary summary;
+    history->summarize(matches[0], now - seconds, now + 1, summary);
+    size_t comma = matches[0].find(',');
+    std::string country = matches[0].substr(comma + 1);
+    std::transform(country.begin(), country.end(), country.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    std::string title = name.substr(0, name.find(',')) + (country.empty() ? "" : ", " + country) + " (last " + std::string(label) + ")";
+    notificationManager_->sync();
+    out_ << weatherService_->formatHistory(title, summary);
+}
+
+Task<void> WeatherBot::handleLocationQuery(double latitude, double longitude, std::string provider) {
+    notificationManager_->showNotification("Fetching weather data for coordinates...", NotificationType::INFO);
+    
+    WeatherQuery query = WeatherQuery::byCoordinates(latitude, longitude);
+    query.provider = std::move(provider);
+    Task<WeatherData> lookup = weatherService_->getWeatherAsync(std::move(query));
+    WeatherData data = co_await lookup;
     
     if (data.isValid) {
-        std::cout << weatherService_->formatWeatherReport(data);
-        notificationManager_->showNotification("Weather data retrieved successfully!", NotificationType::SUCCESS);
-        
-        // Show weather alerts for extreme conditions
-        if (data.temperature < 0) {
-            notificationManager_->showWeatherAlert(data.city, "Freezing temperatures!");
-        } else if (data.temperature > 35) {
-            notificationManager_->showWeatherAlert(data.city, "Very hot weather!");
+        reportWeather(data);
+    } else {
+        notificationManager_->showNotification("Failed to retrieve weather data for the given coordinates.", NotificationType::ERROR);
+    }
+}
+
+void WeatherBot::handleWatchCommand(const std::string& city) {
+    if (!scheduler_) {
+        notificationManager_->showNotification("Background refresh is not available.", NotificationType::WARNING);
+        return;
+    }
+    
+    if (city.empty()) {
+        std::vector<std::string> watched = scheduler_->getWatched();
+        if (watched.empty()) {
+            notificationManager_->showNotification("No watched locations. Usage: watch <city>", NotificationType::INFO);
+            return;
         }
-        
-        if (data.windSpeed > 15) {
-            notificationManager_->showWeatherAlert(data.city, "Strong winds detected!");
+        notificationManager_->sync();
+        out_ << "\n  Watched locations:\n";
+        for (const auto& name : watched) {
+            out_ << "    - " << name << "\n";
+        }
+        return;
+    }
+    
+    // Alerts the refreshes raise for the city are sent to whoever watches it
+    bool subscribed = weatherService_->getContext()->dispatcher->subscribe(userId_, city);
+    if (scheduler_->watch(city)) {
+        notificationManager_->showNotification("Watching " + city + ". It will be refreshed in the background.", NotificationType::SUCCESS);
+    } else if (subscribed) {
+        notificationManager_->showNotification("Watching " + city + ". You will be sent its weather alerts.", NotificationType::SUCCESS);
+    } else {
+        notificationManager_->showNotification(city + " is already being watched.", NotificationType::INFO);
+    }
+}
+
+void WeatherBot::handleUnwatchCommand(const std::string& city) {
+    if (city.empty()) {
+        notificationManager_->showNotification("Please provide a city name. Usage: unwatch <city>", NotificationType::WARNING);
+        return;
+    }
+    
+    AlertDispatcher& dispatcher = *weatherService_->getContext()->dispatcher;
+    bool unsubscribed = dispatcher.unsubscribe(userId_, city);
+    if (dispatcher.getSubscriberCount(city) > 0) {
+        // Still refreshed for the others watching it
+        if (unsubscribed) {
+            notificationManager_->showNotification("Stopped watching " + city + ".", NotificationType::INFO);
+        } else {
+            notificationManager_->showNotification("You are not watching " + city + ".", NotificationType::WARNING);
         }
+        return;
+    }
+    bool unwatched = scheduler_ && scheduler_->unwatch(city);
+    if (unwatched || unsubscribed) {
+        notificationManager_->showNotification("Stopped watching " + city + ".", NotificationType::INFO);
     } else {
-        notificationManager_->showNotification("Failed to retrieve weather data. Please check the city name and try again.", NotificationType::ERROR);
+        notificationManager_->showNotification(city + " is not being watched.", NotificationType::WARNING);
     }
 }
 
-void WeatherBot::handleLocationQuery(const std::string& lat, const std::string& lon) {
-    try {
-        double latitude = std::stod(lat);
-        double longitude = std::stod(lon);
-        
-        notificationManager_->showNotification("Fetching weather data for coordinates...", NotificationType::INFO);
-        
-        WeatherData data = weatherService_->getWeatherByCoordinates(latitude, longitude);
-        
-        if (data.isValid) {
-            std::cout << weatherService_->formatWeatherReport(data);
-            notificationManager_->showNotification("Weather data retrieved successfully!", NotificationType::SUCCESS);
+void WeatherBot::handleFindCommand(const std::string& prefix) {
+    const Gazetteer* gazetteer = weatherService_->getContext()->gazetteer.get();
+    if (!gazetteer || !gazetteer->isLoaded()) {
+        notificationManager_->showNotification("No gazetteer loaded. Start with --gazetteer <file> to search cities offline.", NotificationType::WARNING);
+        return;
+    }
+    if (prefix.empty()) {
+        notificationManager_->showNotification("Please provide the start of a city name. Usage: find <prefix>", NotificationType::WARNING);
+        return;
+    }
+    
+    std::vector<GazetteerCity> matches = gazetteer->complete(prefix, FIND_RESULT_LIMIT);
+    if (matches.empty()) {
+        notificationManager_->showNotification("No known city starts with '" + prefix + "'.", NotificationType::INFO);
+        return;
+    }
+    
+    notificationManager_->sync();
+    out_ << "\n  Known cities:\n";
+    for (const auto& city : matches) {
+        out_ << "    " << std::left << std::setw(30) << (city.name + ", " + city.country)
+             << " id " << std::setw(10) << city.id << " pop " << city.population << "\n";
+    }
+}
+
+void WeatherBot::handleAlertCommand(std::string_view args) {
+    AlertEngine& alerts = *weatherService_->getContext()->alerts;
+    CommandTokenizer tokens(args);
+    std::string_view action;
+    if (!tokens.next(action)) {
+        action = "list";
+    }
+    
+    if (action == "list") {
+        notificationManager_->sync();
+        out_ << "\n  Alert rules:\n";
+        for (const auto& entry : alerts.getRules(userId_)) {
+            const AlertRule& rule = entry.second;
+            out_ << "    #" << std::left << std::setw(4) << entry.first << rule.condition;
+            if (!rule.location.empty()) {
+                out_ << " in " << rule.location;
+            }
+            out_ << (rule.owner.empty() ? " (everyone)" : "") << "\n";
+        }
+        return;
+    }
+    
+    if (action == "remove" || action == "rm") {
+        std::string_view id;
+        uint32_t ruleId = 0;
+        bool valid = tokens.next(id) && id.size() <= 9 && std::all_of(id.begin(), id.end(), isDigit) &&
+                     std::from_chars(id.data(), id.data() + id.size(), ruleId).ec == std::errc();
+        if (!valid) {
+            notificationManager_->showNotification("Usage: alert remove <id>", NotificationType::WARNING);
+        } else if (alerts.removeRule(ruleId, userId_)) {
+            notificationManager_->showNotification("Alert rule #" + std::string(id) + " removed.", NotificationType::INFO);
+        } else {
+            notificationManager_->showNotification("No alert rule #" + std::string(id) + " of yours to remove.", NotificationType::WARNING);
+        }
+        return;
+    }
+    
+    const char* usage = "Usage: alert add <temp|wind|humidity>[-rate] <above|below> <value> [city]";
+    std::string_view metricName;
+    std::string_view comparison;
+    std::string_view value;
+    if (action != "add" || !tokens.next(metricName) || !tokens.next(comparison) || !tokens.next(value)) {
+        notificationManager_->showNotification(usage, NotificationType::WARNING);
+        return;
+    }
+    
+    AlertRule rule;
+    rule.owner = userId_;
+    std::string metric(metricName);
+    std::transform(metric.begin(), metric.end(), metric.begin(), ::tolower);
+    const std::string rateSuffix = "-rate";
+    if (metric.size() > rateSuffix.size() && metric.compare(metric.size() - rateSuffix.size(), rateSuffix.size(), rateSuffix) == 0) {
+        rule.kind = AlertRuleKind::RATE_OF_CHANGE;
+        metric.erase(metric.size() - rateSuffix.size());
+    }
+    
+    std::string label;
+    std::string unit;
+    if (metric == "temp" || metric == "temperature") {
+        rule.metric = AlertMetric::TEMPERATURE;
+        rule.hysteresis = 1.0f;
+        label = "Temperature";
+        unit = "°C";
+    } else if (metric == "wind") {
+        rule.metric = AlertMetric::WIND_SPEED;
+        rule.hysteresis = 2.0f;
+        label = "Wind speed";
+        unit = " m/s";
+    } else if (metric == "humidity") {
+        rule.metric = AlertMetric::HUMIDITY;
+        rule.hysteresis = 5.0f;
+        label = "Humidity";
+        unit = "%";
+    } else {
+        notificationManager_->showNotification(usage, NotificationType::WARNING);
+        return;
+    }
+    if (rule.kind == AlertRuleKind::RATE_OF_CHANGE) {
+        // Rates are compared between consecutive observations, so there is nothing to smooth
+        rule.hysteresis = 0.0f;
+        label += " change";
+        unit += "/h";
+    }
+    
+    if (comparison != "above" && comparison != "below") {
+        notificationManager_->showNotification(usage, NotificationType::WARNING);
+        return;
+    }
+    rule.comparison = comparison == "above" ? AlertComparison::ABOVE : AlertComparison::BELOW;
+    
+    double threshold = 0.0;
+    if (!parseNumber(value, threshold)) {
+        notificationManager_->showNotification(usage, NotificationType::WARNING);
+        return;
+    }
+    rule.threshold = static_cast<float>(threshold);
+    rule.location = CommandParser::joinWords(tokens.remainder());
+    
+    std::ostringstream condition;
+    condition << label << " " << comparison << " " << rule.threshold << unit;
+    rule.condition = condition.str();
+    
+    uint32_t id = alerts.addRule(rule);
+    notificationManager_->showNotification("Alert rule #" + std::to_string(id) + " added: " + rule.condition +
+                                           (rule.location.empty() ? "" : " in " + rule.location), NotificationType::SUCCESS);
+}
+
+void WeatherBot::handleCacheCommand(std::string_view action) {
+    WeatherCache& cache = weatherService_->getCache();
+    
+    if (action == "clear") {
+        cache.clear();
+        notificationManager_->showNotification("Weather cache cleared.", NotificationType::INFO);
+        return;
+    }
+    
+    WeatherCacheStats stats = cache.getStats();
+    uint64_t lookups = stats.hits + stats.misses;
+    double hitRate = lookups > 0 ? 100.0 * stats.hits / lookups : 0.0;
+    
+    notificationManager_->sync();
+    out_ << "\n═══════════════════════════════════════\n";
+    out_ << "            CACHE STATISTICS           \n";
+    out_ << "═══════════════════════════════════════\n";
+    out_ << "  Entries:     " << stats.entries << " (" << stats.bytes / 1024 << " KiB)\n";
+    out_ << "  Hits:        " << stats.hits << "\n";
+    out_ << "  Misses:      " << stats.misses << "\n";
+    out_ << "  Hit rate:    " << std::fixed << std::setprecision(1) << hitRate << "%\n";
+    out_ << "  Evictions:   " << stats.evictions << "\n";
+    out_ << "  Expirations: " << stats.expirations << "\n";
+    out_ << "  Coalesced:   " << weatherService_->getCoalescer().getCoalescedCount() << "\n";
+    out_ << "  TTL:         " << cache.getConfig().ttl.count() << "s\n";
+    out_ << "═══════════════════════════════════════\n" << std::endl;
+}
+
+void WeatherBot::handleStatsCommand(std::string_view format) {
+    Metrics& metrics = weatherService_->getMetrics();
+    notificationManager_->sync();
+    
+    if (format == "prometheus" || format == "prom") {
+        out_ << metrics.formatPrometheus();
+        return;
+    }
+    
+    out_ << "\n═══════════════════════════════════════════════════════\n";
+    out_ << "                   REQUEST METRICS                      \n";
+    out_ << "═══════════════════════════════════════════════════════\n";
+    out_ << metrics.formatSummary();
+    out_ << "Breakers:";
+    WeatherServiceContext& context = *weatherService_->getContext();
+    for (size_t i = 0; i < static_cast<size_t>(Endpoint::COUNT); ++i) {
+        Endpoint endpoint = static_cast<Endpoint>(i);
+        CircuitBreaker& breaker = context.breaker(endpoint);
+        out_ << " " << CircuitBreaker::endpointName(endpoint) << "=" << CircuitBreaker::stateName(breaker.getState());
+        if (breaker.getRejectedCount() > 0) {
+            out_ << " (" << breaker.getRejectedCount() << " rejected)";
+        }
+    }
+    out_ << "\n";
+    RateLimiterStats limit = context.rateLimiter->getStats();
+    if (limit.enabled) {
+        out_ << "Rate limit: " << std::fixed << std::setprecision(1) << limit.requestsPerMinute << "/min, "
+             << limit.tokens << " tokens" << (limit.paused ? " (paused by upstream)" : "")
+             << ", " << limit.usedToday << " used today\n";
+    } else {
+        out_ << "Rate limit: off, " << limit.usedToday << " used today\n";
+    }
+    out_ << "Queued:";
+    for (size_t i = 0; i < limit.queued.size(); ++i) {
+        out_ << " " << RateLimiter::priorityName(static_cast<RequestPriority>(i)) << "=" << limit.queued[i];
+    }
+    out_ << " (" << limit.expired << " gave up, " << limit.throttled << " throttled)\n";
+    out_ << "Providers:";
+    for (const ProviderStats& provider : context.providers->getStats()) {
+        out_ << " " << provider.name << "=";
+        if (provider.samples > 0) {
+            out_ << std::fixed << std::setprecision(0) << provider.latencyMs << "ms";
+        } else {
+            out_ << "-";
+        }
+        out_ << " (" << CircuitBreaker::stateName(provider.breaker) << ", " << provider.answered << " ok, "
+             << provider.failed << " failed";
+        if (provider.raceWins > 0) {
+            out_ << ", " << provider.raceWins << " race wins";
+        }
+        out_ << ")";
+    }
+    out_ << "\n";
+    ConnectionStats connections = context.connections->getStats();
+    out_ << "Connections: HTTP " << ConnectionManager::httpVersionName(context.connections->getConfig().httpVersion);
+    if (context.connections->getConfig().warmup) {
+        out_ << ", " << connections.hosts << " hosts kept warm (" << connections.warmups << " warmed up, "
+             << connections.pings << " idle pings, " << connections.failed << " failed)";
+    }
+    out_ << "\n";
+    AlertDispatchStats fanout = context.dispatcher->getStats();
+    out_ << "Alert fan-out: " << fanout.subscribers << " subscribers on " << fanout.locations << " locations, "
+         << fanout.delivered << " delivered in " << fanout.batches << " batches (" << fanout.repeats << " repeats, "
+         << fanout.throttled << " throttled, " << fanout.dropped << " dropped)\n";
+    out_ << "═══════════════════════════════════════════════════════\n" << std::endl;
+}
+
+void WeatherBot::handleConfigCommand(std::string_view action) {
+    ConfigStore& config = *weatherService_->getContext()->config;
+    ConfigStats stats = config.getStats();
+    
+    if (action == "reload") {
+        if (stats.path.empty()) {
+            notificationManager_->showNotification("No config file loaded. Start with --config <path>.", NotificationType::WARNING);
+        } else if (config.reload()) {
+            notificationManager_->showNotification("Settings reloaded from " + stats.path + ".", NotificationType::INFO);
         } else {
-            notificationManager_->showNotification("Failed to retrieve weather data for the given coordinates.", NotificationType::ERROR);
+            notificationManager_->showNotification("Settings not reloaded; the previous ones stay in effect.", NotificationType::WARNING);
         }
-    } catch (const std::exception& e) {
-        notificationManager_->showNotification("Invalid coordinates. Please provide valid latitude and longitude.", NotificationType::ERROR);
+        return;
+    }
+    
+    notificationManager_->sync();
+    out_ << "\n═══════════════════════════════════════\n";
+    out_ << "            RUNTIME SETTINGS           \n";
+    out_ << "═══════════════════════════════════════\n";
+    if (stats.path.empty()) {
+        out_ << "  No config file; defaults and flags\n";
+    } else {
+        out_ << "  File: " << stats.path << (stats.watching ? " (watched)" : "") << "\n";
+        out_ << "  Reloads: " << stats.reloads << " applied, " << stats.rejected << " rejected\n";
     }
+    std::istringstream lines(ConfigStore::format(config.get()));
+    std::string line;
+    while (std::getline(lines, line)) {
+        out_ << "  " << line << "\n";
+    }
+    out_ << "═══════════════════════════════════════\n" << std::endl;
 }
 
 void WeatherBot::handleHelpCommand() {
@@ -122,44 +703,136 @@ void WeatherBot::handleExitCommand() {
 }
 
 void WeatherBot::processCommand(const std::string& command) {
-    std::string trimmed = trim(command);
-    if (trimmed.empty()) {
+    CommandLine line = CommandParser::parse(command);
+    if (line.command == Command::NONE) {
         return;
     }
     
-    std::vector<std::string> tokens = splitCommand(trimmed);
-    std::string cmd = tokens.empty() ? "" : tokens[0];
-    
-    // Convert to lowercase
-    std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+    StageTimer timer(weatherService_->getMetrics(), Stage::COMMAND);
+    if (!runCommand(line)) {
+        syncWait(awaitCommand(line));
+    }
+}
+
+Task<void> WeatherBot::processCommandAsync(std::string command) {
+    CommandLine line = CommandParser::parse(command);
+    if (line.command == Command::NONE) {
+        co_return;
+    }
     
-    if (cmd == "weather" || cmd == "w") {
-        if (tokens.size() < 2) {
+    StageTimer timer(weatherService_->getMetrics(), Stage::COMMAND);
+    if (!runCommand(line)) {
+        Task<void> pending = awaitCommand(line);
+        co_await pending;
+    }
+}
+
+bool WeatherBot::runCommand(const CommandLine& line) {
+    switch (line.command) {
+    case Command::WEATHER: {
+        std::string provider;
+        if (line.args.empty()) {
             notificationManager_->showNotification("Please provide a city name. Usage: weather <city>", NotificationType::WARNING);
+        } else if (!resolveProvider(line.provider, provider)) {
+            // Already reported
+        } else if (line.args.find(';') == std::string_view::npos && !isCityId(line.args)) {
+            // A single city name is looked up without blocking
+            return false;
         } else {
-            std::string city;
-            for (size_t i = 1; i < tokens.size(); ++i) {
-                if (i > 1) city += " ";
-                city += tokens[i];
+            handleWeatherList(line.args, provider);
+        }
+        return true;
+    }
+    case Command::FORECAST: {
+        // An optional trailing number is the window in hours
+        int hours = 24;
+        std::string_view city = line.args;
+        size_t split = city.find_last_of(" \t");
+        if (split != std::string_view::npos) {
+            std::string_view last = city.substr(split + 1);
+            if (last.size() < 6 && std::all_of(last.begin(), last.end(), isDigit)) {
+                std::from_chars(last.data(), last.data() + last.size(), hours);
+                city = city.substr(0, split);
             }
-            handleWeatherQuery(city);
         }
-    } else if (cmd == "location" || cmd == "loc") {
-        if (tokens.size() < 3) {
+        handleForecastQuery(CommandParser::joinWords(city), hours);
+        return true;
+    }
+    case Command::LOCATION: {
+        CommandTokenizer tokens(line.args);
+        std::string_view lat;
+        std::string_view lon;
+        if (!tokens.next(lat) || !tokens.next(lon)) {
             notificationManager_->showNotification("Please provide latitude and longitude. Usage: location <lat> <lon>", NotificationType::WARNING);
-        } else {
-            handleLocationQuery(tokens[1], tokens[2]);
+            return true;
         }
-    } else if (cmd == "help" || cmd == "h") {
+        std::string provider;
+        return !resolveProvider(line.provider, provider);
+    }
+    case Command::HISTORY:
+        handleHistoryCommand(line.args);
+        return true;
+    case Command::HELP:
         handleHelpCommand();
-    } else if (cmd == "notifications" || cmd == "notif") {
+        return true;
+    case Command::NOTIFICATIONS:
         notificationManager_->displayNotifications();
-    } else if (cmd == "clear") {
+        return true;
+    case Command::WATCH:
+        handleWatchCommand(CommandParser::joinWords(line.args));
+        return true;
+    case Command::UNWATCH:
+        handleUnwatchCommand(CommandParser::joinWords(line.args));
+        return true;
+    case Command::FIND:
+        handleFindCommand(CommandParser::joinWords(line.args));
+        return true;
+    case Command::ALERT:
+        handleAlertCommand(line.args);
+        return true;
+    case Command::CACHE:
+        handleCacheCommand(firstWord(line.args));
+        return true;
+    case Command::STATS:
+        handleStatsCommand(firstWord(line.args));
+        return true;
+    case Command::CONFIG:
+        handleConfigCommand(firstWord(line.args));
+        return true;
+    case Command::CLEAR:
         notificationManager_->clearNotifications();
-    } else if (cmd == "exit" || cmd == "quit" || cmd == "q") {
+        return true;
+    case Command::EXIT:
         handleExitCommand();
-    } else {
-        notificationManager_->showNotification("Unknown command. Type 'help' to see available commands.", NotificationType::WARNING);
+        return true;
+    case Command::NONE:
+        return true;
+    case Command::UNKNOWN:
+        break;
+    }
+    notificationManager_->showNotification("Unknown command. Type 'help' to see available commands.", NotificationType::WARNING);
+    return true;
+}
+
+Task<void> WeatherBot::awaitCommand(CommandLine line) {
+    // runCommand has already rejected unknown providers
+    std::string provider;
+    resolveProvider(line.provider, provider);
+    if (line.command == Command::WEATHER) {
+        Task<void> query = handleWeatherQuery(CommandParser::joinWords(line.args), std::move(provider));
+        co_await query;
+    } else if (line.command == Command::LOCATION) {
+        CommandTokenizer tokens(line.args);
+        std::string_view lat;
+        std::string_view lon;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        if (!tokens.next(lat) || !tokens.next(lon) || !parseNumber(lat, latitude) || !parseNumber(lon, longitude)) {
+            notificationManager_->showNotification("Invalid coordinates. Please provide valid latitude and longitude.", NotificationType::ERROR);
+            co_return;
+        }
+        Task<void> query = handleLocationQuery(latitude, longitude, std::move(provider));
+        co_await query;
     }
 }
 
@@ -169,8 +842,12 @@ void WeatherBot::start() {
     
     std::string input;
     while (running_) {
-        std::cout << "\nWeatherBot> ";
-        std::getline(std::cin, input);
+        // Anything posted in the background should land before the prompt
+        notificationManager_->sync();
+        out_ << "\nWeatherBot> ";
+        if (!std::getline(std::cin, input)) {
+            break;
+        }
         
         if (!input.empty()) {
             processCommand(input);
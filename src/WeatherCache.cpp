@@ -0,0 +1,188 @@
+#include "WeatherCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <functional>
+
+WeatherCache::WeatherCache(const WeatherCacheConfig& config) : shardBudget_(0) {
+    size_t shardCount = std::max<size_t>(config.shardCount, 1);
+    shards_.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+    }
+    setConfig(config);
+}
+
+void WeatherCache::setConfig(const WeatherCacheConfig& config) {
+    WeatherCacheConfig applied = config;
+    applied.shardCount = shards_.size();
+    shardBudget_.store(applied.maxBytes / applied.shardCount, std::memory_order_relaxed);
+    config_.publish(applied);
+}
+
+WeatherCache::~WeatherCache() {
+}
+
+std::string WeatherCache::cityKey(const std::string& cityName) {
+    // Lowercase and collapse whitespace so "New York" and "new  york" share an entry
+    std::string key = "city:";
+    bool pendingSpace = false;
+    for (char c : cityName) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = key.size() > 5;
+            continue;
+        }
+        if (pendingSpace) {
+            key += ' ';
+            pendingSpace = false;
+        }
+        key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+std::string WeatherCache::coordinatesKey(double latitude, double longitude) {
+    // Snap to a 0.01 degree grid cell (roughly 1 km)
+    long long latCell = std::llround(latitude * 100.0);
+    long long lonCell = std::llround(longitude * 100.0);
+    return "coord:" + std::to_string(latCell) + "," + std::to_string(lonCell);
+}
+
+std::string WeatherCache::idKey(long cityId) {
+    return "id:" + std::to_string(cityId);
+}
+
+size_t WeatherCache::entrySize(const std::string& key, const WeatherData&) {
+    // Results are fixed-size; only the key (held by the entry and the index) varies
+    return sizeof(Entry) + key.capacity() * 2;
+}
+
+WeatherCache::Shard& WeatherCache::shardFor(const std::string& key) {
+    return *shards_[std::hash<std::string>{}(key) % shards_.size()];
+}
+
+void WeatherCache::removeEntry(Shard& shard, std::list<Entry>::iterator it) {
+    shard.bytes -= it->bytes;
+    shard.index.erase(it->key);
+    shard.lru.erase(it);
+}
+
+bool WeatherCache::get(const std::string& key, WeatherData& data) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        ++misses_;
+        return false;
+    }
+
+    auto it = found->second;
+    Clock::time_point now = Clock::now();
+    if (now >= it->expiresAt) {
+        if (now >= it->expiresAt + config_.get().staleTtl) {
+            removeEntry(shard, it);
+            ++expirations_;
+        }
+        ++misses_;
+        return false;
+    }
+
+    // Move to the front of the LRU list
+    shard.lru.splice(shard.lru.begin(), shard.lru, it);
+    data = it->data;
+    ++hits_;
+    return true;
+}
+
+bool WeatherCache::getStale(const std::string& key, WeatherData& data) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end()) {
+        return false;
+    }
+
+    auto it = found->second;
+    Clock::time_point now = Clock::now();
+    if (now >= it->expiresAt + config_.get().staleTtl) {
+        removeEntry(shard, it);
+        ++expirations_;
+        return false;
+    }
+
+    data = it->data;
+    data.isStale = now >= it->expiresAt;
+    return true;
+}
+
+void WeatherCache::put(const std::string& key, const WeatherData& data) {
+    insert(key, data, Clock::now() + config_.get().ttl);
+}
+
+void WeatherCache::put(const std::string& key, const WeatherData& data, std::chrono::system_clock::time_point fetchedAt) {
+    std::chrono::seconds ttl = config_.get().ttl;
+    auto age = std::chrono::system_clock::now() - fetchedAt;
+    if (age >= ttl) {
+        return;
+    }
+    auto remaining = std::chrono::duration_cast<Clock::duration>(ttl - age);
+    insert(key, data, Clock::now() + remaining);
+}
+
+void WeatherCache::insert(const std::string& key, const WeatherData& data, Clock::time_point expiresAt) {
+    if (!data.isValid || config_.get().ttl.count() <= 0) {
+        return;
+    }
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        removeEntry(shard, found->second);
+    }
+
+    size_t bytes = entrySize(key, data);
+    size_t budget = shardBudget_.load(std::memory_order_relaxed);
+    if (bytes > budget) {
+        return;
+    }
+
+    while (!shard.lru.empty() && shard.bytes + bytes > budget) {
+        removeEntry(shard, std::prev(shard.lru.end()));
+        ++evictions_;
+    }
+
+    shard.lru.push_front(Entry{key, data, expiresAt, bytes});
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += bytes;
+    ++insertions_;
+}
+
+void WeatherCache::clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->lru.clear();
+        shard->bytes = 0;
+    }
+}
+
+WeatherCacheStats WeatherCache::getStats() const {
+    WeatherCacheStats stats;
+    stats.hits = hits_.load();
+    stats.misses = misses_.load();
+    stats.evictions = evictions_.load();
+    stats.expirations = expirations_.load();
+    stats.insertions = insertions_.load();
+
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->lru.size();
+        stats.bytes += shard->bytes;
+    }
+
+    return stats;
+}
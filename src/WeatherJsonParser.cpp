@@ -0,0 +1,1367 @@
+#include "WeatherJsonParser.h"
+#include <iostream>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+const int MAX_NESTING_DEPTH = 512;
+
+enum class ValueType {
+    OBJECT,
+    ARRAY,
+    STRING,
+    NUMBER,
+    BOOLEAN,
+    NULL_VALUE
+};
+
+const char* typeName(ValueType type) {
+    switch (type) {
+        case ValueType::OBJECT:
+            return "object";
+        case ValueType::ARRAY:
+            return "array";
+        case ValueType::STRING:
+            return "string";
+        case ValueType::NUMBER:
+            return "number";
+        case ValueType::BOOLEAN:
+            return "boolean";
+        default:
+            return "null";
+    }
+}
+
+// Minimal validating JSON cursor. Every method returns false and records an
+// error on malformed input; nothing is allocated unless a decoded string is
+// requested.
+class PullParser {
+public:
+    explicit PullParser(std::string_view input)
+        : pos_(input.data()), end_(input.data() + input.size()), error_(nullptr) {}
+
+    const char* error() const { return error_ ? error_ : "unexpected error"; }
+
+    bool peek(ValueType& type) {
+        skipWhitespace();
+        if (pos_ == end_) {
+            return fail("unexpected end of input; expected value");
+        }
+        switch (*pos_) {
+            case '{':
+                type = ValueType::OBJECT;
+                return true;
+            case '[':
+                type = ValueType::ARRAY;
+                return true;
+            case '"':
+                type = ValueType::STRING;
+                return true;
+            case 't':
+            case 'f':
+                type = ValueType::BOOLEAN;
+                return true;
+            case 'n':
+                type = ValueType::NULL_VALUE;
+                return true;
+            default:
+                if (*pos_ == '-' || (*pos_ >= '0' && *pos_ <= '9')) {
+                    type = ValueType::NUMBER;
+                    return true;
+                }
+                return fail("syntax error; unexpected character");
+        }
+    }
+
+    bool beginObject() {
+        return expect('{');
+    }
+
+    // Advances to the next member of the current object. On return either
+    // done is set or key holds the member name and the cursor sits on its value.
+    bool nextMember(bool& first, std::string_view& key, std::string& keyScratch, bool& done) {
+        skipWhitespace();
+        done = false;
+        if (pos_ != end_ && *pos_ == '}') {
+            ++pos_;
+            done = true;
+            return true;
+        }
+        if (!first) {
+            if (!expect(',')) {
+                return false;
+            }
+            skipWhitespace();
+        }
+        first = false;
+
+        if (pos_ == end_ || *pos_ != '"') {
+            return fail("syntax error; expected object key");
+        }
+        bool escaped = false;
+        if (!readString(nullptr, &key, &escaped)) {
+            return false;
+        }
+        if (escaped) {
+            keyScratch.clear();
+            const char* raw = key.data() - 1;
+            pos_ = raw;
+            if (!readString(&keyScratch, nullptr, nullptr)) {
+                return false;
+            }
+            key = keyScratch;
+        }
+        skipWhitespace();
+        return expect(':');
+    }
+
+    bool beginArray() {
+        return expect('[');
+    }
+
+    bool nextElement(bool& first, bool& done) {
+        skipWhitespace();
+        done = false;
+        if (pos_ != end_ && *pos_ == ']') {
+            ++pos_;
+            done = true;
+            return true;
+        }
+        if (!first && !expect(',')) {
+            return false;
+        }
+        first = false;
+        skipWhitespace();
+        return true;
+    }
+
+    // Reads a string value. Decoded text is appended to out when given; raw
+    // receives the undecoded contents and escaped reports whether they contain
+    // escape sequences.
+    bool readString(std::string* out, std::string_view* raw, bool* escaped) {
+        skipWhitespace();
+        if (!expect('"')) {
+            return false;
+        }
+        const char* start = pos_;
+        bool hasEscapes = false;
+
+        while (true) {
+            if (pos_ == end_) {
+                return fail("unexpected end of input; missing closing quote");
+            }
+            unsigned char c = static_cast<unsigned char>(*pos_);
+            if (c == '"') {
+                break;
+            }
+            if (c < 0x20) {
+                return fail("control character must be escaped");
+            }
+            if (c == '\\') {
+                hasEscapes = true;
+                if (!readEscape(out)) {
+                    return false;
+                }
+                continue;
+            }
+            const char* sequence = pos_;
+            if (!skipUtf8()) {
+                return false;
+            }
+            if (out) {
+                out->append(sequence, static_cast<size_t>(pos_ - sequence));
+            }
+        }
+
+        if (raw) {
+            *raw = std::string_view(start, static_cast<size_t>(pos_ - start));
+        }
+        if (escaped) {
+            *escaped = hasEscapes;
+        }
+        ++pos_;
+        return true;
+    }
+
+    bool readNumber(double& value) {
+        skipWhitespace();
+        const char* start = pos_;
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
+        }
+        if (pos_ == end_ || !isDigit(*pos_)) {
+            return fail("syntax error; invalid number");
+        }
+        if (*pos_ == '0') {
+            ++pos_;
+        } else {
+            skipDigits();
+        }
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            if (pos_ == end_ || !isDigit(*pos_)) {
+                return fail("syntax error; invalid number");
+            }
+            skipDigits();
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            if (pos_ == end_ || !isDigit(*pos_)) {
+                return fail("syntax error; invalid number");
+            }
+            skipDigits();
+        }
+
+        auto result = std::from_chars(start, pos_, value);
+        if (result.ec == std::errc()) {
+            return true;
+        }
+
+        // Out of range: underflow rounds towards zero like strtod, overflow is an error
+        char buffer[128];
+        size_t length = static_cast<size_t>(pos_ - start);
+        if (length >= sizeof(buffer)) {
+            return fail("number overflow");
+        }
+        std::memcpy(buffer, start, length);
+        buffer[length] = '\0';
+        value = std::strtod(buffer, nullptr);
+        return std::isinf(value) ? fail("number overflow") : true;
+    }
+
+    bool readBoolean(bool& value) {
+        skipWhitespace();
+        if (matchLiteral("true")) {
+            value = true;
+            return true;
+        }
+        if (matchLiteral("false")) {
+            value = false;
+            return true;
+        }
+        return fail("syntax error; invalid literal");
+    }
+
+    bool skipValue(int depth = 0) {
+        if (depth > MAX_NESTING_DEPTH) {
+            return fail("maximum nesting depth exceeded");
+        }
+
+        ValueType type;
+        if (!peek(type)) {
+            return false;
+        }
+
+        switch (type) {
+            case ValueType::OBJECT: {
+                beginObject();
+                bool first = true;
+                bool done = false;
+                std::string_view key;
+                std::string scratch;
+                while (true) {
+                    if (!nextMember(first, key, scratch, done)) {
+                        return false;
+                    }
+                    if (done) {
+                        return true;
+                    }
+                    if (!skipValue(depth + 1)) {
+                        return false;
+                    }
+                }
+            }
+            case ValueType::ARRAY: {
+                beginArray();
+                bool first = true;
+                bool done = false;
+                while (true) {
+                    if (!nextElement(first, done)) {
+                        return false;
+                    }
+                    if (done) {
+                        return true;
+                    }
+                    if (!skipValue(depth + 1)) {
+                        return false;
+                    }
+                }
+            }
+            case ValueType::STRING:
+                return readString(nullptr, nullptr, nullptr);
+            case ValueType::NUMBER: {
+                double ignored;
+                return readNumber(ignored);
+            }
+            case ValueType::BOOLEAN: {
+                bool ignored;
+                return readBoolean(ignored);
+            }
+            default:
+                return matchLiteral("null") ? true : fail("syntax error; invalid literal");
+        }
+    }
+
+    bool finish() {
+        skipWhitespace();
+        return pos_ == end_ ? true : fail("syntax error; unexpected trailing characters");
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+    const char* error_;
+
+    bool fail(const char* message) {
+        if (!error_) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    void skipDigits() {
+        while (pos_ != end_ && isDigit(*pos_)) {
+            ++pos_;
+        }
+    }
+
+    void skipWhitespace() {
+        while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\t' || *pos_ == '\n' || *pos_ == '\r')) {
+            ++pos_;
+        }
+    }
+
+    bool expect(char c) {
+        if (pos_ == end_ || *pos_ != c) {
+            return fail("syntax error; unexpected character");
+        }
+        ++pos_;
+        return true;
+    }
+
+    bool matchLiteral(std::string_view literal) {
+        if (static_cast<size_t>(end_ - pos_) < literal.size() ||
+            std::string_view(pos_, literal.size()) != literal) {
+            return false;
+        }
+        pos_ += literal.size();
+        return true;
+    }
+
+    bool readHex4(uint32_t& value) {
+        if (end_ - pos_ < 4) {
+            return fail("unexpected end of input in \\u escape");
+        }
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *pos_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return fail("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    bool readEscape(std::string* out) {
+        ++pos_;
+        if (pos_ == end_) {
+            return fail("unexpected end of input in escape");
+        }
+        char c = *pos_++;
+        char decoded;
+        switch (c) {
+            case '"': decoded = '"'; break;
+            case '\\': decoded = '\\'; break;
+            case '/': decoded = '/'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            case 'n': decoded = '\n'; break;
+            case 'r': decoded = '\r'; break;
+            case 't': decoded = '\t'; break;
+            case 'u': {
+                uint32_t codepoint;
+                if (!readHex4(codepoint)) {
+                    return false;
+                }
+                if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                    return fail("invalid surrogate pair");
+                }
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    uint32_t low;
+                    if (end_ - pos_ < 2 || pos_[0] != '\\' || pos_[1] != 'u') {
+                        return fail("invalid surrogate pair");
+                    }
+                    pos_ += 2;
+                    if (!readHex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return fail("invalid surrogate pair");
+                    }
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (out) {
+                    appendUtf8(*out, codepoint);
+                }
+                return true;
+            }
+            default:
+                return fail("invalid escape sequence");
+        }
+        if (out) {
+            out->push_back(decoded);
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            out.push_back(static_cast<char>(codepoint));
+        } else if (codepoint < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else if (codepoint < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+        }
+    }
+
+    // Validates one UTF-8 sequence (RFC 3629) and advances past it
+    bool skipUtf8() {
+        unsigned char lead = static_cast<unsigned char>(*pos_);
+        int continuation;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+
+        if (lead < 0x80) {
+            ++pos_;
+            return true;
+        } else if (lead >= 0xC2 && lead <= 0xDF) {
+            continuation = 1;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            continuation = 2;
+            if (lead == 0xE0) low = 0xA0;
+            if (lead == 0xED) high = 0x9F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            continuation = 3;
+            if (lead == 0xF0) low = 0x90;
+            if (lead == 0xF4) high = 0x8F;
+        } else {
+            return fail("invalid UTF-8 byte");
+        }
+
+        ++pos_;
+        for (int i = 0; i < continuation; ++i) {
+            if (pos_ == end_) {
+                return fail("invalid UTF-8 byte");
+            }
+            unsigned char c = static_cast<unsigned char>(*pos_);
+            if (c < low || c > high) {
+                return fail("invalid UTF-8 byte");
+            }
+            low = 0x80;
+            high = 0xBF;
+            ++pos_;
+        }
+        return true;
+    }
+};
+
+// Mirrors the assignment semantics of the DOM path: the last occurrence of a
+// key wins and a value of the wrong type is an error.
+struct FieldState {
+    bool present = false;
+    const char* wrongType = nullptr;
+
+    void reset() {
+        present = false;
+        wrongType = nullptr;
+    }
+};
+
+struct Extraction {
+    WeatherData data;
+
+    bool codPresent = false;
+    bool codIsOk = false;
+
+    FieldState name;
+    FieldState country;
+
+    bool weatherNonEmpty = false;
+    const char* weatherFirstType = nullptr;
+    FieldState description;
+    FieldState icon;
+
+    FieldState temperature;
+    FieldState feelsLike;
+    FieldState humidity;
+    FieldState windSpeed;
+};
+
+bool readStringField(PullParser& parser, FieldState& field, std::string& target) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    field.present = true;
+    if (type != ValueType::STRING) {
+        field.wrongType = typeName(type);
+        return parser.skipValue();
+    }
+
+    field.wrongType = nullptr;
+    std::string_view raw;
+    bool escaped = false;
+    if (!parser.readString(nullptr, &raw, &escaped)) {
+        return false;
+    }
+    if (!escaped) {
+        target.assign(raw.data(), raw.size());
+        return true;
+    }
+
+    // Rare path: decode escape sequences by re-reading the quoted token
+    target.clear();
+    PullParser decoder(std::string_view(raw.data() - 1, raw.size() + 2));
+    return decoder.readString(&target, nullptr, nullptr);
+}
+
+// Interns the value straight from the response buffer; only escaped strings are decoded into a copy first
+bool readSymbolField(PullParser& parser, FieldState& field, Symbol& target) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    field.present = true;
+    if (type != ValueType::STRING) {
+        field.wrongType = typeName(type);
+        return parser.skipValue();
+    }
+
+    field.wrongType = nullptr;
+    std::string_view raw;
+    bool escaped = false;
+    if (!parser.readString(nullptr, &raw, &escaped)) {
+        return false;
+    }
+    if (!escaped) {
+        target = SymbolTable::global().intern(raw);
+        return true;
+    }
+
+    std::string decoded;
+    PullParser decoder(std::string_view(raw.data() - 1, raw.size() + 2));
+    if (!decoder.readString(&decoded, nullptr, nullptr)) {
+        return false;
+    }
+    target = SymbolTable::global().intern(decoded);
+    return true;
+}
+
+bool readNumberField(PullParser& parser, FieldState& field, double& target) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    field.present = true;
+    field.wrongType = nullptr;
+
+    if (type == ValueType::NUMBER) {
+        return parser.readNumber(target);
+    }
+
+    field.wrongType = typeName(type);
+    return parser.skipValue();
+}
+
+bool readNumberField(PullParser& parser, FieldState& field, float& target) {
+    double value = target;
+    if (!readNumberField(parser, field, value)) {
+        return false;
+    }
+    target = static_cast<float>(value);
+    return true;
+}
+
+template <typename MemberHandler>
+bool forEachMember(PullParser& parser, MemberHandler handler) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::OBJECT) {
+        return parser.skipValue();
+    }
+
+    parser.beginObject();
+    bool first = true;
+    bool done = false;
+    std::string_view key;
+    std::string scratch;
+    while (true) {
+        if (!parser.nextMember(first, key, scratch, done)) {
+            return false;
+        }
+        if (done) {
+            return true;
+        }
+        if (!handler(key)) {
+            return false;
+        }
+    }
+}
+
+bool readWeatherArray(PullParser& parser, Extraction& out) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::ARRAY) {
+        return parser.skipValue();
+    }
+
+    parser.beginArray();
+    bool first = true;
+    bool done = false;
+    size_t index = 0;
+    while (true) {
+        if (!parser.nextElement(first, done)) {
+            return false;
+        }
+        if (done) {
+            return true;
+        }
+
+        if (index++ > 0) {
+            if (!parser.skipValue()) {
+                return false;
+            }
+            continue;
+        }
+
+        out.weatherNonEmpty = true;
+        ValueType elementType;
+        if (!parser.peek(elementType)) {
+            return false;
+        }
+        out.weatherFirstType = elementType == ValueType::OBJECT ? nullptr : typeName(elementType);
+
+        bool ok = forEachMember(parser, [&](std::string_view key) {
+            if (key == "description") {
+                return readSymbolField(parser, out.description, out.data.descriptionSymbol);
+            }
+            if (key == "icon") {
+                return readSymbolField(parser, out.icon, out.data.iconSymbol);
+            }
+            return parser.skipValue();
+        });
+        if (!ok) {
+            return false;
+        }
+    }
+}
+
+// OpenWeatherMap reports success as 200, or as "200" on the forecast endpoint
+bool readCod(PullParser& parser, bool allowString, bool& present, bool& isOk) {
+    ValueType codType;
+    if (!parser.peek(codType)) {
+        return false;
+    }
+    present = true;
+    isOk = false;
+    if (codType == ValueType::STRING && allowString) {
+        std::string_view raw;
+        bool escaped = false;
+        if (!parser.readString(nullptr, &raw, &escaped)) {
+            return false;
+        }
+        isOk = raw == "200";
+        return true;
+    }
+    if (codType != ValueType::NUMBER) {
+        return parser.skipValue();
+    }
+    double cod;
+    if (!parser.readNumber(cod)) {
+        return false;
+    }
+    isOk = cod == 200.0;
+    return true;
+}
+
+// Reads one current-weather object: a whole response, or an entry of a group response
+bool readObservation(PullParser& parser, Extraction& out) {
+    return forEachMember(parser, [&](std::string_view key) {
+        if (key == "cod") {
+            return readCod(parser, false, out.codPresent, out.codIsOk);
+        }
+        if (key == "id") {
+            ValueType idType;
+            if (!parser.peek(idType)) {
+                return false;
+            }
+            out.data.cityId = 0;
+            if (idType != ValueType::NUMBER) {
+                return parser.skipValue();
+            }
+            double id;
+            if (!parser.readNumber(id)) {
+                return false;
+            }
+            out.data.cityId = static_cast<int64_t>(id);
+            return true;
+        }
+        if (key == "name") {
+            return readSymbolField(parser, out.name, out.data.citySymbol);
+        }
+        if (key == "sys") {
+            out.country.reset();
+            out.data.countrySymbol = 0;
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "country") {
+                    return readSymbolField(parser, out.country, out.data.countrySymbol);
+                }
+                return parser.skipValue();
+            });
+        }
+        if (key == "weather") {
+            out.weatherNonEmpty = false;
+            out.weatherFirstType = nullptr;
+            out.description.reset();
+            out.icon.reset();
+            out.data.descriptionSymbol = 0;
+            out.data.iconSymbol = 0;
+            return readWeatherArray(parser, out);
+        }
+        if (key == "main") {
+            out.temperature.reset();
+            out.feelsLike.reset();
+            out.humidity.reset();
+            out.data.temperature = 0.0f;
+            out.data.feelsLike = 0.0f;
+            out.data.humidity = 0.0f;
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "temp") {
+                    return readNumberField(parser, out.temperature, out.data.temperature);
+                }
+                if (member == "feels_like") {
+                    return readNumberField(parser, out.feelsLike, out.data.feelsLike);
+                }
+                if (member == "humidity") {
+                    return readNumberField(parser, out.humidity, out.data.humidity);
+                }
+                return parser.skipValue();
+            });
+        }
+        if (key == "wind") {
+            out.windSpeed.reset();
+            out.data.windSpeed = 0.0f;
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "speed") {
+                    return readNumberField(parser, out.windSpeed, out.data.windSpeed);
+                }
+                return parser.skipValue();
+            });
+        }
+        return parser.skipValue();
+    });
+}
+
+bool readDocument(PullParser& parser, Extraction& out) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::OBJECT) {
+        // Non-object documents carry none of the fields but are not an error
+        return parser.skipValue() && parser.finish();
+    }
+
+    return readObservation(parser, out) && parser.finish();
+}
+
+const char* firstTypeError(const Extraction& out) {
+    const FieldState* fields[] = {&out.name, &out.country, &out.description, &out.icon,
+                                  &out.temperature, &out.feelsLike, &out.humidity, &out.windSpeed};
+
+    if (out.weatherNonEmpty) {
+        if (out.weatherFirstType) {
+            return "cannot use operator[] with a string argument on a non-object weather entry";
+        }
+        if (!out.description.present) {
+            return "key 'description' not found in weather entry";
+        }
+    }
+
+    for (const FieldState* field : fields) {
+        if (field->present && field->wrongType) {
+            return field == &out.name || field == &out.country || field == &out.description || field == &out.icon
+                ? "type must be string" : "type must be number";
+        }
+    }
+    return nullptr;
+}
+
+WeatherData finishObservation(Extraction& out) {
+    if (out.codPresent && !out.codIsOk) {
+        return WeatherData();
+    }
+
+    if (const char* error = firstTypeError(out)) {
+        std::cerr << "Error parsing JSON: " << error << std::endl;
+        return WeatherData();
+    }
+
+    out.data.isValid = true;
+    return out.data;
+}
+
+bool readGroupList(PullParser& parser, std::vector<Extraction>& entries) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::ARRAY) {
+        return parser.skipValue();
+    }
+
+    entries.clear();
+    parser.beginArray();
+    bool first = true;
+    bool done = false;
+    while (true) {
+        if (!parser.nextElement(first, done)) {
+            return false;
+        }
+        if (done) {
+            return true;
+        }
+        entries.emplace_back();
+        ValueType elementType;
+        if (!parser.peek(elementType)) {
+            return false;
+        }
+        if (elementType != ValueType::OBJECT) {
+            // Not an observation; reported as a failed entry
+            entries.back().codPresent = true;
+            if (!parser.skipValue()) {
+                return false;
+            }
+            continue;
+        }
+        if (!readObservation(parser, entries.back())) {
+            return false;
+        }
+    }
+}
+
+// Forecast fields are read strictly: a value of the wrong type fails the whole series
+struct ForecastExtraction {
+    ForecastSeries series;
+    bool codPresent = false;
+    bool codIsOk = false;
+    const char* typeError = nullptr;
+};
+
+bool readForecastNumber(PullParser& parser, ForecastExtraction& out, double& target) {
+    FieldState field;
+    if (!readNumberField(parser, field, target)) {
+        return false;
+    }
+    if (field.wrongType && !out.typeError) {
+        out.typeError = "type must be number";
+    }
+    return true;
+}
+
+bool readForecastString(PullParser& parser, ForecastExtraction& out, std::string& target) {
+    FieldState field;
+    if (!readStringField(parser, field, target)) {
+        return false;
+    }
+    if (field.wrongType && !out.typeError) {
+        out.typeError = "type must be string";
+    }
+    return true;
+}
+
+bool readForecastEntry(PullParser& parser, ForecastExtraction& out, ConditionTable& conditions,
+                       std::string& description) {
+    bool hasTime = false;
+    double time = 0.0;
+    double temperature = 0.0;
+    double humidity = 0.0;
+    double windSpeed = 0.0;
+    double code = 0.0;
+
+    bool ok = forEachMember(parser, [&](std::string_view key) {
+        if (key == "dt") {
+            hasTime = true;
+            return readForecastNumber(parser, out, time);
+        }
+        if (key == "main") {
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "temp") {
+                    return readForecastNumber(parser, out, temperature);
+                }
+                if (member == "humidity") {
+                    return readForecastNumber(parser, out, humidity);
+                }
+                return parser.skipValue();
+            });
+        }
+        if (key == "wind") {
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "speed") {
+                    return readForecastNumber(parser, out, windSpeed);
+                }
+                return parser.skipValue();
+            });
+        }
+        if (key == "weather") {
+            ValueType type;
+            if (!parser.peek(type)) {
+                return false;
+            }
+            if (type != ValueType::ARRAY) {
+                return parser.skipValue();
+            }
+            parser.beginArray();
+            bool first = true;
+            bool done = false;
+            size_t index = 0;
+            while (true) {
+                if (!parser.nextElement(first, done)) {
+                    return false;
+                }
+                if (done) {
+                    return true;
+                }
+                if (index++ > 0) {
+                    if (!parser.skipValue()) {
+                        return false;
+                    }
+                    continue;
+                }
+                bool entryOk = forEachMember(parser, [&](std::string_view member) {
+                    if (member == "id") {
+                        return readForecastNumber(parser, out, code);
+                    }
+                    if (member == "description") {
+                        return readForecastString(parser, out, description);
+                    }
+                    return parser.skipValue();
+                });
+                if (!entryOk) {
+                    return false;
+                }
+            }
+        }
+        return parser.skipValue();
+    });
+    if (!ok) {
+        return false;
+    }
+
+    if (hasTime) {
+        uint16_t condition = static_cast<uint16_t>(std::clamp(code, 0.0, 65535.0));
+        conditions.intern(condition, description);
+        ForecastSeries& series = out.series;
+        series.time.push_back(static_cast<int64_t>(time));
+        series.temperature.push_back(static_cast<float>(temperature));
+        series.humidity.push_back(static_cast<float>(humidity));
+        series.windSpeed.push_back(static_cast<float>(windSpeed));
+        series.condition.push_back(condition);
+    }
+    description.clear();
+    return true;
+}
+
+bool readForecastDocument(PullParser& parser, ForecastExtraction& out, ConditionTable& conditions) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::OBJECT) {
+        return parser.skipValue() && parser.finish();
+    }
+
+    std::string description;
+    bool ok = forEachMember(parser, [&](std::string_view key) {
+        if (key == "cod") {
+            return readCod(parser, true, out.codPresent, out.codIsOk);
+        }
+        if (key == "city") {
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "id") {
+                    double id = 0.0;
+                    bool read = readForecastNumber(parser, out, id);
+                    out.series.cityId = static_cast<long>(id);
+                    return read;
+                }
+                if (member == "name") {
+                    return readForecastString(parser, out, out.series.city);
+                }
+                if (member == "country") {
+                    return readForecastString(parser, out, out.series.country);
+                }
+                if (member == "timezone") {
+                    double offset = 0.0;
+                    bool read = readForecastNumber(parser, out, offset);
+                    out.series.timezoneOffset = static_cast<int32_t>(offset);
+                    return read;
+                }
+                return parser.skipValue();
+            });
+        }
+        if (key == "list") {
+            ValueType listType;
+            if (!parser.peek(listType)) {
+                return false;
+            }
+            if (listType != ValueType::ARRAY) {
+                return parser.skipValue();
+            }
+            parser.beginArray();
+            bool first = true;
+            bool done = false;
+            while (true) {
+                if (!parser.nextElement(first, done)) {
+                    return false;
+                }
+                if (done) {
+                    return true;
+                }
+                if (!readForecastEntry(parser, out, conditions, description)) {
+                    return false;
+                }
+            }
+        }
+        return parser.skipValue();
+    });
+
+    return ok && parser.finish();
+}
+
+// Open-Meteo reports conditions as WMO weather interpretation codes
+struct WmoCondition {
+    int code;
+    const char* description;
+    const char* icon;  // OpenWeatherMap icon, without the day/night suffix
+};
+
+const WmoCondition WMO_CONDITIONS[] = {
+    {0, "clear sky", "01"},
+    {1, "mainly clear", "02"},
+    {2, "partly cloudy", "03"},
+    {3, "overcast clouds", "04"},
+    {45, "fog", "50"},
+    {48, "depositing rime fog", "50"},
+    {51, "light drizzle", "09"},
+    {53, "drizzle", "09"},
+    {55, "heavy drizzle", "09"},
+    {56, "light freezing drizzle", "09"},
+    {57, "freezing drizzle", "09"},
+    {61, "light rain", "10"},
+    {63, "moderate rain", "10"},
+    {65, "heavy rain", "10"},
+    {66, "light freezing rain", "13"},
+    {67, "freezing rain", "13"},
+    {71, "light snow", "13"},
+    {73, "snow", "13"},
+    {75, "heavy snow", "13"},
+    {77, "snow grains", "13"},
+    {80, "light shower rain", "09"},
+    {81, "shower rain", "09"},
+    {82, "heavy shower rain", "09"},
+    {85, "light shower snow", "13"},
+    {86, "heavy shower snow", "13"},
+    {95, "thunderstorm", "11"},
+    {96, "thunderstorm with light hail", "11"},
+    {99, "thunderstorm with heavy hail", "11"},
+};
+
+struct OpenMeteoExtraction {
+    WeatherData data;
+    bool error = false;       // {"error":true,"reason":...}
+    bool hasCurrent = false;
+    bool isDay = true;
+    double code = -1.0;
+    FieldState temperature;
+    FieldState feelsLike;
+    FieldState humidity;
+    FieldState windSpeed;
+    FieldState weatherCode;
+};
+
+bool readOpenMeteoDocument(PullParser& parser, OpenMeteoExtraction& out) {
+    ValueType type;
+    if (!parser.peek(type)) {
+        return false;
+    }
+    if (type != ValueType::OBJECT) {
+        return parser.skipValue() && parser.finish();
+    }
+
+    bool ok = forEachMember(parser, [&](std::string_view key) {
+        if (key == "error") {
+            ValueType errorType;
+            if (!parser.peek(errorType)) {
+                return false;
+            }
+            if (errorType != ValueType::BOOLEAN) {
+                return parser.skipValue();
+            }
+            return parser.readBoolean(out.error);
+        }
+        if (key == "current") {
+            out.hasCurrent = true;
+            return forEachMember(parser, [&](std::string_view member) {
+                if (member == "temperature_2m") {
+                    return readNumberField(parser, out.temperature, out.data.temperature);
+                }
+                if (member == "apparent_temperature") {
+                    return readNumberField(parser, out.feelsLike, out.data.feelsLike);
+                }
+                if (member == "relative_humidity_2m") {
+                    return readNumberField(parser, out.humidity, out.data.humidity);
+                }
+                if (member == "wind_speed_10m") {
+                    return readNumberField(parser, out.windSpeed, out.data.windSpeed);
+                }
+                if (member == "weather_code") {
+                    return readNumberField(parser, out.weatherCode, out.code);
+                }
+                if (member == "is_day") {
+                    FieldState field;
+                    double isDay = 1.0;
+                    bool read = readNumberField(parser, field, isDay);
+                    out.isDay = isDay != 0.0;
+                    return read;
+                }
+                return parser.skipValue();
+            });
+        }
+        return parser.skipValue();
+    });
+    return ok && parser.finish();
+}
+
+// Range queries binary-search the time column, so keep entries in time order
+void sortByTime(ForecastSeries& series) {
+    if (std::is_sorted(series.time.begin(), series.time.end())) {
+        return;
+    }
+    std::vector<size_t> order(series.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return series.time[a] < series.time[b]; });
+
+    auto permute = [&order](auto& column) {
+        auto sorted = column;
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted[i] = column[order[i]];
+        }
+        column.swap(sorted);
+    };
+    permute(series.time);
+    permute(series.temperature);
+    permute(series.humidity);
+    permute(series.windSpeed);
+    permute(series.condition);
+}
+
+} // namespace
+
+WeatherData WeatherJsonParser::parse(std::string_view json) {
+    Extraction out;
+    PullParser parser(json);
+
+    if (!readDocument(parser, out)) {
+        std::cerr << "Error parsing JSON response: " << parser.error() << std::endl;
+        return WeatherData();
+    }
+
+    return finishObservation(out);
+}
+
+std::vector<WeatherData> WeatherJsonParser::parseGroup(std::string_view json) {
+    PullParser parser(json);
+    std::vector<Extraction> entries;
+    bool codPresent = false;
+    bool codIsOk = false;
+
+    ValueType type;
+    bool ok = parser.peek(type);
+    if (ok && type == ValueType::OBJECT) {
+        ok = forEachMember(parser, [&](std::string_view key) {
+            if (key == "cod") {
+                return readCod(parser, false, codPresent, codIsOk);
+            }
+            if (key == "list") {
+                return readGroupList(parser, entries);
+            }
+            return parser.skipValue();
+        }) && parser.finish();
+    } else if (ok) {
+        ok = parser.skipValue() && parser.finish();
+    }
+
+    if (!ok) {
+        std::cerr << "Error parsing JSON response: " << parser.error() << std::endl;
+        return {};
+    }
+    if (codPresent && !codIsOk) {
+        return {};
+    }
+
+    std::vector<WeatherData> results;
+    results.reserve(entries.size());
+    for (Extraction& entry : entries) {
+        results.push_back(finishObservation(entry));
+    }
+    return results;
+}
+
+ForecastSeries WeatherJsonParser::parseForecast(std::string_view json, ConditionTable& conditions) {
+    ForecastExtraction out;
+    PullParser parser(json);
+
+    if (!readForecastDocument(parser, out, conditions)) {
+        std::cerr << "Error parsing JSON response: " << parser.error() << std::endl;
+        return ForecastSeries();
+    }
+    if (out.codPresent && !out.codIsOk) {
+        return ForecastSeries();
+    }
+    if (out.typeError) {
+        std::cerr << "Error parsing JSON: " << out.typeError << std::endl;
+        return ForecastSeries();
+    }
+
+    sortByTime(out.series);
+    out.series.isValid = true;
+    return std::move(out.series);
+}
+
+WeatherData WeatherJsonParser::parseOpenMeteo(std::string_view json) {
+    OpenMeteoExtraction out;
+    PullParser parser(json);
+
+    if (!readOpenMeteoDocument(parser, out)) {
+        std::cerr << "Error parsing JSON response: " << parser.error() << std::endl;
+        return WeatherData();
+    }
+    if (out.error || !out.hasCurrent || !out.temperature.present) {
+        return WeatherData();
+    }
+    const FieldState* fields[] = {&out.temperature, &out.feelsLike, &out.humidity, &out.windSpeed, &out.weatherCode};
+    for (const FieldState* field : fields) {
+        if (field->wrongType) {
+            std::cerr << "Error parsing JSON: type must be number" << std::endl;
+            return WeatherData();
+        }
+    }
+    if (!out.feelsLike.present) {
+        out.data.feelsLike = out.data.temperature;
+    }
+
+    int code = static_cast<int>(out.code);
+    for (const WmoCondition& condition : WMO_CONDITIONS) {
+        if (condition.code == code) {
+            out.data.setDescription(condition.description);
+            out.data.setIcon(std::string(condition.icon) + (out.isDay ? "d" : "n"));
+            break;
+        }
+    }
+    out.data.isValid = true;
+    return out.data;
+}
+
+WeatherData WeatherJsonParser::parseDom(const std::string& response) {
+    WeatherData data;
+    data.isValid = false;
+
+    nlohmann::json json;
+    try {
+        json = nlohmann::json::parse(response);
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing JSON response: " << e.what() << std::endl;
+        return data;
+    }
+
+    try {
+        if (json.contains("cod") && json["cod"] != 200) {
+            return data;
+        }
+
+        if (json.contains("id") && json["id"].is_number()) {
+            data.cityId = json["id"].get<int64_t>();
+        }
+        
+        if (json.contains("name")) {
+            data.setCity(json["name"].get<std::string>());
+        }
+
+        if (json.contains("sys") && json["sys"].contains("country")) {
+            data.setCountry(json["sys"]["country"].get<std::string>());
+        }
+
+        if (json.contains("weather") && json["weather"].is_array() && !json["weather"].empty()) {
+            data.setDescription(json["weather"][0].at("description").get<std::string>());
+            if (json["weather"][0].contains("icon")) {
+                data.setIcon(json["weather"][0]["icon"].get<std::string>());
+            }
+        }
+
+        // Read as double: nlohmann converts booleans to float but rejects them for double
+        if (json.contains("main")) {
+            if (json["main"].contains("temp")) {
+                data.temperature = static_cast<float>(json["main"]["temp"].get<double>());
+            }
+            if (json["main"].contains("feels_like")) {
+                data.feelsLike = static_cast<float>(json["main"]["feels_like"].get<double>());
+            }
+            if (json["main"].contains("humidity")) {
+                data.humidity = static_cast<float>(json["main"]["humidity"].get<double>());
+            }
+        }
+
+        if (json.contains("wind") && json["wind"].contains("speed")) {
+            data.windSpeed = static_cast<float>(json["wind"]["speed"].get<double>());
+        }
+
+        data.isValid = true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error parsing JSON: " << e.what() << std::endl;
+    }
+
+    return data;
+}
@@ -0,0 +1,134 @@
+#include "WeatherProvider.h"
+#include "WeatherJsonParser.h"
+#include <sstream>
+#include <iomanip>
+#include <cctype>
+
+namespace {
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+WeatherQuery WeatherQuery::byCity(const std::string& cityName) {
+    WeatherQuery query;
+    query.kind = Kind::CITY;
+    query.city = cityName;
+    return query;
+}
+
+WeatherQuery WeatherQuery::byCoordinates(double latitude, double longitude) {
+    WeatherQuery query;
+    query.kind = Kind::COORDINATES;
+    query.latitude = latitude;
+    query.longitude = longitude;
+    return query;
+}
+
+WeatherQuery WeatherQuery::byId(long cityId) {
+    WeatherQuery query;
+    query.kind = Kind::CITY_ID;
+    query.cityId = cityId;
+    return query;
+}
+
+std::string WeatherProvider::urlEncode(const std::string& value) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for (char c : value) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (std::isalnum(byte) || byte == '-' || byte == '_' || byte == '.' || byte == '~' || byte == ',') {
+            encoded += c;
+        } else {
+            encoded += '%';
+            encoded += HEX[byte >> 4];
+            encoded += HEX[byte & 0x0F];
+        }
+    }
+    return encoded;
+}
+
+bool WeatherProvider::matches(std::string_view alias) const {
+    return equalsIgnoreCase(alias, name());
+}
+
+std::shared_ptr<WeatherProvider> WeatherProvider::create(std::string_view name, const std::string& baseUrl) {
+    OpenWeatherMapProvider openWeatherMap;
+    if (openWeatherMap.matches(name)) {
+        return std::make_shared<OpenWeatherMapProvider>(baseUrl.empty() ? OpenWeatherMapProvider::DEFAULT_URL : baseUrl);
+    }
+    OpenMeteoProvider openMeteo;
+    if (openMeteo.matches(name)) {
+        return std::make_shared<OpenMeteoProvider>(baseUrl.empty() ? OpenMeteoProvider::DEFAULT_URL : baseUrl);
+    }
+    return nullptr;
+}
+
+bool OpenWeatherMapProvider::matches(std::string_view alias) const {
+    return WeatherProvider::matches(alias) || equalsIgnoreCase(alias, "owm");
+}
+
+std::string OpenWeatherMapProvider::buildUrl(const WeatherQuery& query, const std::string& apiKey) const {
+    const std::string& baseUrl = baseUrl_.get();
+    std::ostringstream url;
+    if (query.kind == WeatherQuery::Kind::COORDINATES) {
+        url << baseUrl << "/weather?lat="
+            << query.latitude
+            << "&lon=" << query.longitude;
+    } else if (query.kind == WeatherQuery::Kind::CITY_ID) {
+        url << baseUrl << "/weather?id="
+            << query.cityId;
+    } else {
+        url << baseUrl << "/weather?q="
+            << urlEncode(query.city);
+    }
+    url << "&appid=" << apiKey
+        << "&units=metric";
+    return url.str();
+}
+
+WeatherData OpenWeatherMapProvider::parse(std::string_view response, const WeatherQuery&) const {
+    return WeatherJsonParser::parse(response);
+}
+
+bool OpenMeteoProvider::matches(std::string_view alias) const {
+    return WeatherProvider::matches(alias) || equalsIgnoreCase(alias, "openmeteo");
+}
+
+std::string OpenMeteoProvider::buildUrl(const WeatherQuery& query, const std::string&) const {
+    const std::string& baseUrl = baseUrl_.get();
+    std::ostringstream url;
+    url << std::fixed << std::setprecision(4)
+        << baseUrl << "/forecast?latitude=" << query.latitude
+        << "&longitude=" << query.longitude
+        << "&current=temperature_2m,relative_humidity_2m,apparent_temperature,wind_speed_10m,weather_code,is_day"
+        << "&wind_speed_unit=ms";
+    return url.str();
+}
+
+WeatherData OpenMeteoProvider::parse(std::string_view response, const WeatherQuery& query) const {
+    WeatherData data = WeatherJsonParser::parseOpenMeteo(response);
+    if (!data.isValid) {
+        return data;
+    }
+    // The response only echoes the grid point, so the location comes from the query
+    data.cityId = query.kind == WeatherQuery::Kind::CITY_ID ? query.cityId : 0;
+    if (!query.city.empty()) {
+        data.setCity(query.city);
+        data.setCountry(query.country);
+    } else {
+        std::ostringstream place;
+        place << std::fixed << std::setprecision(2) << query.latitude << ", " << query.longitude;
+        data.setCity(place.str());
+    }
+    return data;
+}
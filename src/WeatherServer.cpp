@@ -0,0 +1,481 @@
+#include "WeatherServer.h"
+#include "WeatherBot.h"
+#include "NotificationManager.h"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#endif
+
+namespace {
+const size_t MAX_LINE_LENGTH = 64 * 1024;
+const char* PROMPT = "\nWeatherBot> ";
+// Per-session history is kept short; sessions can number in the thousands
+const size_t SESSION_NOTIFICATION_CAPACITY = 32;
+// Alerts beyond this wait for a session that is not reading are dropped
+const size_t MAX_PENDING_ALERT_BYTES = 16 * 1024;
+}
+
+struct WeatherServer::Session {
+    int fd;
+    std::string userId;  // Owner of the alert rules the session adds
+    std::string input;
+    std::deque<std::string> pending;
+    bool busy = false;
+    bool closed = false;
+    std::ostringstream output;
+    NotificationManager notifications;
+    std::string alerts;  // Pushed alerts not yet sent; guarded by the server mutex
+
+    Session(int socketFd, const std::string& id)
+        : fd(socketFd), userId(id), notifications(output, NotificationOutput::SYNCHRONOUS, SESSION_NOTIFICATION_CAPACITY) {}
+};
+
+class WeatherServer::SessionAlertSink : public AlertSink {
+public:
+    explicit SessionAlertSink(WeatherServer& server) : server_(server) {}
+
+    void deliver(const std::vector<AlertMessage>& messages) override { server_.pushAlerts(messages); }
+
+private:
+    WeatherServer& server_;
+};
+
+WeatherServer::WeatherServer(const std::string& apiKey, const WeatherServerConfig& config,
+                             std::shared_ptr<WeatherServiceContext> context)
+    : apiKey_(apiKey), config_(config), context_(std::move(context)),
+      consoleNotifications_(std::cout, NotificationOutput::BACKGROUND),
+      listenFd_(-1), wakePipe_{-1, -1}, running_(false), nextSessionId_(1), busySessions_(0) {
+    if (!context_) {
+        context_ = std::make_shared<WeatherServiceContext>();
+    }
+    
+    scheduler_ = std::make_unique<PrefetchScheduler>(apiKey_, context_);
+    if (config_.workerCount == 0) {
+        config_.workerCount = 1;
+    }
+}
+
+#ifdef _WIN32
+
+WeatherServer::~WeatherServer() {
+}
+
+bool WeatherServer::start() {
+    std::cerr << "Error: Server mode is not supported on this platform" << std::endl;
+    return false;
+}
+
+void WeatherServer::run() {
+}
+
+void WeatherServer::stop() {
+}
+
+#else
+
+WeatherServer::~WeatherServer() {
+    stop();
+    // Both sinks reach into this server
+    if (consoleAlerts_) {
+        context_->dispatcher->removeSink(consoleAlerts_.get());
+        context_->dispatcher->removeSink(sessionAlerts_.get());
+    }
+    scheduler_->stop();
+    jobAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    for (auto& entry : sessions_) {
+        close(entry.first);
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        if (!config_.unixSocketPath.empty()) {
+            unlink(config_.unixSocketPath.c_str());
+        }
+    }
+    for (int fd : wakePipe_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool WeatherServer::openListener() {
+    if (!config_.unixSocketPath.empty()) {
+        sockaddr_un addr{};
+        if (config_.unixSocketPath.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Error: Socket path is too long: " << config_.unixSocketPath << std::endl;
+            return false;
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, config_.unixSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(config_.unixSocketPath.c_str());
+
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cerr << "Error: Failed to bind " << config_.unixSocketPath << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(config_.port));
+        if (inet_pton(AF_INET, config_.host.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "Error: Invalid listen address: " << config_.host << std::endl;
+            return false;
+        }
+
+        listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listenFd_ >= 0) {
+            setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listenFd_ < 0 || bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            std::cerr << "Error: Failed to bind " << config_.host << ":" << config_.port << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    if (listen(listenFd_, SOMAXCONN) != 0) {
+        std::cerr << "Error: Failed to listen: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    fcntl(listenFd_, F_SETFL, fcntl(listenFd_, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+bool WeatherServer::start() {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (pipe(wakePipe_) != 0) {
+        std::cerr << "Error: Failed to create wake pipe" << std::endl;
+        return false;
+    }
+    fcntl(wakePipe_[0], F_SETFL, fcntl(wakePipe_[0], F_GETFL) | O_NONBLOCK);
+
+    if (!openListener()) {
+        return false;
+    }
+
+    // The console hears every alert everyone's rules raise; sessions subscribe
+    // to the cities they watch
+    consoleAlerts_ = std::make_shared<ConsoleAlertSink>(consoleNotifications_);
+    sessionAlerts_ = std::make_shared<SessionAlertSink>(*this);
+    context_->dispatcher->addSubscriber("console", consoleAlerts_);
+    context_->dispatcher->subscribeAll("console");
+
+    running_ = true;
+    for (size_t i = 0; i < config_.workerCount; ++i) {
+        workers_.emplace_back(&WeatherServer::workerLoop, this);
+    }
+
+    if (config_.unixSocketPath.empty()) {
+        std::cout << "Weather Bot server listening on " << config_.host << ":" << config_.port;
+    } else {
+        std::cout << "Weather Bot server listening on " << config_.unixSocketPath;
+    }
+    std::cout << " with " << config_.workerCount << " workers" << std::endl;
+    return true;
+}
+
+void WeatherServer::stop() {
+    // Only touches the atomic flag and the wake pipe, so it is safe from a signal handler
+    running_ = false;
+    wake();
+}
+
+void WeatherServer::wake() {
+    if (wakePipe_[1] >= 0) {
+        char byte = 1;
+        ssize_t ignored = write(wakePipe_[1], &byte, 1);
+        (void)ignored;
+    }
+}
+
+bool WeatherServer::sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void WeatherServer::run() {
+    std::vector<pollfd> fds;
+    std::vector<std::shared_ptr<Session>> polled;
+
+    while (running_) {
+        fds.clear();
+        polled.clear();
+        fds.push_back({listenFd_, POLLIN, 0});
+        fds.push_back({wakePipe_[0], POLLIN, 0});
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = sessions_.begin(); it != sessions_.end();) {
+                auto session = (it++)->second;
+                if (session->closed) {
+                    if (!session->busy) {
+                        closeSessionLocked(session);
+                    }
+                    continue;
+                }
+                fds.push_back({session->fd, POLLIN, 0});
+                polled.push_back(session);
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char buffer[64];
+            while (read(wakePipe_[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            acceptSessions();
+        }
+
+        for (size_t i = 0; i < polled.size(); ++i) {
+            if (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) {
+                readSession(polled[i]);
+            }
+        }
+    }
+
+    running_ = false;
+    jobAvailable_.notify_all();
+}
+
+void WeatherServer::acceptSessions() {
+    while (true) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sessions_.size() >= config_.maxSessions) {
+            sendAll(fd, "Server is busy. Please try again later.\n");
+            close(fd);
+            continue;
+        }
+
+        auto session = std::make_shared<Session>(fd, "session-" + std::to_string(nextSessionId_++));
+        sessions_[fd] = session;
+        sessionsByUser_[session->userId] = session;
+        context_->dispatcher->addSubscriber(session->userId, sessionAlerts_);
+        sendAll(fd, std::string("Connected to Weather Bot. Type 'help' to see available commands.") + PROMPT);
+    }
+}
+
+void WeatherServer::readSession(const std::shared_ptr<Session>& session) {
+    char buffer[4096];
+    ssize_t n = recv(session->fd, buffer, sizeof(buffer), 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (n <= 0) {
+        if (n < 0 && errno == EINTR) {
+            return;
+        }
+        session->closed = true;
+        if (!session->busy) {
+            closeSessionLocked(session);
+        }
+        return;
+    }
+
+    session->input.append(buffer, static_cast<size_t>(n));
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = session->input.find('\n', start)) != std::string::npos) {
+        std::string line = session->input.substr(start, newline - start);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        session->pending.push_back(std::move(line));
+        start = newline + 1;
+    }
+    session->input.erase(0, start);
+
+    if (session->input.size() > MAX_LINE_LENGTH) {
+        session->closed = true;
+        if (!session->busy) {
+            closeSessionLocked(session);
+        }
+        return;
+    }
+
+    dispatchLocked(session);
+}
+
+void WeatherServer::dispatchLocked(const std::shared_ptr<Session>& session) {
+    // Commands within one session run strictly in order, one at a time
+    if (session->busy || session->closed || session->pending.empty()) {
+        return;
+    }
+
+    session->busy = true;
+    ++busySessions_;
+    jobs_.push_back(Job{session, std::move(session->pending.front())});
+    session->pending.pop_front();
+    jobAvailable_.notify_one();
+}
+
+void WeatherServer::closeSessionLocked(const std::shared_ptr<Session>& session) {
+    context_->alerts->removeRulesFor(session->userId);
+    context_->dispatcher->removeSubscriber(session->userId);
+    sessionsByUser_.erase(session->userId);
+    close(session->fd);
+    sessions_.erase(session->fd);
+}
+
+void WeatherServer::workerLoop() {
+    WeatherService weatherService(apiKey_, context_);
+    PrefetchScheduler* scheduler = scheduler_.get();
+    weatherService.setRevalidator([scheduler](const WeatherQuery& query) {
+        scheduler->revalidate(query);
+    });
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Commands still suspended on the loop reference this worker's service, so
+            // stay until every session has had its reply delivered
+            jobAvailable_.wait(lock, [this] { return !jobs_.empty() || (!running_ && busySessions_ == 0); });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        if (job.deliver) {
+            deliver(job.session, job.keepOpen);
+        } else {
+            startDetached(runCommand(std::move(job), weatherService));
+        }
+    }
+}
+
+Task<void> WeatherServer::runCommand(Job job, WeatherService& weatherService) {
+    Session& session = *job.session;
+    bool keepOpen;
+    {
+        WeatherBot bot(weatherService, session.notifications, session.output, scheduler_.get(), session.userId);
+        Task<void> command = bot.processCommandAsync(std::move(job.line));
+        co_await command;
+        keepOpen = bot.isRunning();
+    }
+    if (keepOpen) {
+        session.output << PROMPT;
+    }
+
+    if (!context_->loop->isLoopThread()) {
+        // Finished without suspending, so this is still the worker that started it
+        deliver(job.session, keepOpen);
+        co_return;
+    }
+    // Sending may block on a slow client, which must not stall the loop
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(Job{job.session, "", true, keepOpen});
+    jobAvailable_.notify_one();
+}
+
+void WeatherServer::deliver(const std::shared_ptr<Session>& session, bool keepOpen) {
+    std::string reply = session->output.str();
+    session->output.str("");
+    session->output.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!session->alerts.empty()) {
+            // Alerts pushed while a command ran go out ahead of its reply; sent
+            // on their own, they are followed by a fresh prompt
+            reply = "\n" + session->alerts + (reply.empty() ? std::string(PROMPT) : reply);
+            session->alerts.clear();
+        }
+    }
+    bool delivered = sendAll(session->fd, reply);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    session->busy = false;
+    --busySessions_;
+    if (!keepOpen || !delivered) {
+        session->closed = true;
+    }
+    if (session->closed) {
+        // Let the I/O thread close the socket once it is no longer polled
+        wake();
+    } else {
+        dispatchLocked(session);
+        pushAlertsLocked(session);
+    }
+    if (!running_ && busySessions_ == 0) {
+        jobAvailable_.notify_all();
+    }
+}
+
+void WeatherServer::pushAlerts(const std::vector<AlertMessage>& messages) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<Session> session;
+    std::string_view user;
+    for (const AlertMessage& message : messages) {
+        // A subscriber's messages arrive together
+        if (message.subscriber != user) {
+            if (session) {
+                pushAlertsLocked(session);
+            }
+            user = message.subscriber;
+            auto found = sessionsByUser_.find(std::string(user));
+            session = found == sessionsByUser_.end() ? nullptr : found->second;
+        }
+        if (session && !session->closed && session->alerts.size() < MAX_PENDING_ALERT_BYTES) {
+            session->alerts.append("[!] Weather Alert for ").append(message.city).append(": ").append(message.condition).append("\n");
+        }
+    }
+    if (session) {
+        pushAlertsLocked(session);
+    }
+}
+
+void WeatherServer::pushAlertsLocked(const std::shared_ptr<Session>& session) {
+    // A session running a command gets its alerts with the reply
+    if (!running_ || session->busy || session->closed || session->alerts.empty()) {
+        return;
+    }
+    session->busy = true;
+    ++busySessions_;
+    jobs_.push_back(Job{session, "", true, true});
+    jobAvailable_.notify_one();
+}
+
+#endif
@@ -1,172 +1,1268 @@
 #include "WeatherService.h"
+#include "WeatherJsonParser.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <algorithm>
+#include <ctime>
+#include <cctype>
+#include <deque>
+#include <thread>
+#include <mutex>
 
-WeatherService::WeatherService(const std::string& apiKey) : apiKey_(apiKey), curl_(nullptr) {
+namespace {
+// The group endpoint accepts at most this many city IDs per request
+const size_t GROUP_MAX_IDS = 20;
+// Coordinates this close to a known city are answered as that city
+const double SNAP_DISTANCE_KM = 10.0;
+// Upstream latency samples needed before the hedge delay follows the observed p95
+const uint64_t MIN_HEDGE_SAMPLES = 20;
+// Current-weather responses are well under this, so one reservation holds a whole body
+const size_t RESPONSE_RESERVE_BYTES = 2048;
+const size_t REQUEST_ARENA_BYTES = 4096;
+
+// Backs the response bodies of one request, retries and hedges included. A
+// typical response fits in the inline buffer, and everything is released at
+// once when the request is done.
+class RequestArena {
+public:
+    RequestArena() : resource_(buffer_, sizeof(buffer_)) {}
+    std::pmr::memory_resource* get() { return &resource_; }
+
+private:
+    alignas(std::max_align_t) char buffer_[REQUEST_ARENA_BYTES];
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+const long HTTP_TOO_MANY_REQUESTS = 429;
+
+// Services on a shared context may start together; one sets up its default providers
+std::mutex defaultProvidersMutex;
+
+// Seconds from a 429's Retry-After header (either form), or zero without one
+std::chrono::seconds retryAfter(CURL* handle) {
+    curl_off_t seconds = 0;
+    curl_easy_getinfo(handle, CURLINFO_RETRY_AFTER, &seconds);
+    return std::chrono::seconds(std::max<curl_off_t>(seconds, 0));
+}
+
+// Transport failures worth another attempt; anything else would fail the same way again
+bool isRetryable(CURLcode result) {
+    switch (result) {
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_GOT_NOTHING:
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_PARTIAL_FILE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Columns between the side borders of the forecast and history boxes
+const size_t SUMMARY_BOX_INNER_WIDTH = 52;
+const char* const SUMMARY_BOX_BORDER = "════════════════════════════════════════════════════";
+
+// Appends a box row, padding the text by display columns or cutting it short
+// with an ellipsis. One space is always kept on either side of the text.
+void appendBoxRow(std::string& out, std::string_view text) {
+    size_t columns = SUMMARY_BOX_INNER_WIDTH - 2;
+    size_t width = ReportRenderer::displayWidth(text);
+    out += "║ ";
+    if (width > columns) {
+        text = text.substr(0, ReportRenderer::fitWidth(text, columns - 1));
+        width = ReportRenderer::displayWidth(text) + 1;
+        out += text;
+        out += "…";
+    } else {
+        out += text;
+    }
+    out.append(columns - width + 1, ' ');
+    out += "║\n";
+}
+
+}
+
+struct WeatherService::Transfer {
+    explicit Transfer(std::pmr::memory_resource* arena) : response(arena) {}
+
+    size_t index = 0;
+    size_t attempts = 0;  // On the current provider
+    std::string key;
+    WeatherQuery query;
+    std::vector<size_t> route;  // Providers to try, in order
+    size_t hop = 0;             // Position in route
+    std::string url;
+    std::pmr::string response;
+    CURL* handle = nullptr;
+    EventLoop::Clock::time_point started;
+};
+
+// Both sides of a provider race, on the loop thread
+struct WeatherService::ProviderRace {
+    std::array<size_t, 2> providers{};
+    std::array<EventLoop::CancelToken, 2> cancel;
+    std::array<RequestControl, 2> control;
+    long winner = -1;
+};
+
+WeatherServiceContext::WeatherServiceContext()
+    : cache(std::make_shared<WeatherCache>()),
+      coalescer(std::make_shared<RequestCoalescer>()),
+      metrics(std::make_shared<Metrics>()),
+      forecasts(std::make_shared<ForecastStore>()),
+      alerts(std::make_shared<AlertEngine>()),
+      dispatcher(std::make_shared<AlertDispatcher>()),
+      rateLimiter(std::make_shared<RateLimiter>()),
+      connections(std::make_shared<ConnectionManager>()),
+      config(std::make_shared<ConfigStore>()),
+      loop(std::make_shared<EventLoop>()) {
+    alerts->addDefaultRules(config->get().alerts);
+    for (auto& endpointBreaker : breakers) {
+        endpointBreaker = std::make_shared<CircuitBreaker>();
+    }
+    // The store belongs to this context, so it never calls back after it is gone
+    config->setListener([this](const RuntimeConfig& previous, const RuntimeConfig& current) {
+        applyConfig(previous, current);
+    });
+}
+
+WeatherServiceContext::~WeatherServiceContext() {
+    // The loop thread keeps the loop itself alive, so it has to be told to finish
+    loop->stop();
+}
+
+void WeatherServiceContext::applyConfig(const RuntimeConfig& previous, const RuntimeConfig& current) {
+    if (current.cache != previous.cache) {
+        cache->setConfig(current.cache);
+    }
+    if (current.rateLimit != previous.rateLimit) {
+        rateLimiter->reconfigure(current.rateLimit, *loop);
+    }
+    if (current.alerts != previous.alerts) {
+        alerts->setDefaultThresholds(current.alerts);
+    }
+    if (current.baseUrl != previous.baseUrl && providers) {
+        for (size_t i = 0; i < providers->size(); ++i) {
+            WeatherProvider& provider = providers->provider(i);
+            if (provider.matches("openweathermap")) {
+                provider.setBaseUrl(current.baseUrl);
+            }
+        }
+    }
+    // Request policy, concurrency, API key and base URL are read per request
+}
+
+WeatherService::WeatherService(const std::string& apiKey, std::shared_ptr<WeatherServiceContext> context)
+    : apiKey_(apiKey), multi_(nullptr),
+      context_(std::move(context)), priority_(RequestPriority::INTERACTIVE), random_(std::random_device{}()) {
+    if (!context_) {
+        context_ = std::make_shared<WeatherServiceContext>();
+    }
+    cache_ = context_->cache.get();
+    {
+        // Deferred to here so a baseUrl configured after constructing the context applies
+        std::lock_guard<std::mutex> lock(defaultProvidersMutex);
+        if (!context_->providers) {
+            auto providers = std::make_shared<ProviderRouter>();
+            providers->add(std::make_shared<OpenWeatherMapProvider>(context_->config->get().baseUrl),
+                           context_->breakers[static_cast<size_t>(Endpoint::WEATHER)]);
+            context_->providers = providers;
+        }
+    }
     initializeCurl();
 }
 
 WeatherService::~WeatherService() {
-    if (curl_) {
-        curl_easy_cleanup(curl_);
+    for (CURL* handle : handlePool_) {
+        curl_easy_cleanup(handle);
+    }
+    if (multi_) {
+        curl_multi_cleanup(multi_);
     }
 }
 
 void WeatherService::initializeCurl() {
     curl_global_init(CURL_GLOBAL_DEFAULT);
-    curl_ = curl_easy_init();
-    if (!curl_) {
-        std::cerr << "Error: Failed to initialize CURL" << std::endl;
+}
+
+bool WeatherService::ensureMulti() {
+    if (!multi_) {
+        multi_ = curl_multi_init();
+        if (!multi_) {
+            std::cerr << "Error: Failed to initialize CURL multi handle" << std::endl;
+            return false;
+        }
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
     }
+    return true;
+}
+
+void WeatherService::setRevalidator(RevalidateCallback revalidate) {
+    revalidate_ = std::move(revalidate);
 }
 
-size_t WeatherService::WriteCallback(void* contents, size_t size, size_t nmemb, std::string* data) {
+size_t WeatherService::WriteCallback(void* contents, size_t size, size_t nmemb, std::pmr::string* data) {
     size_t totalSize = size * nmemb;
     data->append((char*)contents, totalSize);
     return totalSize;
 }
 
-std::string WeatherService::performRequest(const std::string& url) {
-    if (!curl_) {
-        return "";
+void WeatherService::configureHandle(CURL* handle, const std::string& url, std::pmr::string* response,
+                                     std::chrono::milliseconds timeout) {
+    timeout = std::max(timeout, std::chrono::milliseconds(1));
+    curl_easy_setopt(handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, static_cast<long>(timeout.count()));
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS,
+                     static_cast<long>(std::min(timeout, context_->config->get().requestPolicy.connectTimeout).count()));
+    // Timeouts must not rely on signals when several threads run transfers
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    context_->connections->prepare(handle, url);
+}
+
+std::chrono::milliseconds WeatherService::hedgeDelay() const {
+    const RequestPolicy& policy = context_->config->get().requestPolicy;
+    const Histogram& upstream = context_->metrics->getHistogram(Stage::UPSTREAM);
+    if (upstream.getCount() < MIN_HEDGE_SAMPLES) {
+        return policy.maxHedgeDelay;
+    }
+    std::chrono::milliseconds p95(static_cast<long long>(upstream.quantile(0.95) * 1000.0));
+    return std::clamp(p95, policy.minHedgeDelay, policy.maxHedgeDelay);
+}
+
+template <typename T>
+T WeatherService::blockOn(Task<T> task) {
+    if (context_->loop->isLoopThread()) {
+        // Blocking here would stall the loop that has to complete the request
+        std::cerr << "Error: Blocking lookup issued on the event loop thread" << std::endl;
+        return T();
     }
+    return syncWait(std::move(task));
+}
+
+void WeatherService::performRequest(const std::string& url, Endpoint endpoint, std::pmr::string& response) {
+    blockOn(performRequestAsync(url, context_->breaker(endpoint), response));
+}
+
+Task<void> WeatherService::performRequestAsync(std::string url, CircuitBreaker& breaker, std::pmr::string& response,
+                                               RequestControl* control) {
+    using Clock = EventLoop::Clock;
+    using std::chrono::milliseconds;
     
-    std::string response;
-    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl_, CURLOPT_SSL_VERIFYPEER, 0L);
+    EventLoop& loop = *context_->loop;
+    co_await loop.schedule();
     
-    CURLcode res = curl_easy_perform(curl_);
+    RequestControl defaults;
+    RequestControl& request = control ? *control : defaults;
+    EventLoop::CancelToken* cancel = request.cancel;
+    auto isCancelled = [cancel] { return cancel && cancel->isCancelled(); };
+    request.outcome = RequestOutcome::NOT_SENT;
+    response.clear();
     
-    if (res != CURLE_OK) {
-        std::cerr << "CURL error: " << curl_easy_strerror(res) << std::endl;
-        return "";
+    Metrics& metrics = *context_->metrics;
+    if (!breaker.allowRequest()) {
+        metrics.recordEvent(UpstreamEvent::BREAKER_REJECTED);
+        co_return;
+    }
+    // Spare-quota requests never queue; the rest wait for a token at this service's priority
+    RateLimiter& limiter = *context_->rateLimiter;
+    bool admitted = false;
+    if (request.spareQuotaOnly) {
+        admitted = limiter.tryAcquire(RequestPriority::BATCH);
+    } else {
+        Task<bool> admission = limiter.acquire(loop, priority_, Clock::time_point::max(), cancel);
+        admitted = co_await admission;
+    }
+    if (admitted && isCancelled()) {
+        limiter.release();
+        admitted = false;
+    }
+    if (!admitted) {
+        breaker.recordCancelled();
+        if (isCancelled()) {
+            request.outcome = RequestOutcome::CANCELLED;
+        } else if (!request.spareQuotaOnly) {
+            metrics.recordEvent(UpstreamEvent::RATE_LIMITED);
+        }
+        co_return;
     }
     
-    return response;
-}
+    struct Attempt {
+        explicit Attempt(std::pmr::memory_resource* arena) : response(arena) {}
 
-WeatherData WeatherService::parseWeatherJson(const nlohmann::json& json) {
-    WeatherData data;
-    data.isValid = false;
+        CURL* handle = nullptr;
+        std::pmr::string response;
+        bool hedge = false;
+        bool done = false;
+        CURLcode result = CURLE_OK;
+    };
+    
+    const RequestPolicy& policy = context_->config->get().requestPolicy;
+    const Clock::time_point never = Clock::time_point::max();
+    Clock::time_point started = Clock::now();
+    Clock::time_point deadline = started + policy.deadline;
+    Clock::time_point hedgeAt = never;
+    Clock::time_point retryAt = never;
+    // A deque keeps each attempt (and its response buffer) in place as attempts are added
+    std::pmr::memory_resource* arena = response.get_allocator().resource();
+    std::pmr::deque<Attempt> attempts(arena);
+    EventLoop::Wakeup wakeup(loop);
+    EventLoop::Wakeup* watched = cancel ? cancel->watch(&wakeup) : nullptr;
+    size_t active = 0;
+    size_t failures = 0;
+    bool succeeded = false;
+    bool permanent = false;
+    bool throttled = false;
     
-    try {
-        if (json.contains("cod") && json["cod"] != 200) {
-            return data;
+    auto startAttempt = [&](bool hedge) {
+        auto remaining = std::chrono::duration_cast<milliseconds>(deadline - Clock::now());
+        CURL* handle = remaining.count() > 0 ? loop.acquireHandle() : nullptr;
+        if (!handle) {
+            return false;
         }
-        
-        if (json.contains("name")) {
-            data.city = json["name"];
+        attempts.emplace_back(arena);
+        Attempt& attempt = attempts.back();
+        attempt.hedge = hedge;
+        attempt.response.reserve(RESPONSE_RESERVE_BYTES);
+        configureHandle(handle, url, &attempt.response, std::min(policy.attemptTimeout, remaining));
+        bool added = loop.addTransfer(handle, [&attempt, &wakeup, &metrics](CURL* done, CURLcode result) {
+            metrics.recordTransfer(done, result);
+            attempt.done = true;
+            attempt.result = result;
+            wakeup.notify();
+        });
+        if (!added) {
+            loop.releaseHandle(handle);
+            attempts.pop_back();
+            return false;
         }
-        
-        if (json.contains("sys") && json["sys"].contains("country")) {
-            data.country = json["sys"]["country"];
+        attempt.handle = handle;
+        ++active;
+        return true;
+    };
+    
+    if (startAttempt(false)) {
+        hedgeAt = Clock::now() + hedgeDelay();
+    } else {
+        limiter.release();
+    }
+    
+    while ((active > 0 || retryAt != never) && !isCancelled()) {
+        // Sleep until an attempt finishes or the next hedge, retry or deadline is due
+        Clock::time_point next = active > 0 ? (attempts.size() < policy.maxAttempts ? hedgeAt : never) : retryAt;
+        co_await wakeup.waitUntil(std::min(deadline, next));
+        if (isCancelled()) {
+            break;
         }
         
-        if (json.contains("weather") && json["weather"].is_array() && !json["weather"].empty()) {
-            data.description = json["weather"][0]["description"];
-            if (json["weather"][0].contains("icon")) {
-                data.icon = json["weather"][0]["icon"];
+        for (Attempt& attempt : attempts) {
+            if (!attempt.done || !attempt.handle) {
+                continue;
+            }
+            long status = 0;
+            curl_easy_getinfo(attempt.handle, CURLINFO_RESPONSE_CODE, &status);
+            throttled = attempt.result == CURLE_OK && status == HTTP_TOO_MANY_REQUESTS;
+            if (throttled) {
+                // The quota is shared, so every request backs off, not just this one
+                limiter.onThrottled(retryAfter(attempt.handle));
+                metrics.recordEvent(UpstreamEvent::THROTTLED);
             }
+            loop.releaseHandle(attempt.handle);
+            attempt.handle = nullptr;
+            --active;
+            
+            // Any other answer below 500 is final, including "city not found"
+            if (attempt.result == CURLE_OK && status < 500 && !throttled) {
+                succeeded = true;
+                limiter.onSuccess();
+                response = std::move(attempt.response);
+                if (attempt.hedge) {
+                    metrics.recordEvent(UpstreamEvent::HEDGE_WON);
+                }
+                break;
+            }
+            
+            if (attempt.result != CURLE_OK) {
+                std::cerr << "CURL error: " << curl_easy_strerror(attempt.result) << std::endl;
+                permanent = permanent || !isRetryable(attempt.result);
+            } else {
+                std::cerr << "Upstream error: HTTP " << status << std::endl;
+            }
+            ++failures;
+            
+            // Back off with full jitter before retrying, unless another attempt is still running.
+            // After a 429 the limiter holds the retry back until Retry-After has passed.
+            if (active == 0 && !permanent && attempts.size() < policy.maxAttempts && throttled) {
+                retryAt = Clock::now();
+            } else if (active == 0 && !permanent && attempts.size() < policy.maxAttempts) {
+                milliseconds cap = std::min<milliseconds>(policy.backoffMax,
+                                                          policy.backoffBase * (1LL << std::min<size_t>(failures - 1, 16)));
+                std::uniform_int_distribution<long long> jitter(0, cap.count());
+                Clock::time_point at = Clock::now() + milliseconds(jitter(random_));
+                retryAt = at < deadline ? at : never;
+            }
+        }
+        if (succeeded) {
+            break;
         }
         
-        if (json.contains("main")) {
-            if (json["main"].contains("temp")) {
-                data.temperature = json["main"]["temp"];
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            std::cerr << "Upstream request timed out after " << policy.deadline.count() << " ms" << std::endl;
+            break;
+        }
+        if (active > 0 && now >= hedgeAt && attempts.size() < policy.maxAttempts) {
+            // The first attempt is slower than usual: race a second one against it, unless
+            // every connection is busy and the hedge would only queue behind the first.
+            // Hedges only spend spare quota, never a token a queued request is waiting for.
+            hedgeAt = never;
+            if (!loop.isSaturated() && limiter.tryAcquire(RequestPriority::BATCH)) {
+                if (startAttempt(true)) {
+                    metrics.recordEvent(UpstreamEvent::HEDGE);
+                } else {
+                    limiter.release();
+                }
             }
-            if (json["main"].contains("feels_like")) {
-                data.feelsLike = json["main"]["feels_like"];
+        } else if (active == 0 && now >= retryAt) {
+            // Retries spend quota too; waiting for the token counts against the deadline
+            retryAt = never;
+            bool granted = false;
+            if (request.spareQuotaOnly) {
+                granted = limiter.tryAcquire(RequestPriority::BATCH);
+            } else {
+                Task<bool> token = limiter.acquire(loop, priority_, deadline, cancel);
+                granted = co_await token;
             }
-            if (json["main"].contains("humidity")) {
-                data.humidity = json["main"]["humidity"];
+            if (granted && isCancelled()) {
+                limiter.release();
+            } else if (!granted) {
+                if (!isCancelled() && !request.spareQuotaOnly) {
+                    metrics.recordEvent(UpstreamEvent::RATE_LIMITED);
+                }
+            } else if (startAttempt(false)) {
+                metrics.recordEvent(UpstreamEvent::RETRY);
+                hedgeAt = Clock::now() + hedgeDelay();
+            } else {
+                limiter.release();
             }
         }
-        
-        if (json.contains("wind") && json["wind"].contains("speed")) {
-            data.windSpeed = json["wind"]["speed"];
+    }
+    
+    // Abandon attempts that lost the race or ran out of time
+    for (Attempt& attempt : attempts) {
+        if (attempt.handle) {
+            if (!attempt.done) {
+                loop.removeTransfer(attempt.handle);
+            }
+            loop.releaseHandle(attempt.handle);
+            attempt.handle = nullptr;
         }
-        
-        data.isValid = true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing JSON: " << e.what() << std::endl;
+    }
+    if (cancel) {
+        cancel->watch(watched);
     }
     
-    return data;
+    request.elapsed = Clock::now() - started;
+    // A 429 means the endpoint is up and only asking us to slow down
+    if (succeeded || throttled) {
+        breaker.recordSuccess();
+    } else if (isCancelled() && failures == 0) {
+        breaker.recordCancelled();
+    } else {
+        breaker.recordFailure();
+    }
+    if (succeeded) {
+        request.outcome = RequestOutcome::SUCCEEDED;
+    } else {
+        request.outcome = isCancelled() ? RequestOutcome::CANCELLED : RequestOutcome::FAILED;
+    }
 }
 
-WeatherData WeatherService::getWeatherByCity(const std::string& cityName) {
-    std::ostringstream url;
-    url << "http://api.openweathermap.org/data/2.5/weather?q=" 
-        << cityName 
-        << "&appid=" << apiKey_ 
-        << "&units=metric";
-    
-    std::string response = performRequest(url.str());
-    
+WeatherData WeatherService::parseResponse(const WeatherProvider& provider, std::string_view response,
+                                          const WeatherQuery& query) {
     if (response.empty()) {
         WeatherData data;
         data.isValid = false;
         return data;
     }
     
-    try {
-        nlohmann::json json = nlohmann::json::parse(response);
-        return parseWeatherJson(json);
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing JSON response: " << e.what() << std::endl;
-        WeatherData data;
-        data.isValid = false;
-        return data;
+    StageTimer timer(*context_->metrics, Stage::PARSE);
+    return provider.parse(response, query);
+}
+
+const std::string& WeatherService::currentApiKey() const {
+    const std::string& rotated = context_->config->get().apiKey;
+    return rotated.empty() ? apiKey_ : rotated;
+}
+
+std::string WeatherService::buildGroupUrl(const std::vector<long>& cityIds) const {
+    std::ostringstream url;
+    url << context_->config->get().baseUrl << "/group?id=";
+    for (size_t i = 0; i < cityIds.size(); ++i) {
+        url << (i > 0 ? "," : "") << cityIds[i];
     }
+    url << "&appid=" << currentApiKey()
+        << "&units=metric";
+    return url.str();
 }
 
-WeatherData WeatherService::getWeatherByCoordinates(double latitude, double longitude) {
+std::string WeatherService::buildForecastUrl(const WeatherQuery& query) const {
+    const std::string& baseUrl = context_->config->get().baseUrl;
     std::ostringstream url;
-    url << "http://api.openweathermap.org/data/2.5/weather?lat=" 
-        << latitude 
-        << "&lon=" << longitude
-        << "&appid=" << apiKey_ 
+    if (query.kind == WeatherQuery::Kind::CITY_ID) {
+        url << baseUrl << "/forecast?id=" 
+            << query.cityId;
+    } else {
+        url << baseUrl << "/forecast?q=" 
+            << WeatherProvider::urlEncode(query.city);
+    }
+    url << "&appid=" << currentApiKey()
         << "&units=metric";
+    return url.str();
+}
+
+std::string WeatherService::cacheKey(const WeatherQuery& query) {
+    std::string key;
+    if (query.kind == WeatherQuery::Kind::COORDINATES) {
+        key = WeatherCache::coordinatesKey(query.latitude, query.longitude);
+    } else if (query.kind == WeatherQuery::Kind::CITY_ID) {
+        key = WeatherCache::idKey(query.cityId);
+    } else {
+        key = WeatherCache::cityKey(query.city);
+    }
+    if (!query.provider.empty()) {
+        key += '@';
+        key += query.provider;
+    }
+    return key;
+}
+
+bool WeatherService::canonicalize(WeatherQuery& query) const {
+    const Gazetteer* gazetteer = context_->gazetteer.get();
+    if (!gazetteer || !gazetteer->isLoaded() || query.kind == WeatherQuery::Kind::CITY_ID) {
+        return true;
+    }
     
-    std::string response = performRequest(url.str());
+    GazetteerCity city;
+    if (query.kind == WeatherQuery::Kind::CITY) {
+        // Every spelling of a known city shares one cache entry and one upstream request
+        if (!gazetteer->resolve(query.city, city)) {
+            return false;
+        }
+    } else if (!gazetteer->nearest(query.latitude, query.longitude, SNAP_DISTANCE_KM, city)) {
+        return true;
+    }
     
-    if (response.empty()) {
-        WeatherData data;
-        data.isValid = false;
+    // The city keeps its coordinates and name for providers that do not take IDs
+    WeatherQuery resolved = WeatherQuery::byId(city.id);
+    resolved.hasCoordinates = true;
+    resolved.latitude = city.latitude;
+    resolved.longitude = city.longitude;
+    resolved.city = std::move(city.name);
+    resolved.country = std::move(city.country);
+    resolved.provider = std::move(query.provider);
+    query = std::move(resolved);
+    return true;
+}
+
+bool WeatherService::answerFromCache(const WeatherQuery& query, const std::string& key, WeatherData& data) {
+    if (cache_->get(key, data)) {
+        return true;
+    }
+    
+    // Past the TTL: answer with the last result right away and refresh it in the background
+    if (revalidate_ && serveStale(key, data)) {
+        if (data.isStale) {
+            revalidate_(query);
+        }
+        return true;
+    }
+    return false;
+}
+
+WeatherData WeatherService::lookup(const WeatherQuery& query) {
+    WeatherQuery canonical = query;
+    WeatherData data;
+    if (!canonicalize(canonical)) {
         return data;
     }
     
-    try {
-        nlohmann::json json = nlohmann::json::parse(response);
-        return parseWeatherJson(json);
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing JSON response: " << e.what() << std::endl;
-        WeatherData data;
-        data.isValid = false;
+    // Cache hits are answered on the calling thread without touching the loop
+    std::string key = cacheKey(canonical);
+    if (answerFromCache(canonical, key, data)) {
         return data;
     }
+    
+    data = blockOn(fetchAsync(canonical, key));
+    if (!data.isValid) {
+        serveStale(key, data);
+    }
+    return data;
 }
 
-std::string WeatherService::formatWeatherReport(const WeatherData& data) {
+Task<WeatherData> WeatherService::lookupAsync(WeatherQuery query) {
+    WeatherData data;
+    if (!canonicalize(query)) {
+        co_return data;
+    }
+    
+    std::string key = cacheKey(query);
+    if (answerFromCache(query, key, data)) {
+        co_return data;
+    }
+    
+    Task<WeatherData> fetch = fetchAsync(query, key);
+    data = co_await fetch;
     if (!data.isValid) {
-        return "Error: Unable to retrieve weather data. Please check the city name or your API key.";
+        serveStale(key, data);
+    }
+    co_return data;
+}
+
+bool WeatherService::serveStale(const std::string& key, WeatherData& data) {
+    WeatherData stale;
+    if (!cache_->getStale(key, stale)) {
+        return false;
+    }
+    if (stale.isStale) {
+        context_->metrics->recordEvent(UpstreamEvent::STALE_SERVED);
     }
+    data = stale;
+    return true;
+}
+
+WeatherData WeatherService::refresh(const WeatherQuery& query) {
+    WeatherQuery canonical = query;
+    if (!canonicalize(canonical)) {
+        return WeatherData();
+    }
+    return blockOn(fetchAsync(canonical, cacheKey(canonical)));
+}
+
+Task<WeatherData> WeatherService::refreshAsync(WeatherQuery query) {
+    if (!canonicalize(query)) {
+        co_return WeatherData();
+    }
+    std::string key = cacheKey(query);
+    Task<WeatherData> fetch = fetchAsync(query, key);
+    co_return co_await fetch;
+}
+
+Task<WeatherData> WeatherService::fetchAsync(WeatherQuery query, std::string key) {
+    // The coalescer is only touched on the loop thread
+    co_await context_->loop->schedule();
     
-    std::ostringstream report;
-    report << "\n╔════════════════════════════════════════╗\n";
-    report << "║        WEATHER FORECAST REPORT        ║\n";
-    report << "╠════════════════════════════════════════╣\n";
-    report << "║ Location: " << std::left << std::setw(26) << (data.city + ", " + data.country) << "║\n";
-    report << "║ Condition: " << std::setw(25) << data.description << "║\n";
-    report << "║ Temperature: " << std::setw(23) << (std::to_string(static_cast<int>(data.temperature)) + "°C") << "║\n";
-    report << "║ Feels Like: " << std::setw(24) << (std::to_string(static_cast<int>(data.feelsLike)) + "°C") << "║\n";
-    report << "║ Humidity: " << std::setw(26) << (std::to_string(static_cast<int>(data.humidity)) + "%") << "║\n";
-    report << "║ Wind Speed: " << std::setw(23) << (std::to_string(static_cast<int>(data.windSpeed)) + " m/s") << "║\n";
-    report << "╚════════════════════════════════════════╝\n";
+    // Concurrent lookups for the same key share the leader's request
+    Task<WeatherData> flight = context_->coalescer->run(key, [this, query, key]() {
+        return fetchAndStore(query, key);
+    });
+    co_return co_await flight;
+}
+
+Task<WeatherData> WeatherService::fetchAndStore(WeatherQuery query, std::string key) {
+    ProviderRouter& router = *context_->providers;
+    Metrics& metrics = *context_->metrics;
+    std::vector<size_t> route = router.route(query);
+    WeatherData fetched;
+    size_t next = 0;
     
-    return report.str();
+    if (route.size() > 1 && router.isRacing()) {
+        ProviderRace race;
+        race.providers = {route[0], route[1]};
+        std::vector<Task<WeatherData>> entrants;
+        entrants.push_back(raceEntrant(query, race, 0));
+        entrants.push_back(raceEntrant(query, race, 1));
+        Task<std::vector<WeatherData>> both = whenAll(std::move(entrants));
+        std::vector<WeatherData> results = co_await both;
+        // Without spare quota the runner-up never went out, so it still gets its turn below
+        bool runnerUpSent = race.control[1].outcome != RequestOutcome::NOT_SENT;
+        if (race.winner >= 0) {
+            fetched = results[static_cast<size_t>(race.winner)];
+        }
+        if (runnerUpSent) {
+            metrics.recordEvent(UpstreamEvent::RACE);
+            if (race.winner >= 0) {
+                router.recordRaceWin(race.providers[static_cast<size_t>(race.winner)]);
+            }
+        }
+        next = runnerUpSent ? 2 : 1;
+    }
+    
+    // Fail over along the route until a provider answers
+    for (; next < route.size() && !fetched.isValid; ++next) {
+        if (next > 0) {
+            metrics.recordEvent(UpstreamEvent::FAILOVER);
+        }
+        RequestControl control;
+        Task<WeatherData> fetch = fetchFrom(route[next], query, control);
+        fetched = co_await fetch;
+    }
+    storeResult(key, fetched);
+    co_return fetched;
+}
+
+Task<WeatherData> WeatherService::raceEntrant(WeatherQuery query, ProviderRace& race, size_t lane) {
+    RequestControl& control = race.control[lane];
+    control.cancel = &race.cancel[lane];
+    // The runner-up is sent on spare quota only, like a hedge
+    control.spareQuotaOnly = lane > 0;
+    Task<WeatherData> fetch = fetchFrom(race.providers[lane], std::move(query), control);
+    WeatherData data = co_await fetch;
+    if (data.isValid && race.winner < 0) {
+        race.winner = static_cast<long>(lane);
+        race.cancel[1 - lane].cancel();
+    }
+    co_return data;
+}
+
+Task<WeatherData> WeatherService::fetchFrom(size_t provider, WeatherQuery query, RequestControl& control) {
+    ProviderRouter& router = *context_->providers;
+    const WeatherProvider& source = router.provider(provider);
+    RequestArena arena;
+    std::pmr::string response(arena.get());
+    Task<void> request = performRequestAsync(source.buildUrl(query, currentApiKey()), router.breaker(provider), response, &control);
+    co_await request;
+    
+    WeatherData data = parseResponse(source, response, query);
+    switch (control.outcome) {
+        case RequestOutcome::SUCCEEDED:
+            router.recordAnswer(provider, control.elapsed, data.isValid);
+            break;
+        case RequestOutcome::FAILED:
+            router.recordFailure(provider, control.elapsed);
+            break;
+        case RequestOutcome::CANCELLED:
+            router.recordAbandoned(provider, control.elapsed);
+            break;
+        case RequestOutcome::NOT_SENT:
+            break;
+    }
+    co_return data;
+}
+
+void WeatherService::storeResult(const std::string& key, const WeatherData& data) {
+    if (!data.isValid) {
+        return;
+    }
+    cache_->put(key, data);
+    if (context_->snapshot) {
+        context_->snapshot->append(key, data);
+    }
+    if (context_->history) {
+        context_->history->append(data);
+    }
 }
 
+WeatherData WeatherService::getWeatherByCity(const std::string& cityName) {
+    return lookup(WeatherQuery::byCity(cityName));
+}
+
+WeatherData WeatherService::getWeatherByCoordinates(double latitude, double longitude) {
+    return lookup(WeatherQuery::byCoordinates(latitude, longitude));
+}
+
+Task<WeatherData> WeatherService::getWeatherByCityAsync(std::string cityName) {
+    return lookupAsync(WeatherQuery::byCity(cityName));
+}
+
+Task<WeatherData> WeatherService::getWeatherByCoordinatesAsync(double latitude, double longitude) {
+    return lookupAsync(WeatherQuery::byCoordinates(latitude, longitude));
+}
+
+Task<WeatherData> WeatherService::getWeatherAsync(WeatherQuery query) {
+    return lookupAsync(std::move(query));
+}
+
+std::vector<WeatherData> WeatherService::getWeatherByIds(const std::vector<long>& cityIds) {
+    std::vector<WeatherData> results(cityIds.size());
+    
+    // Cached IDs are served directly; the rest are deduplicated and fetched in groups
+    std::unordered_map<long, std::vector<size_t>> pending;
+    std::vector<long> missing;
+    for (size_t i = 0; i < cityIds.size(); ++i) {
+        std::string key = WeatherCache::idKey(cityIds[i]);
+        if (cache_->get(key, results[i])) {
+            continue;
+        }
+        if (revalidate_ && serveStale(key, results[i])) {
+            if (results[i].isStale) {
+                revalidate_(WeatherQuery::byId(cityIds[i]));
+            }
+            continue;
+        }
+        auto& waiting = pending[cityIds[i]];
+        if (waiting.empty()) {
+            missing.push_back(cityIds[i]);
+        }
+        waiting.push_back(i);
+    }
+    
+    for (size_t start = 0; start < missing.size(); start += GROUP_MAX_IDS) {
+        std::vector<long> chunk(missing.begin() + start,
+                                missing.begin() + std::min(missing.size(), start + GROUP_MAX_IDS));
+        RequestArena arena;
+        std::pmr::string response(arena.get());
+        performRequest(buildGroupUrl(chunk), Endpoint::GROUP, response);
+        if (response.empty()) {
+            continue;
+        }
+        
+        std::vector<WeatherData> fetched;
+        {
+            StageTimer timer(*context_->metrics, Stage::PARSE);
+            fetched = WeatherJsonParser::parseGroup(response);
+        }
+        for (const WeatherData& data : fetched) {
+            auto found = pending.find(data.cityId);
+            if (!data.isValid || found == pending.end()) {
+                continue;
+            }
+            storeResult(WeatherCache::idKey(data.cityId), data);
+            for (size_t index : found->second) {
+                results[index] = data;
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < cityIds.size(); ++i) {
+        if (!results[i].isValid) {
+            serveStale(WeatherCache::idKey(cityIds[i]), results[i]);
+        }
+    }
+    
+    return results;
+}
+
+std::shared_ptr<const ForecastSeries> WeatherService::getForecast(const std::string& cityName) {
+    WeatherQuery query = WeatherQuery::byCity(cityName);
+    if (!canonicalize(query)) {
+        return nullptr;
+    }
+    
+    ForecastStore& forecasts = *context_->forecasts;
+    std::string key = cacheKey(query);
+    if (auto series = forecasts.get(key)) {
+        return series;
+    }
+    
+    RequestArena arena;
+    std::pmr::string response(arena.get());
+    performRequest(buildForecastUrl(query), Endpoint::FORECAST, response);
+    if (response.empty()) {
+        return nullptr;
+    }
+    
+    ForecastSeries parsed;
+    {
+        StageTimer timer(*context_->metrics, Stage::PARSE);
+        parsed = WeatherJsonParser::parseForecast(response, forecasts.getConditions());
+    }
+    if (!parsed.isValid) {
+        return nullptr;
+    }
+    
+    auto series = std::make_shared<const ForecastSeries>(std::move(parsed));
+    forecasts.put(key, series);
+    return series;
+}
+
+CURL* WeatherService::acquireHandle() {
+    // Reusing easy handles keeps their connections alive between batches
+    if (!handlePool_.empty()) {
+        CURL* handle = handlePool_.back();
+        handlePool_.pop_back();
+        return handle;
+    }
+    return curl_easy_init();
+}
+
+void WeatherService::releaseHandle(CURL* handle) {
+    handlePool_.push_back(handle);
+}
+
+std::vector<WeatherData> WeatherService::getWeatherBatch(const std::vector<WeatherQuery>& queries,
+                                                         const BatchCallback& onComplete) {
+    std::vector<WeatherData> results(queries.size());
+    ProviderRouter& router = *context_->providers;
+    // Response bodies live until the batch is done, so they share one arena
+    std::pmr::monotonic_buffer_resource arena;
+    std::vector<Transfer> transfers;
+    // Maps a cache key to the transfer fetching it, so duplicate queries share one request
+    std::unordered_map<std::string, size_t> inFlight;
+    std::vector<std::vector<size_t>> duplicates;
+    
+    for (size_t i = 0; i < queries.size(); ++i) {
+        WeatherQuery query = queries[i];
+        bool known = canonicalize(query);
+        std::string key = cacheKey(query);
+        bool answered = !known || cache_->get(key, results[i]);
+        if (!answered && revalidate_ && serveStale(key, results[i])) {
+            if (results[i].isStale) {
+                revalidate_(query);
+            }
+            answered = true;
+        }
+        if (answered) {
+            if (onComplete) {
+                onComplete(i, results[i]);
+            }
+            continue;
+        }
+        
+        auto found = inFlight.find(key);
+        if (found != inFlight.end()) {
+            duplicates[found->second].push_back(i);
+            continue;
+        }
+        
+        inFlight.emplace(key, transfers.size());
+        duplicates.emplace_back();
+        Transfer transfer(&arena);
+        transfer.index = i;
+        transfer.key = std::move(key);
+        transfer.route = router.route(query);
+        transfer.query = std::move(query);
+        transfers.push_back(std::move(transfer));
+    }
+    
+    if (transfers.empty()) {
+        return results;
+    }
+    
+    if (!ensureMulti()) {
+        return results;
+    }
+    Metrics& metrics = *context_->metrics;
+    // One config version serves the whole batch, even if another is published meanwhile
+    const RuntimeConfig& config = context_->config->get();
+    const RequestPolicy& policy = config.requestPolicy;
+    size_t maxConcurrency = std::max<size_t>(config.maxConcurrency, 1);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS, static_cast<long>(maxConcurrency));
+    
+    // Caches a finished transfer's result and reports it for every query that shares it
+    auto finish = [&](Transfer& transfer, WeatherData data) {
+        storeResult(transfer.key, data);
+        if (!data.isValid) {
+            serveStale(transfer.key, data);
+        }
+        
+        size_t slot = static_cast<size_t>(&transfer - transfers.data());
+        results[transfer.index] = data;
+        if (onComplete) {
+            onComplete(transfer.index, data);
+        }
+        for (size_t index : duplicates[slot]) {
+            results[index] = data;
+            if (onComplete) {
+                onComplete(index, data);
+            }
+        }
+    };
+    
+    // Transfers take rate limiter tokens in input order; a throttled one goes back to the front
+    RateLimiter& limiter = *context_->rateLimiter;
+    RateLimiter::Clock::time_point queueDeadline = limiter.queueDeadline(priority_, RateLimiter::Clock::now());
+    std::deque<size_t> waiting;
+    for (size_t slot = 0; slot < transfers.size(); ++slot) {
+        waiting.push_back(slot);
+    }
+    size_t active = 0;
+    int running = 0;
+    
+    // Hands a lookup its route's next provider could not answer to the one after it;
+    // false once the route is used up
+    auto failOver = [&](Transfer& transfer) {
+        if (transfer.hop + 1 >= transfer.route.size()) {
+            return false;
+        }
+        ++transfer.hop;
+        transfer.attempts = 0;
+        metrics.recordEvent(UpstreamEvent::FAILOVER);
+        waiting.push_back(static_cast<size_t>(&transfer - transfers.data()));
+        return true;
+    };
+    
+    while (!waiting.empty() || active > 0) {
+        bool outOfTokens = false;
+        while (active < maxConcurrency && !waiting.empty()) {
+            Transfer& transfer = transfers[waiting.front()];
+            if (transfer.route.empty()) {
+                // No provider can answer this query (e.g. a provider that needs coordinates)
+                waiting.pop_front();
+                finish(transfer, WeatherData());
+                continue;
+            }
+            if (!limiter.tryAcquire(priority_)) {
+                outOfTokens = true;
+                break;
+            }
+            waiting.pop_front();
+            size_t provider = transfer.route[transfer.hop];
+            transfer.handle = acquireHandle();
+            if (!transfer.handle) {
+                std::cerr << "Error: Failed to initialize CURL" << std::endl;
+                limiter.release();
+                finish(transfer, WeatherData());
+                continue;
+            }
+            if (!router.breaker(provider).allowRequest()) {
+                metrics.recordEvent(UpstreamEvent::BREAKER_REJECTED);
+                limiter.release();
+                releaseHandle(transfer.handle);
+                transfer.handle = nullptr;
+                if (!failOver(transfer)) {
+                    finish(transfer, WeatherData());
+                }
+                continue;
+            }
+            ++transfer.attempts;
+            transfer.response.clear();
+            transfer.url = router.provider(provider).buildUrl(transfer.query, currentApiKey());
+            transfer.started = EventLoop::Clock::now();
+            configureHandle(transfer.handle, transfer.url, &transfer.response, policy.attemptTimeout);
+            curl_easy_setopt(transfer.handle, CURLOPT_PRIVATE, &transfer);
+            curl_multi_add_handle(multi_, transfer.handle);
+            ++active;
+        }
+        
+        // Lookups still without a token after the priority's queue limit fail, falling back to stale results
+        if (outOfTokens && RateLimiter::Clock::now() >= queueDeadline) {
+            for (size_t slot : waiting) {
+                metrics.recordEvent(UpstreamEvent::RATE_LIMITED);
+                finish(transfers[slot], WeatherData());
+            }
+            waiting.clear();
+            outOfTokens = false;
+        }
+        
+        CURLMcode mc = curl_multi_perform(multi_, &running);
+        if (mc != CURLM_OK) {
+            std::cerr << "CURL multi error: " << curl_multi_strerror(mc) << std::endl;
+            break;
+        }
+        
+        CURLMsg* msg;
+        int remaining;
+        while ((msg = curl_multi_info_read(multi_, &remaining))) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            
+            // msg is invalidated by curl_multi_remove_handle, so read it first
+            CURL* handle = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            Transfer* transfer = nullptr;
+            long status = 0;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, &transfer);
+            curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
+            metrics.recordTransfer(handle, result);
+            bool throttled = result == CURLE_OK && status == HTTP_TOO_MANY_REQUESTS;
+            if (throttled) {
+                limiter.onThrottled(retryAfter(handle));
+                metrics.recordEvent(UpstreamEvent::THROTTLED);
+            }
+            curl_multi_remove_handle(multi_, handle);
+            releaseHandle(transfer->handle);
+            transfer->handle = nullptr;
+            --active;
+            size_t provider = transfer->route[transfer->hop];
+            CircuitBreaker& breaker = router.breaker(provider);
+            auto elapsed = EventLoop::Clock::now() - transfer->started;
+            
+            // A 429 means the endpoint is up; the lookup waits for another token after the pause
+            if (throttled && transfer->attempts < policy.maxAttempts) {
+                breaker.recordSuccess();
+                metrics.recordEvent(UpstreamEvent::RETRY);
+                waiting.push_front(static_cast<size_t>(transfer - transfers.data()));
+                continue;
+            }
+            
+            WeatherData data;
+            if (result == CURLE_OK && status < 500 && !throttled) {
+                breaker.recordSuccess();
+                limiter.onSuccess();
+                data = parseResponse(router.provider(provider), transfer->response, transfer->query);
+                router.recordAnswer(provider, elapsed, data.isValid);
+            } else {
+                if (throttled) {
+                    breaker.recordSuccess();
+                } else {
+                    breaker.recordFailure();
+                }
+                router.recordFailure(provider, elapsed);
+                if (result != CURLE_OK) {
+                    std::cerr << "CURL error: " << curl_easy_strerror(result) << std::endl;
+                } else {
+                    std::cerr << "Upstream error: HTTP " << status << std::endl;
+                }
+            }
+            if (!data.isValid && failOver(*transfer)) {
+                continue;
+            }
+            finish(*transfer, data);
+        }
+        
+        if (active > 0 || outOfTokens) {
+            // With no transfer to wake it, the poll just sleeps until the next token is due
+            long long waitMs = 1000;
+            if (outOfTokens) {
+                auto untilToken = std::chrono::ceil<std::chrono::milliseconds>(limiter.nextAvailableIn(priority_));
+                waitMs = std::clamp<long long>(untilToken.count(), 1, 1000);
+            }
+            curl_multi_poll(multi_, nullptr, 0, static_cast<int>(waitMs), nullptr);
+        }
+    }
+    
+    // Only reached early on a multi error; fail whatever was in flight or never
+    // started so every query still gets its callback
+    for (Transfer& transfer : transfers) {
+        if (transfer.handle) {
+            curl_multi_remove_handle(multi_, transfer.handle);
+            releaseHandle(transfer.handle);
+            transfer.handle = nullptr;
+            finish(transfer, WeatherData());
+        }
+    }
+    for (size_t slot : waiting) {
+        finish(transfers[slot], WeatherData());
+    }
+    
+    return results;
+}
+
+std::string WeatherService::formatWeatherReport(const WeatherData& data) {
+    std::string report;
+    formatWeatherReport(data, report);
+    return report;
+}
+
+void WeatherService::formatWeatherReport(const WeatherData& data, std::string& out) {
+    StageTimer timer(*context_->metrics, Stage::FORMAT);
+    ReportRenderer::render(context_->reportStyle, data, out);
+}
+
+std::string WeatherService::formatForecast(const ForecastSeries& series, int hours) {
+    if (!series.isValid || series.size() == 0) {
+        return "Error: No forecast data available.";
+    }
+    
+    StageTimer timer(*context_->metrics, Stage::FORMAT);
+    ConditionTable& conditions = context_->forecasts->getConditions();
+    
+    // The window starts at the first forecast slot that has not fully passed
+    int64_t now = static_cast<int64_t>(std::time(nullptr));
+    auto first = std::upper_bound(series.time.begin(), series.time.end(), now - 3 * 3600);
+    int64_t from = first != series.time.end() ? *first : series.time.back();
+    int64_t to = from + static_cast<int64_t>(hours) * 3600;
+    ForecastSummary summary = ForecastStore::summarize(series, from, to);
+    
+    std::string report;
+    report += "\n╔";
+    report += SUMMARY_BOX_BORDER;
+    report += "╗\n";
+    appendBoxRow(report, "Forecast: " + series.city + ", " + series.country + " (next " + std::to_string(hours) + "h)");
+    report += "╠";
+    report += SUMMARY_BOX_BORDER;
+    report += "╣\n";
+    
+    for (size_t i = 0; i < series.size(); ++i) {
+        if (series.time[i] < from || series.time[i] >= to) {
+            continue;
+        }
+        // Times are shown in the location's own timezone
+        std::time_t local = static_cast<std::time_t>(series.time[i] + series.timezoneOffset);
+        std::tm parts{};
+#ifdef _WIN32
+        gmtime_s(&parts, &local);
+#else
+        gmtime_r(&local, &parts);
+#endif
+        char when[16];
+        std::strftime(when, sizeof(when), "%a %H:%M", &parts);
+        
+        std::ostringstream line;
+        line << when << "  " << std::right << std::setw(4) << static_cast<int>(series.temperature[i]) << "°C"
+             << std::setw(5) << static_cast<int>(series.humidity[i]) << "%"
+             << std::setw(4) << static_cast<int>(series.windSpeed[i]) << " m/s  "
+             << conditions.describe(series.condition[i]);
+        appendBoxRow(report, line.str());
+    }
+    
+    report += "╠";
+    report += SUMMARY_BOX_BORDER;
+    report += "╣\n";
+    std::ostringstream temperature;
+    temperature << std::fixed << std::setprecision(1) << "Min/Max/Avg: " << summary.minTemperature << " / "
+                << summary.maxTemperature << " / " << summary.avgTemperature << "°C";
+    appendBoxRow(report, temperature.str());
+    appendBoxRow(report, "Humidity:    avg " + std::to_string(static_cast<int>(summary.avgHumidity)) + "%");
+    appendBoxRow(report, "Wind:        max " + std::to_string(static_cast<int>(summary.maxWindSpeed)) + " m/s");
+    appendBoxRow(report, "Mostly:      " + conditions.describe(summary.dominantCondition));
+    report += "╚";
+    report += SUMMARY_BOX_BORDER;
+    report += "╝\n";
+    
+    return report;
+}
+
+std::string WeatherService::formatHistory(const std::string& title, const HistorySummary& summary) {
+    StageTimer timer(*context_->metrics, Stage::FORMAT);
+    
+    auto formatTime = [](int64_t time) {
+        std::time_t utc = static_cast<std::time_t>(time);
+        std::tm parts{};
+#ifdef _WIN32
+        gmtime_s(&parts, &utc);
+#else
+        gmtime_r(&utc, &parts);
+#endif
+        char when[32];
+        std::strftime(when, sizeof(when), "%a %d %b %H:%M UTC", &parts);
+        return std::string(when);
+    };
+    auto formatRange = [&summary](const char* label, const HistoryRange& range, const char* unit) {
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(1) << label << range.min << " / " << range.max << " / "
+             << range.mean(summary.count) << unit;
+        return text.str();
+    };
+    
+    std::string report;
+    report += "\n╔";
+    report += SUMMARY_BOX_BORDER;
+    report += "╗\n";
+    appendBoxRow(report, "History:   " + title);
+    report += "╠";
+    report += SUMMARY_BOX_BORDER;
+    report += "╣\n";
+    appendBoxRow(report, "Samples:     " + std::to_string(summary.count));
+    if (summary.count > 0) {
+        appendBoxRow(report, "From:        " + formatTime(summary.firstTime));
+        appendBoxRow(report, "To:          " + formatTime(summary.lastTime));
+        report += "╠";
+        report += SUMMARY_BOX_BORDER;
+        report += "╣\n";
+        appendBoxRow(report, "Min/Max/Avg");
+        appendBoxRow(report, formatRange("Temperature: ", summary.temperature, "°C"));
+        appendBoxRow(report, formatRange("Humidity:    ", summary.humidity, "%"));
+        appendBoxRow(report, formatRange("Wind:        ", summary.windSpeed, " m/s"));
+    }
+    appendBoxRow(report, "Blocks:      " + std::to_string(summary.blocksRead) + " read, " +
+                         std::to_string(summary.blocksSkipped) + " skipped");
+    report += "╚";
+    report += SUMMARY_BOX_BORDER;
+    report += "╝\n";
+    
+    return report;
+}
@@ -1,9 +1,35 @@
 #include "WeatherBot.h"
+#include "WeatherServer.h"
+#include "BatchRunner.h"
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <csignal>
+#include <algorithm>
 
-std::string getApiKey() {
+namespace {
+WeatherServer* activeServer = nullptr;
+
+void handleShutdownSignal(int) {
+    if (activeServer) {
+        activeServer->stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [--config <path>] [--snapshot <path> | --no-snapshot]"
+              << " [--gazetteer <path> | --no-gazetteer] [--history <dir> | --no-history]"
+              << " [--rate-limit <per-minute>] [--daily-quota <n>]"
+              << " [--providers <name[=url]>,...] [--race] [--report box|compact|json]"
+              << " [--http-version auto|1.1] [--no-warmup] [--alert-log <path>]"
+              << " [--server [--host <addr>] [--port <n>] [--socket <path>] [--workers <n>]]" << std::endl;
+    std::cout << "       " << program << " --batch <file|-> [--output <path>] [--format ndjson|csv]"
+              << " [--order completion|input] [--parallel <n>]" << std::endl;
+    std::cout << "       " << program << " --build-gazetteer <cities.tsv> <output>" << std::endl;
+}
+}
+
+std::string getApiKey(bool interactive) {
     // Try to read from file first
     std::ifstream file("api_key.txt");
     if (file.is_open()) {
@@ -17,6 +43,9 @@ std::string getApiKey() {
     
     // If not found in file, prompt user
     std::string apiKey;
+    if (!interactive) {
+        return apiKey;
+    }
     std::cout << "Please enter your OpenWeatherMap API key: ";
     std::getline(std::cin, apiKey);
     
@@ -32,19 +61,232 @@ std::string getApiKey() {
     return apiKey;
 }
 
-int main() {
-    std::cout << "Initializing Weather Bot..." << std::endl;
-    
-    std::string apiKey = getApiKey();
+int main(int argc, char* argv[]) {
+    bool serverMode = false;
+    WeatherServerConfig serverConfig;
+    bool batchMode = false;
+    BatchConfig batchConfig;
+    std::string snapshotPath = "weather_cache.snap";
+    std::string gazetteerPath = "gazetteer.bin";
+    std::string historyPath = "weather_history";
+    std::string configPath = "weatherbot.conf";
+    std::string alertLogPath;
+    bool gazetteerRequired = false;
+    bool configRequired = false;
+    RateLimitConfig rateLimit;
+    std::string providerList;
+    ProviderRoutingConfig routing;
+    ReportStyle reportStyle = ReportStyle::BOX;
+    ConnectionConfig connectionConfig;
     
-    if (apiKey.empty()) {
-        std::cerr << "Error: API key is required to use the weather service." << std::endl;
-        std::cerr << "Please get your free API key from: https://openweathermap.org/api" << std::endl;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            
+            if (arg == "--server") {
+                serverMode = true;
+            } else if (arg == "--host" && hasValue) {
+                serverConfig.host = argv[++i];
+            } else if (arg == "--port" && hasValue) {
+                serverConfig.port = std::stoi(argv[++i]);
+            } else if (arg == "--socket" && hasValue) {
+                serverConfig.unixSocketPath = argv[++i];
+            } else if (arg == "--config" && hasValue) {
+                configPath = argv[++i];
+                configRequired = true;
+            } else if (arg == "--snapshot" && hasValue) {
+                snapshotPath = argv[++i];
+            } else if (arg == "--no-snapshot") {
+                snapshotPath.clear();
+            } else if (arg == "--gazetteer" && hasValue) {
+                gazetteerPath = argv[++i];
+                gazetteerRequired = true;
+            } else if (arg == "--no-gazetteer") {
+                gazetteerPath.clear();
+            } else if (arg == "--history" && hasValue) {
+                historyPath = argv[++i];
+            } else if (arg == "--no-history") {
+                historyPath.clear();
+            } else if (arg == "--build-gazetteer" && i + 2 < argc) {
+                std::string tsvPath = argv[i + 1];
+                std::string outputPath = argv[i + 2];
+                return Gazetteer::compile(tsvPath, outputPath) ? 0 : 1;
+            } else if (arg == "--rate-limit" && hasValue) {
+                rateLimit.requestsPerMinute = std::stod(argv[++i]);
+            } else if (arg == "--daily-quota" && hasValue) {
+                rateLimit.requestsPerDay = std::stoull(argv[++i]);
+            } else if (arg == "--providers" && hasValue) {
+                providerList = argv[++i];
+            } else if (arg == "--race") {
+                routing.race = true;
+            } else if (arg == "--report" && hasValue && (std::string(argv[i + 1]) == "box" || std::string(argv[i + 1]) == "compact" ||
+                                                          std::string(argv[i + 1]) == "json")) {
+                std::string style = argv[++i];
+                reportStyle = style == "json" ? ReportStyle::JSON : style == "compact" ? ReportStyle::COMPACT : ReportStyle::BOX;
+            } else if (arg == "--http-version" && hasValue && (std::string(argv[i + 1]) == "auto" || std::string(argv[i + 1]) == "1.1")) {
+                connectionConfig.httpVersion = std::string(argv[++i]) == "1.1" ? HttpVersion::HTTP1 : HttpVersion::AUTO;
+            } else if (arg == "--no-warmup") {
+                connectionConfig.warmup = false;
+            } else if (arg == "--alert-log" && hasValue) {
+                alertLogPath = argv[++i];
+            } else if (arg == "--workers" && hasValue) {
+                serverConfig.workerCount = static_cast<size_t>(std::stoul(argv[++i]));
+            } else if (arg == "--batch" && hasValue) {
+                batchMode = true;
+                batchConfig.inputPath = argv[++i];
+            } else if (arg == "--output" && hasValue) {
+                batchConfig.outputPath = argv[++i];
+            } else if (arg == "--format" && hasValue && (std::string(argv[i + 1]) == "ndjson" || std::string(argv[i + 1]) == "csv")) {
+                batchConfig.format = std::string(argv[++i]) == "csv" ? BatchFormat::CSV : BatchFormat::NDJSON;
+            } else if (arg == "--order" && hasValue && (std::string(argv[i + 1]) == "completion" || std::string(argv[i + 1]) == "input")) {
+                batchConfig.order = std::string(argv[++i]) == "input" ? BatchOrder::INPUT : BatchOrder::COMPLETION;
+            } else if (arg == "--parallel" && hasValue) {
+                batchConfig.parallelism = static_cast<size_t>(std::stoul(argv[++i]));
+            } else {
+                printUsage(argv[0]);
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
         return 1;
     }
     
+    // Batch results go to stdout, so progress messages go to stderr there
+    std::ostream& log = batchMode ? std::cerr : std::cout;
+    log << "Initializing Weather Bot..." << std::endl;
+    
     try {
-        WeatherBot bot(apiKey);
+        auto context = std::make_shared<WeatherServiceContext>();
+        // The config file, read next, overrides these, so everything it sets can be retuned at runtime
+        context->config->setDefaults([&](RuntimeConfig& config) { config.rateLimit = rateLimit; });
+        context->reportStyle = reportStyle;
+        context->connections = std::make_shared<ConnectionManager>(connectionConfig);
+        // The default path is optional; an explicitly requested config file must load
+        if (configRequired || std::ifstream(configPath).good()) {
+            if (!context->config->load(configPath)) {
+                return 1;
+            }
+            context->config->watch(*context->loop);
+            log << "Loaded settings from " << configPath << " (reloaded on change)" << std::endl;
+        }
+        
+        std::string apiKey = context->config->get().apiKey;
+        if (apiKey.empty()) {
+            apiKey = getApiKey(!batchMode);
+        }
+        if (apiKey.empty()) {
+            std::cerr << "Error: API key is required to use the weather service." << std::endl;
+            if (batchMode) {
+                std::cerr << "Batch mode does not prompt for it; put it in api_key.txt or the config file." << std::endl;
+            }
+            std::cerr << "Please get your free API key from: https://openweathermap.org/api" << std::endl;
+            return 1;
+        }
+        
+        if (routing.race && providerList.empty()) {
+            // Racing needs a second provider; Open-Meteo needs no key
+            providerList = "openweathermap,open-meteo";
+        }
+        if (!providerList.empty()) {
+            // Listed in order of preference, each optionally with its own base URL
+            auto router = std::make_shared<ProviderRouter>(routing);
+            size_t start = 0;
+            while (start <= providerList.size()) {
+                size_t comma = std::min(providerList.find(',', start), providerList.size());
+                std::string entry = providerList.substr(start, comma - start);
+                start = comma + 1;
+                if (entry.empty()) {
+                    continue;
+                }
+                size_t equals = entry.find('=');
+                std::string name = entry.substr(0, equals);
+                std::string url = equals == std::string::npos ? "" : entry.substr(equals + 1);
+                std::shared_ptr<WeatherProvider> provider = WeatherProvider::create(name, url);
+                if (!provider) {
+                    std::cerr << "Error: Unknown weather provider " << name << " (known: openweathermap, open-meteo)" << std::endl;
+                    return 1;
+                }
+                std::shared_ptr<CircuitBreaker> breaker;
+                if (OpenWeatherMapProvider().matches(name)) {
+                    // Group and forecast requests go to the same service
+                    breaker = context->breakers[static_cast<size_t>(Endpoint::WEATHER)];
+                    if (!url.empty()) {
+                        context->config->setDefaults([&](RuntimeConfig& config) { config.baseUrl = url; });
+                    }
+                    // A base_url in the config file wins, and moves the provider when it changes
+                    provider->setBaseUrl(context->config->get().baseUrl);
+                }
+                router->add(provider, breaker);
+            }
+            if (router->size() == 0) {
+                std::cerr << "Error: --providers lists no provider" << std::endl;
+                return 1;
+            }
+            context->providers = router;
+        }
+        // Connects to every upstream in the background while the rest starts up
+        std::vector<std::string> upstreams = {context->config->get().baseUrl};
+        for (size_t i = 0; context->providers && i < context->providers->size(); ++i) {
+            upstreams.push_back(context->providers->provider(i).getBaseUrl());
+        }
+        context->connections->start(*context->loop, upstreams);
+        if (!snapshotPath.empty()) {
+            // Warm the cache from the previous run before serving anything
+            context->snapshot = std::make_shared<SnapshotStore>(snapshotPath, context->cache->getConfig().ttl);
+            size_t restored = context->snapshot->loadInto(*context->cache);
+            if (restored > 0) {
+                log << "Restored " << restored << " cached results from " << snapshotPath << std::endl;
+            }
+        }
+        if (!historyPath.empty()) {
+            // Every fetched observation is logged; open blocks are written on exit
+            auto history = std::make_shared<HistoryStore>(historyPath);
+            if (history->open()) {
+                context->history = history;
+            }
+        }
+        if (!alertLogPath.empty()) {
+            // Every alert raised in the background, one JSON line each, for other processes to pick up
+            auto alertLog = std::make_shared<FileAlertSink>(alertLogPath);
+            if (!alertLog->isOpen()) {
+                return 1;
+            }
+            context->dispatcher->addSubscriber("alert-log", alertLog);
+            context->dispatcher->subscribeAll("alert-log");
+        }
+        if (!gazetteerPath.empty()) {
+            // The default path is optional; an explicitly requested gazetteer must load
+            auto gazetteer = std::make_shared<Gazetteer>();
+            if (gazetteer->open(gazetteerPath)) {
+                context->gazetteer = gazetteer;
+                log << "Loaded " << gazetteer->size() << " known cities from " << gazetteerPath << std::endl;
+            } else if (gazetteerRequired) {
+                std::cerr << "Error: Cannot load gazetteer " << gazetteerPath << std::endl;
+                return 1;
+            }
+        }
+        
+        if (serverMode) {
+            WeatherServer server(apiKey, serverConfig, context);
+            if (!server.start()) {
+                return 1;
+            }
+            activeServer = &server;
+            std::signal(SIGINT, handleShutdownSignal);
+            std::signal(SIGTERM, handleShutdownSignal);
+            server.run();
+            activeServer = nullptr;
+            return 0;
+        }
+        
+        if (batchMode) {
+            BatchRunner runner(apiKey, batchConfig, context);
+            return runner.run();
+        }
+        
+        WeatherBot bot(apiKey, context);
         bot.start();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;